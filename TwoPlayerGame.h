@@ -23,4 +23,11 @@
 
 #include "TwoPlayerGame_base_radio.h"
 #include "TwoPlayerGame_base_packet.h"
+#include "TwoPlayerGame_link_policy.h"
+#include "TwoPlayerGame_idle_policy.h"
+#include "TwoPlayerGame_zobrist_hash.h"
+#include "TwoPlayerGame_bitboard.h"
+#include "TwoPlayerGame_search.h"
+#include "TwoPlayerGame_base_store.h"
+#include "TwoPlayerGame_base_journal.h"
 #include "TwoPlayerGame_base_game.h"
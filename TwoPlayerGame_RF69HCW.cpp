@@ -12,13 +12,55 @@
 #include "TwoPlayerGame_RF69HCW.h"
 
 //Create the driver object
-RH_RF69 rf69(RFM69_CS, RFM69_INT);
+RF69Driver rf69(RFM69_CS, RFM69_INT);
 
 // Object to manage packet delivery and receipt, using the driver declared above
-RHReliableDatagram rf69_manager(rf69);
+RF69Manager rf69_manager(rf69);
+
+//Modulation settings we support, fastest first. The first is the RadioHead default.
+const RH_RF69::ModemConfigChoice RF69Modulations[]= {
+  RH_RF69::GFSK_Rb250Fd250, RH_RF69::GFSK_Rb125Fd125, RH_RF69::GFSK_Rb57_6Fd120,
+  RH_RF69::GFSK_Rb19_2Fd38_4, RH_RF69::GFSK_Rb9_6Fd19_2
+};
+const char* RF69ModulationNames[]= {
+  "GFSK 250kbps", "GFSK 125kbps", "GFSK 57.6kbps", "GFSK 19.2kbps", "GFSK 9.6kbps"
+};
+#define RF69_MODULATIONS (sizeof(RF69Modulations)/sizeof(RF69Modulations[0]))
+
+//Transmit power levels in dBm, strongest first. The first is what setup uses.
+const int8_t RF69PowerLevels[]= {20, 14, 8, 2};
+#define RF69_POWER_LEVELS (sizeof(RF69PowerLevels)/sizeof(RF69PowerLevels[0]))
+
+/*
+ * Called from our interrupt handler after RadioHead's own handling. If it left a packet in its
+ * buffer we copy it into the ring with its header and RSSI and start listening again right away.
+ * Acknowledgments stay where they are for "sendtoWait" to find.
+ */
+void RF69Driver::drain(void) {
+  handleInterrupt();
+  if(!_rxBufValid || (_rxHeaderFlags & RH_FLAGS_ACK)) {
+    return;
+  }
+  uint8_t entry[RH_RF69_MAX_MESSAGE_LEN+RF69_RING_HEADER];
+  entry[0]=_rxHeaderFrom;
+  entry[1]=_rxHeaderTo;
+  entry[2]=_rxHeaderId;
+  entry[3]=_rxHeaderFlags;
+  entry[4]=(uint8_t)(int8_t)_lastRssi;
+  memcpy(entry+RF69_RING_HEADER,_buf,_bufLen);
+  Ring.push(entry,_bufLen+RF69_RING_HEADER);
+  _rxBufValid=false;
+  setModeRx();
+}
+
+/*
+ * Replaces the interrupt handler that RadioHead attached during init.
+ */
+static void rf69Interrupt(void) {
+  rf69.drain();
+}
 
 /*
- * There is only one non-inline method in this class. 
  * This is called one time by baseGame::setup from your main program setup() function.
  * It is passed the player number for you and your opponent. These player numbers are used as
  * device addresses. Returns true if radio was successfully initialized.
@@ -26,6 +68,7 @@ RHReliableDatagram rf69_manager(rf69);
 bool RF69Radio::setup(uint8_t myD,uint8_t otherD) {
   myPlayerNum=myD;
   otherPlayerNum=otherD;
+  seenId=-1;
   rf69_manager.setThisAddress(myPlayerNum);
   pinMode(RFM69_RST, OUTPUT);
   digitalWrite(RFM69_RST, LOW);
@@ -38,6 +81,7 @@ bool RF69Radio::setup(uint8_t myD,uint8_t otherD) {
     //RFM69 radio init failed
     return false;
   }
+  attachInterrupt(digitalPinToInterrupt(RFM69_INT), rf69Interrupt, RISING);
   // Defaults after init are 434.0MHz, modulation GFSK_Rb250Fd250, +13dbM (for low power module)
   // No encryption
   if (!rf69.setFrequency(RF69_FREQ)) {
@@ -46,10 +90,147 @@ bool RF69Radio::setup(uint8_t myD,uint8_t otherD) {
   }
   // If you are using a high power RF69 eg RFM69HCW, you *must* set a Tx power with the
   // ishighpowermodule flag set like this:
-  rf69.setTxPower(20, true);  // range from 14-20 for power, 2nd arg must be true for 69HCW
+  rf69.setTxPower(RF69PowerLevels[0], true);  // range from 14-20 for power, 2nd arg must be true for 69HCW
   // The encryption key has to be the same as the one in the server
   uint8_t key[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
                     0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
   rf69.setEncryptionKey(key);
   return  true;
 }
+
+/*
+ * Sends a packet and waits for the acknowledgment. RadioHead keeps a running total of
+ * retransmissions so the change in that total is how many retries this packet took.
+ */
+bool RF69Radio::send(uint8_t* packet_ptr,uint8_t len) {
+  uint32_t retransmissions=rf69_manager.retransmissions();
+  uint32_t StartTime=micros();
+  bool acked= rf69_manager.sendtoWait(packet_ptr,len, otherPlayerNum);
+  Stats.countSend(len,micros()-StartTime,acked);
+  Stats.countRetries(rf69_manager.retransmissions()-retransmissions);
+  return acked;
+}
+
+/*
+ * Sends a packet without asking for an acknowledgment. We mark it with RF69_NO_ACK_FLAG so that
+ * the other device knows not to acknowledge it, then clear the flag again so that it doesn't
+ * end up on packets sent by "send". Returns true once the packet has been transmitted.
+ */
+bool RF69Radio::sendNoAck(uint8_t* packet_ptr,uint8_t len) {
+  return sendNoAckTo(packet_ptr,len,otherPlayerNum);
+}
+
+/*
+ * Sends a packet without an acknowledgment to every device in range. Receivers never acknowledge
+ * broadcasts but we mark it anyway so that it is treated exactly like any other sendNoAck packet.
+ */
+bool RF69Radio::broadcast(uint8_t* packet_ptr,uint8_t len) {
+  return sendNoAckTo(packet_ptr,len,RH_BROADCAST_ADDRESS);
+}
+
+bool RF69Radio::sendNoAckTo(uint8_t* packet_ptr,uint8_t len,uint8_t to) {
+  rf69_manager.setHeaderFlags(RF69_NO_ACK_FLAG, RH_FLAGS_NONE);
+  bool sent= rf69_manager.sendto(packet_ptr,len, to) && rf69_manager.waitPacketSent();
+  rf69_manager.setHeaderFlags(RH_FLAGS_NONE, RF69_NO_ACK_FLAG);
+  Stats.countSendNoAck(len);
+  return sent;
+}
+
+/*
+ * Changes addresses after setup. RadioHead filters incoming packets by our address so packets
+ * meant for the other player number are never seen. We forget the last header ID we saw because
+ * a new partner numbers its packets independently.
+ */
+bool RF69Radio::setAddresses(uint8_t myD, uint8_t otherD) {
+  myPlayerNum=myD;
+  otherPlayerNum=otherD;
+  seenId=-1;
+  rf69_manager.setThisAddress(myPlayerNum);
+  return true;
+}
+
+/*
+ * Receives a packet if one is available. We look in the ring first and then in RadioHead's own
+ * buffer which only holds something the interrupt left there. Stray acknowledgments are thrown 
+ * away. Packets that were sent with "send" are acknowledged and if we have already seen one with 
+ * the same header ID, it is a repeat caused by a lost acknowledgment so it is thrown away too. 
+ */
+bool RF69Radio::recv(uint8_t* packet_ptr,uint8_t* len_ptr) {
+  uint8_t from, to, id, flags;
+  int16_t rssi;
+  uint8_t entry[RH_RF69_MAX_MESSAGE_LEN+RF69_RING_HEADER];
+  uint8_t len=sizeof(entry);
+  if(rf69.Ring.pop(entry,&len)) {
+    from=entry[0]; to=entry[1]; id=entry[2]; flags=entry[3];
+    rssi=(int8_t)entry[4];
+    len-=RF69_RING_HEADER;
+    if(*len_ptr > len) {
+      *len_ptr=len;
+    }
+    memcpy(packet_ptr,entry+RF69_RING_HEADER,*len_ptr);
+  } else {
+    if(!rf69_manager.recvfrom(packet_ptr,len_ptr,&from,&to,&id,&flags)) {
+      return false;
+    }
+    rssi=rf69.lastRssi();
+  }
+  if(flags & RH_FLAGS_ACK) {
+    return false;   //an acknowledgment that arrived too late to matter
+  }
+  if((to==myPlayerNum) && !(flags & RF69_NO_ACK_FLAG)) {
+    rf69_manager.ack(id,from);
+    if(id==seenId) {
+      return false;   //a repeat of something we already have
+    }
+    seenId=id;
+  }
+  Stats.countReceive(*len_ptr);
+  Stats.countRssi(rssi);
+  return true;
+}
+
+/*
+ * Waits up to "timeout" milliseconds for a packet. We can't use RadioHead's "waitAvailableTimeout"
+ * because it doesn't know about the ring.
+ */
+bool RF69Radio::recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout) {
+  uint32_t StartTime=millis();
+  uint8_t size=*len_ptr;
+  while((millis()-StartTime) < timeout) {
+    *len_ptr=size;
+    if(recv(packet_ptr,len_ptr)) {
+      Stats.countBlocked(StartTime);
+      return true;
+    }
+    yield();
+  }
+  Stats.countBlocked(StartTime);
+  return false;
+}
+
+uint8_t RF69Radio::modulations(void) {
+  return RF69_MODULATIONS;
+}
+
+bool RF69Radio::setModulation(uint8_t m) {
+  if(m>=RF69_MODULATIONS) {
+    return false;
+  }
+  return rf69.setModemConfig(RF69Modulations[m]);
+}
+
+const char* RF69Radio::modulationName(uint8_t m) {
+  return (m<RF69_MODULATIONS) ? RF69ModulationNames[m] : "";
+}
+
+uint8_t RF69Radio::powerLevels(void) {
+  return RF69_POWER_LEVELS;
+}
+
+bool RF69Radio::setPowerLevel(uint8_t p) {
+  if(p>=RF69_POWER_LEVELS) {
+    return false;
+  }
+  rf69.setTxPower(RF69PowerLevels[p], true);
+  return true;
+}
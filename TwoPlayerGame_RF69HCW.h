@@ -16,6 +16,22 @@
  * signals in a way that is completely transparent to us. We just tell it the start address and 
  * length of data and it handles everything else. 
  * 
+ * Packets sent with "sendNoAck" carry RF69_NO_ACK_FLAG in their RadioHead header flags. Because of 
+ * that we receive using the unacknowledged "recvfrom" and send the acknowledgment ourselves only when 
+ * the flag is clear. We also throw away repeats of acknowledged packets the same way RadioHead does.
+ * Broadcasts go to RH_BROADCAST_ADDRESS which every RF69HCW receives whatever its own address.
+ * 
+ * RadioHead only has room for one received packet and it stops listening until the main loop
+ * asks for it. The main loop is often busy playing a sound or waiting in a delay so packets
+ * that arrive then would be lost and have to be sent again. Instead we replace the RadioHead
+ * interrupt handler with our own. It still lets RadioHead do its normal work but then it
+ * immediately copies any received packet into a lock-free ring (see "TwoPlayerGame_frame_ring.h")
+ * and starts listening again. "recv" takes packets from the ring. Acknowledgments for packets
+ * we sent are left for RadioHead because "sendtoWait" is watching for them. Acknowledging packets
+ * we receive still happens in "recv" because transmitting takes far too long for an interrupt.
+ * If the main loop falls so far behind that the ring fills up, further packets are counted in
+ * "rf69.Ring.dropped" and thrown away.
+ * 
  * Any of the RF69HCW devices sold by Adafruit should work but we have only tested using the
  * Feather Wing RFM69HCW 900 MHz RadioFruit https://www.adafruit.com/product/3229
  * See https://learn.adafruit.com/radio-featherwing for details. It should be easy to
@@ -28,6 +44,7 @@
 #include <RH_RF69.h>
 #include <RHReliableDatagram.h>
 #include <TwoPlayerGame_base_radio.h>
+#include <TwoPlayerGame_frame_ring.h>
 
 // American model uses 915 MHz with a range of 850-950 MHz
 // European model uses 433 MHz with a range of 400-460 MHz
@@ -40,11 +57,35 @@
 #define RFM69_RST     11   // "A"
 #define RFM69_INT     6    // "D"
 
+//Received packets that can be waiting in the ring. Must be a power of two.
+#define RF69_RING_SLOTS 8
+//Each ring entry starts with from, to, id, flags and RSSI followed by the packet
+#define RF69_RING_HEADER 5
+
+// Driver that drains received packets into a ring from its interrupt handler
+class RF69Driver : public RH_RF69 {
+  public:
+    frameRing<RF69_RING_SLOTS, RH_RF69_MAX_MESSAGE_LEN+RF69_RING_HEADER> Ring;
+    RF69Driver(uint8_t slaveSelectPin, uint8_t interruptPin) : RH_RF69(slaveSelectPin, interruptPin) {};
+    void drain(void);
+};
+
 //The driver object
-extern RH_RF69 rf69;
+extern RF69Driver rf69;
+
+// RadioHead header flag (one of the application specific bits) marking a packet that
+// should not be acknowledged
+#define RF69_NO_ACK_FLAG 0x01
+
+// Reliable datagram manager that lets us send an acknowledgment ourselves
+class RF69Manager : public RHReliableDatagram {
+  public:
+    RF69Manager(RHGenericDriver& driver) : RHReliableDatagram(driver) {};
+    void ack(uint8_t id, uint8_t from) {acknowledge(id,from);};
+};
 
 // Object to manage packet delivery and receipt, using the driver declared above
-extern RHReliableDatagram rf69_manager;
+extern RF69Manager rf69_manager;
 
 /*
  * The class definition
@@ -52,18 +93,23 @@ extern RHReliableDatagram rf69_manager;
 class RF69Radio : public baseRadio {
   public:
     bool setup(uint8_t myD,uint8_t otherD);
-    bool send(uint8_t* packet_ptr,uint8_t len) {
-      return rf69_manager.sendtoWait(packet_ptr,len, otherPlayerNum);
-    };
-    bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout) {
-      return rf69_manager.recvfromAckTimeout(packet_ptr,len_ptr,timeout);
-    };
-    bool recv(uint8_t* packet_ptr,uint8_t* len_ptr) {
-      return rf69_manager.recvfromAck(packet_ptr,len_ptr);
-    };
-    bool available(void) {return rf69_manager.available();};
+    bool send(uint8_t* packet_ptr,uint8_t len);
+    bool sendNoAck(uint8_t* packet_ptr,uint8_t len);
+    bool broadcast(uint8_t* packet_ptr,uint8_t len);
+    bool setAddresses(uint8_t myD, uint8_t otherD);
+    bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout);
+    bool recv(uint8_t* packet_ptr,uint8_t* len_ptr);
+    bool available(void) {return !rf69.Ring.empty() || rf69_manager.available();};
+    uint8_t modulations(void);
+    bool setModulation(uint8_t m);
+    const char* modulationName(uint8_t m);
+    uint8_t powerLevels(void);
+    bool setPowerLevel(uint8_t p);
+  private:
+    int16_t seenId;   //header ID of the last acknowledged packet, -1 if none
+    bool sendNoAckTo(uint8_t* packet_ptr,uint8_t len,uint8_t to);
 };
 
-//This is the maximum legal size of the packet we can transmit. You should check it against
-//your Move and Results objects to ensure that they are smaller than this number.
+//This is the maximum legal size of the packet we can transmit. Frames built by the packetCodec
+//are never larger than MAX_FRAME_SIZE which must not be larger than this number.
 #define MAX_LEGAL_PACKET_SIZE RH_RF69_MAX_MESSAGE_LEN
@@ -11,7 +11,23 @@
  
 #include "TwoPlayerGame.h"
 //String versions of the game state for debugging or other purposes
-const char* gameStateStr[5]={"Offering Game", "Seeking Game", "My Turn", "Opponent's Turn", "Game Over"};
+const char* gameStateStr[6]={"Offering Game", "Seeking Game", "My Turn", "Opponent's Turn", "Game Over",
+                             "Opponent Lost"};
+
+/*
+ * Phases used by step() to keep track of where we are within a game state. Every state
+ * begins in START_PHASE. The others are points where we are waiting on the other device.
+ */
+enum enginePhase_t {
+  START_PHASE,          //beginning of any state
+  WAIT_ACCEPT_PHASE,    //offering: offer sent, waiting on ACCEPTING_GAME_PACKET
+  WAIT_FOUND_PHASE,     //seeking: offer accepted, waiting on FOUND_GAME_PACKET
+  WAIT_FLIP_PHASE,      //seeking or discovering as player 2: waiting on COIN_FLIP_PACKET
+  WAIT_RESULTS_PHASE,   //my turn: move sent, waiting on RESULTS_PACKET
+  WAIT_LINK_PHASE,      //my turn as player 1: new link profile sent, waiting for it to be echoed
+  WAIT_PEER_PHASE,      //discovering: waiting to hear from the other device
+  SEND_FLIP_PHASE       //discovering as player 1: waiting for COIN_FLIP_PACKET to be acknowledged
+};
 
 /*
  * Constructor for the game object. 
@@ -23,44 +39,196 @@ baseGame::baseGame(baseMove* move_ptr, baseResults* results_ptr, baseRadio* radi
   //link the radio to the Move and get results objects
   Move->Radio=Radio;
   Results->Radio=Radio;
+  Packet.Radio=Radio;
   //determine player number which is use as radio address
   myPlayerNum=2;
   otherPlayerNum=1;
   if(isPlayer_1) {
     myPlayerNum=1; otherPlayerNum=2;
   };  
+  phase=START_PHASE;
+  tries=0;
+  piggybackResults=false;
+  perfectInformation=false;
+  appAcks=false;
+  adaptiveLink=false;
+  lowPower=false;
+  heartbeats=false;
+  heartbeatInterval=HEARTBEAT_INTERVAL;
+  livenessDeadline=LIVENESS_DEADLINE;
+  lastBeat=0;
+  resync=false;
+  hashCheck=false;
+  Store=NULL;
+  saved=false;
+  Journal=NULL;
+  discovery=false;
+  deviceId=0;
+  newGame();
+};
+
+/*
+ * Constructor for the game object when both devices run identical software. Player numbers
+ * are zero until discoverGame decides them.
+ */
+baseGame::baseGame(baseMove* move_ptr, baseResults* results_ptr, baseRadio* radio_ptr)
+    : baseGame(move_ptr, results_ptr, radio_ptr, true) {
+  discovery=true;
+  myPlayerNum=otherPlayerNum=0;
 };
 
+/*
+ * Internal routine that forgets everything about the previous game's moves and results.
+ */
+void baseGame::newGame(void) {
+  resultsPending=moveArrived=resultsArrived=false;
+  moveUnacked=retransmitted=homeRetry=false;
+  resyncing=resuming=false;
+  moveFrameLen=resultsFrameLen=0;
+  lastMoveSent=lastResultsSent=lastResultsGot=0;
+  Policy.reset();
+  lastHeard=millis();
+}
+
 /*
  * Called ONCE inside your main program "setup()" function.
  */
 void baseGame::setup(void) {
   SETUP_DEBUG;
+  Move->withPrediction=perfectInformation;
+  Move->withHash=Results->withHash=hashCheck;
+  if(discovery) {
+    if(deviceId==0) {
+      deviceId=uniqueDeviceId();
+    }
+    jitterState=(deviceId ^ micros()) | 1;
+    myPlayerNum=otherPlayerNum=0;
+  }
   Radio->setup(myPlayerNum,otherPlayerNum);
-  initialize();  //game specific variables
+  Radio->Inbox.clear();
+  Policy.begin(Radio);
+  Idle.reset();
+  lastReceived=heardCount=Radio->Stats.received;
+  if(Journal && !Journal->begin()) {
+    DEBUGLN("Journal could not be used.");
+    Journal=NULL;
+  }
+  if(!resumeGame()) {
+    initialize();  //game specific variables
+  }
+  phaseState=gameState;
+  stateStart=millis();
+  tries=0;
+  nextPhase(START_PHASE);
 };
 
 /*
- * Called from within your main program "loop()" function. Processes
- * okay each of the game states.
+ * Called from within your main program "loop()" function. Keeps calling step() until the 
+ * current game state has been completely processed. This is the traditional blocking
+ * behavior of the engine.
  */
 void baseGame::loopContents(void) {
-  switch(gameState) {
-    case OFFERING_GAME:  offeringGame();  break;
-    case SEEKING_GAME:   seekingGame();   break;
-    case MY_TURN:        doMyTurn();      break;
-    case OPPONENTS_TURN: doOpponentsTurn(); break;
-    case GAME_OVER:      gameOver();      break;
+  while(!step()) {
+    idle();
+  }
+  if(lowPower) {
+    wake();
+  }
+}
+
+/*
+ * Called between steps that didn't finish. Anything received or a button press counts as
+ * activity. We don't sleep if the radio already has something for the next step. Neither
+ * do we write the journal because that can take a while.
+ */
+void baseGame::idle(void) {
+  if(Journal && Journal->due() && !Radio->available()) {
+    Journal->flush();
+  }
+  bool busy=idleWork();
+  if(!lowPower) {
+    return;
+  }
+  if((Radio->Stats.received != lastReceived) || userActive()) {
+    lastReceived=Radio->Stats.received;
+    wake();
+    return;
+  }
+  if(Idle.dimDue()) {
+    Idle.dimmed=true;
+    dimDisplay(true);
+  }
+  if(!busy && !Radio->available()) {
+    Idle.sleep();
+  }
+}
+
+void baseGame::wake(void) {
+  if(Idle.dimmed) {
+    Idle.dimmed=false;
+    dimDisplay(false);
+  }
+  Idle.activity();
+}
+
+/*
+ * Does whatever the current game state needs right now without waiting. If the game state
+ * was changed since the last call, for example by your fatalError or initialize methods,
+ * we start that state over from the beginning. Returns true when the state is finished.
+ */
+bool baseGame::step(void) {
+  if(heartbeats) {
+    service();
+    uint32_t now=millis();
+    if(engaged() && !((gameState==MY_TURN) && (phase==START_PHASE) && !resyncing) &&
+        ((now-lastHeard) > livenessDeadline) && ((now-phaseStart) > livenessDeadline)) {
+      DEBUGLN("Heard nothing from opponent. Giving up.");
+      gameState=OPPONENT_LOST;
+      resyncing=resuming=false;
+    }
+  }
+  if(gameState != phaseState) {
+    phaseState=gameState;
+    tries=0;
+    stateStart=millis();
+    nextPhase(START_PHASE);
   }
+  bool done=false;
+  if(resyncing) {
+    done=awaitResync();
+  }
+  if(!(done || resyncing)) {
+    switch(gameState) {
+      case OFFERING_GAME:  done=discovery ? discoverGame() : offeringGame();  break;
+      case SEEKING_GAME:   done=seekingGame();   break;
+      case MY_TURN:        done=doMyTurn();      break;
+      case OPPONENTS_TURN: done=doOpponentsTurn(); break;
+      case GAME_OVER:      done=gameOver();      break;
+      case OPPONENT_LOST:  done=opponentLost();  break;
+    }
+  }
+  if(done) {
+    if(((phaseState==OFFERING_GAME) || (phaseState==SEEKING_GAME)) &&
+        ((gameState==MY_TURN) || (gameState==OPPONENTS_TURN))) {
+      journalStart(false);
+    }
+    phaseState=gameState;
+    tries=0;
+    stateStart=millis();
+    nextPhase(START_PHASE);
+    saveGame();
+  }
+  return done;
 }
 
-#define OFFERING_TIMEOUT 1000 //one second
-#define OFFERING_TRIES  2
+//How long we keep offering before we give up and start seeking
+#define OFFERING_PERIOD 2000
 
 /*
- * Internal routine to offer a game. Send out an "OFFERING_GAME" packet and wait for the time 
- * period specified in OFFERING_TIMEOUT. NOTE although we can't figure out why, our packet 
- * radio seems to use 1000 as a maximum value. Repeat OFFERING_TRIES times.
+ * Internal routine to offer a game. Send out an "OFFERING_GAME" packet and wait for a reply. 
+ * How long we wait comes from Radio->Rtt which learns how quickly the other device replies. 
+ * Before it has learned anything that is one second. Each time we go unanswered we wait 
+ * twice as long. We keep trying for OFFERING_PERIOD milliseconds.
  * 
  * Sending this packet means I'm initiating a game and wanting you to join. This is in contrast 
  * to "SEEKING_GAME" which means I'm waiting for the other player to offer me a game. If there is 
@@ -70,93 +238,985 @@ void baseGame::loopContents(void) {
  * enough because the other machine might be in the some random state and it would just be acknowledging 
  * the receipt. We must receive an "ACCEPTING_GAME" packet in order to begin the game.
  */
-void baseGame::offeringGame(void) {
-  basePacket p(Radio);
-  currentMoveNum=1;
-  for (uint8_t i=0;i<OFFERING_TRIES;i++) {//try repeatedly
-    //If true, packet was received but that's not enough.
-    if(p.send(OFFERING_GAME_PACKET)) {
-      if(p.requireTypeTimeout(ACCEPTING_GAME_PACKET, OFFERING_TIMEOUT)) {
-        p.send(FOUND_GAME_PACKET);//let them know they found us
+bool baseGame::offeringGame(void) {
+  switch(phase) {
+    case START_PHASE:
+      currentMoveNum=1;
+      newGame();
+      if(tries && ((millis()-stateStart) >= OFFERING_PERIOD)) {
+        //We give up. Switch to seeking game.
+        gameState=SEEKING_GAME;
+        return true;
+      }
+      tries++;
+      exchangeStart=micros();
+      //If true, packet was received but that's not enough.
+      if(Packet.send(OFFERING_GAME_PACKET)) {
+        nextPhase(WAIT_ACCEPT_PHASE);
+      } else {
+        DEBUGLN("No reply to offer.");
+      }
+      return false;
+    case WAIT_ACCEPT_PHASE:
+      if(Packet.pollType(ACCEPTING_GAME_PACKET)) {
+        if(tries==1) {  //if we offered more than once we can't tell which one they answered
+          Radio->Rtt.sample(micros()-exchangeStart);
+        }
+        Packet.send(FOUND_GAME_PACKET);//let them know they found us
         //The game has been accepted. Flip the coin and send the results in a COIN_FLIP_PACKET.
         //If it's true, we go first. If false other player goes first.
-        if(p.subType=(packetSubType_t)coinFlip()) {//Not a mistake
+        if((Packet.subType=(packetSubType_t)coinFlip())) {//Not a mistake
           gameState=MY_TURN;
         } else {
           gameState=OPPONENTS_TURN;
         }
-        p.send(COIN_FLIP_PACKET);
-        return;
+        Packet.send(COIN_FLIP_PACKET);
+        return true;
       }
-      //we got a reply but it wasn't the right one so we keep looking
-      DEBUGLN("Got reply but it wasn't \"Accepting\"");
-      continue;
-    }
-    //OFFERING_TIMEOUT exceeded so we no reply so we send again
-    DEBUGLN("No reply to offer.");
+      if((millis()-phaseStart) > Radio->Rtt.timeout()) {
+        //Timeout exceeded with no "Accepting" reply so we send again
+        DEBUGLN("No accepting reply to offer.");
+        Radio->Rtt.backoff();
+        nextPhase(START_PHASE);
+      }
+      return false;
   }
-  //We give up. Switch to seeking game.
-  gameState=SEEKING_GAME;
+  return false;
 }
 
 /*
  * Internal method to wait for a game. We tried offering a game but no one was ready so 
- * now we sit and wait forever for an offer to come in. If we get one, we accept it and 
+ * now we wait as long as it takes for an offer to come in. If we get one, we accept it and 
  * the other player will perform coin flip. The outcome of the flip is received in a
  * COIN_FLIP_PACKET. If the packet subType is true, offering player goes first. Otherwise
  * we go first.
  */
-void baseGame::seekingGame(void) {
-  basePacket p(Radio); 
-  p.requireType(OFFERING_GAME_PACKET);//wait forever
-  DEBUGLN("Offer Received.");
-  //we got the offer so now let's accept it
-  if(!p.send(ACCEPTING_GAME_PACKET)) {
-    fatalError("No ack during Accepting Game");
+bool baseGame::seekingGame(void) {
+  switch(phase) {
+    case START_PHASE:
+      newGame();
+      if(!Packet.pollType(OFFERING_GAME_PACKET)) {
+        return false;
+      }
+      DEBUGLN("Offer Received.");
+      //we got the offer so now let's accept it
+      exchangeStart=micros();
+      if(!Packet.send(ACCEPTING_GAME_PACKET)) {
+        fatalError("No ack during Accepting Game");
+        return true;
+      }
+      nextPhase(WAIT_FOUND_PHASE);
+      return false;
+    case WAIT_FOUND_PHASE:
+      //When we get this we found a game. If the coin flip is already here the found packet got lost. 
+      if(Packet.pollType(FOUND_GAME_PACKET)) {
+        Radio->Rtt.sample(micros()-exchangeStart);
+      } else if(!Radio->Inbox.waiting(COIN_FLIP_PACKET)) {
+        return false;
+      }
+      foundGame();  //Let the derived game print a message
+      nextPhase(WAIT_FLIP_PHASE);
+      return false;
+    case WAIT_FLIP_PHASE:
+      if(!Packet.pollType(COIN_FLIP_PACKET)) {
+        return false;
+      }
+      processFlip((bool)Packet.subType);  //let the derived game know results of coin flip
+      if(Packet.subType) { //If flip was true, opponent goes first, otherwise we do
+        gameState=OPPONENTS_TURN;
+      } else {
+        gameState=MY_TURN;
+      }
+      currentMoveNum=1;
+      return true;
+  }
+  return false;
+}
+
+/*
+ * Internal routine that returns a number that ought to be different on every device. SAMD 
+ * processors have a 128-bit serial number burned in at the factory which we fold into 32 bits. 
+ * Anywhere else we have to settle for a random number. It is never zero because a peer ID
+ * of zero means we haven't heard from anyone.
+ */
+uint32_t baseGame::uniqueDeviceId(void) {
+  uint32_t id;
+  #if defined(__SAMD51__)
+    id= *(volatile uint32_t*)0x008061FC ^ *(volatile uint32_t*)0x00809010 ^
+        *(volatile uint32_t*)0x00809014 ^ *(volatile uint32_t*)0x00809018;
+  #elif defined(ARDUINO_ARCH_SAMD)
+    id= *(volatile uint32_t*)0x0080A00C ^ *(volatile uint32_t*)0x0080A040 ^
+        *(volatile uint32_t*)0x0080A044 ^ *(volatile uint32_t*)0x0080A048;
+  #else
+    id= ((uint32_t)random(0x10000) << 16) ^ (uint32_t)random(0x10000) ^ micros();
+  #endif
+  return id ? id : 1;
+}
+
+/*
+ * Internal random number generator used for discovery timing. We use our own rather than
+ * random() so that we don't disturb your game's random numbers, and because two devices 
+ * running the same game may well seed random() with the same value at the same moment.
+ * Returns a number from 0 to n-1.
+ */
+uint16_t baseGame::jitter(uint16_t n) {
+  jitterState ^= jitterState << 13;
+  jitterState ^= jitterState >> 17;
+  jitterState ^= jitterState << 5;
+  return n ? jitterState % n : 0;
+}
+
+/*
+ * Internal routine that sets both player numbers and the radio addresses that go with them.
+ * Player number zero means not yet decided.
+ */
+void baseGame::setPlayer(uint8_t n) {
+  myPlayerNum=n;
+  otherPlayerNum= n ? 3-n : 0;
+  Radio->setAddresses(myPlayerNum,otherPlayerNum);
+}
+
+//Limits in milliseconds on the random window between discovery packets
+#define DISCOVERY_MIN_WINDOW 16
+#define DISCOVERY_MAX_WINDOW 1024
+
+/*
+ * Internal routine used in place of offeringGame when the game was constructed without isPlayer_1. 
+ * Both devices run exactly the same code so neither one can simply decide to offer or to seek. 
+ * Instead each of them broadcasts DISCOVER_PACKETs containing its own ID and the ID of the last 
+ * device it heard from. They go out at random times within a window that doubles after every 
+ * packet up to DISCOVERY_MAX_WINDOW, the same way Ethernet stations avoid colliding with each other.
+ * Even two devices that were switched on at the same moment soon stop talking over each other. 
+ * 
+ * See heardDiscover for what happens when we receive one. Once both devices know about each other
+ * the one with the higher ID becomes player 1. It calls coinFlip and sends the outcome in a 
+ * COIN_FLIP_PACKET exactly as the offering player does. The other one becomes player 2 and waits 
+ * for it exactly as the seeking player does. If the flip is not acknowledged player 1 repeats its 
+ * DISCOVER_PACKET because player 2 may not have heard the last one.
+ */
+bool baseGame::discoverGame(void) {
+  switch(phase) {
+    case START_PHASE:
+      currentMoveNum=1;
+      newGame();
+      setPlayer(0);
+      peerId=toldId=0;
+      discoveryWindow=DISCOVERY_MIN_WINDOW;
+      discoveryTimer=millis();
+      discoveryWait=jitter(DISCOVERY_MIN_WINDOW);
+      nextPhase(WAIT_PEER_PHASE);
+      return false;
+    case WAIT_PEER_PHASE:
+      pollDiscovery();
+      if((phase==WAIT_PEER_PHASE) && ((millis()-discoveryTimer) >= discoveryWait)) {
+        sendDiscover();
+      }
+      return false;
+    case SEND_FLIP_PHASE:
+      if(tries==0) {
+        tries++;
+        Packet.subType=(packetSubType_t)coinFlip();//Not a mistake
+      }
+      pollDiscovery();
+      if((phase!=SEND_FLIP_PHASE) || ((millis()-discoveryTimer) < discoveryWait)) {
+        return false;
+      }
+      if(Packet.send(COIN_FLIP_PACKET)) {
+        //If it's true, we go first. If false other player goes first.
+        gameState= Packet.subType ? MY_TURN : OPPONENTS_TURN;
+        return true;
+      }
+      DEBUGLN("Coin flip not acknowledged.");
+      sendDiscover();
+      return false;
+    case WAIT_FLIP_PHASE:
+      if(!pollDiscovery()) {
+        return false;
+      }
+      processFlip((bool)Packet.subType);  //let the derived game know results of coin flip
+      //If flip was true, opponent goes first, otherwise we do
+      gameState= Packet.subType ? OPPONENTS_TURN : MY_TURN;
+      return true;
+  }
+  return false;
+}
+
+/*
+ * Internal routine that broadcasts our ID and the ID of the device we last heard from, then
+ * picks a random time for the next one and doubles the window.
+ */
+void baseGame::sendDiscover(void) {
+  discoverPacket d;
+  uint8_t buf[MAX_FRAME_SIZE];
+  d.deviceId=deviceId;
+  d.peerId=peerId;
+  uint8_t len=d.encode(buf,sizeof(buf));
+  DEBUG("Sending discover. ID="); DEBUG(deviceId); DEBUG(" peer="); DEBUGLN(peerId);
+  Radio->broadcast(buf,len);
+  toldId=peerId;
+  discoveryTimer=millis();
+  discoveryWait=discoveryWindow/2 + jitter(discoveryWindow/2);
+  if(discoveryWindow < DISCOVERY_MAX_WINDOW) {
+    discoveryWindow*=2;
+  }
+}
+
+/*
+ * Internal routine that takes a frame from the Inbox while discovering. A DISCOVER_PACKET is handled
+ * by heardDiscover. Returns true if we are player 2 and a COIN_FLIP_PACKET arrived, in which case 
+ * it has been unpacked into Packet. Anything else stays in the Inbox.
+ */
+bool baseGame::pollDiscovery(void) {
+  uint8_t buf[MAX_FRAME_SIZE];
+  uint8_t len = sizeof(buf);
+  uint16_t wanted=DISPATCH_TYPE(DISCOVER_PACKET);
+  if(myPlayerNum==2) {
+    wanted|=DISPATCH_TYPE(COIN_FLIP_PACKET);
+  }
+  Radio->pump();
+  if(!Radio->Inbox.takeAny(wanted,buf,&len)) {
+    return false;
+  }
+  if(basePacket::frameType(buf)==COIN_FLIP_PACKET) {
+    return Packet.decode(buf,len);
+  }
+  discoverPacket d;
+  if(d.decode(buf,len)) {
+    heardDiscover(d.deviceId,d.peerId);
+  }
+  return false;
+}
+
+/*
+ * Internal routine called when we receive a DISCOVER_PACKET from device "id" which last heard 
+ * from device "theirPeer". 
+ *    - If it has our own ID, both devices picked the same random ID so we pick another one.
+ *    - If it doesn't know about us yet we answer right away.
+ *    - If it does know about us, both devices now know about each other so we decide who is 
+ *      player 1. We answer only if we haven't already told it about itself. 
+ *    - Once we are player 2 we answer every DISCOVER_PACKET from player 1 because it only 
+ *      sends them when it thinks we haven't heard about it. Player 1 ignores them.
+ *    - If we already have a partner and a different device shows up, our partner must have 
+ *      been restarted with a new ID so we start over.
+ * Answering only when the other device is missing something keeps the two from answering
+ * each other forever.
+ */
+void baseGame::heardDiscover(uint32_t id, uint32_t theirPeer) {
+  if(id==deviceId) {
+    DEBUGLN("Other device has the same ID. Choosing another.");
+    deviceId= ((uint32_t)jitter(0xffff) << 16) | (jitter(0xffff)+1);
     return;
   }
-  p.requireType(FOUND_GAME_PACKET);//When we get this we found a game
-  foundGame();  //Let the derived game print a message
-  p.requireType(COIN_FLIP_PACKET);
-  processFlip((bool)p.subType);  //let the derived game know results of coin flip
-  if(p.subType) { //If flip was true, opponent goes first, otherwise we do
-    gameState=OPPONENTS_TURN;
+  if(myPlayerNum) {
+    if(id==peerId) {
+      if(myPlayerNum==2) {
+        sendDiscover();
+      }
+      return;
+    }
+    DEBUGLN("A different device is looking for a game. Starting over.");
+    setPlayer(0);
+    nextPhase(WAIT_PEER_PHASE);
+  }
+  peerId=id;
+  discoveryWindow=DISCOVERY_MIN_WINDOW;
+  if(theirPeer != deviceId) {
+    sendDiscover();   //they don't know about us yet
+    return;
+  }
+  bool told= (toldId==id);
+  setPlayer((deviceId > id) ? 1 : 2);
+  DEBUG("Found a game. We are player "); DEBUGLN(myPlayerNum);
+  if(!told) {
+    sendDiscover();   //they don't know that we know about them
+  }
+  tries=0;
+  nextPhase((myPlayerNum==1) ? SEND_FLIP_PHASE : WAIT_FLIP_PHASE);
+  playerElected();
+  if(myPlayerNum==2) {
+    foundGame();  //Let the derived game print a message
+  }
+}
+
+/*
+ * Internal routine that sends a frame. With appAcks the reply is our acknowledgment so we
+ * don't ask the radio for one.
+ */
+bool baseGame::transmit(uint8_t* buf, uint8_t len) {
+  if(appAcks) {
+    return Radio->sendNoAck(buf,len);
+  }
+  return Radio->send(buf,len);
+}
+
+/*
+ * Internal routine that sends our move. If we are holding results for our opponent's last move
+ * they go in the same frame, results first. If for some reason the two will not fit together 
+ * in one frame we send them separately. A copy of the frame is kept in case we have to send it again.
+ */
+bool baseGame::sendMove(void) {
+  uint8_t resultsLen=0;
+  if(resultsPending) {
+    resultsPending=false;
+    resultsLen=Results->encode(moveFrame,sizeof(moveFrame));
+  }
+  uint8_t moveLen= Move->encode(moveFrame+resultsLen,sizeof(moveFrame)-resultsLen);
+  if(resultsLen && (moveLen==0)) {
+    DEBUGLN("Results and move too large for one frame. Sending separately.");
+    sendResults();
+    resultsLen=0;
+    moveLen=Move->encode(moveFrame,sizeof(moveFrame));
+  }
+  if(moveLen==0) {
+    DEBUGLN("Move too large for one frame.");
+    moveFrameLen=0;
+    return false;
+  }
+  moveFrameLen=resultsLen+moveLen;
+  if(resultsLen) {
+    journal(JOURNAL_SENT,moveFrame,resultsLen);
+  }
+  journal(JOURNAL_SENT,moveFrame+resultsLen,moveLen);
+  lastMoveSent=Move->moveNum;
+  retransmitted=false;
+  ackTimer=millis();
+  exchangeStart=micros();
+  DEBUG("Sending move "); DEBUG(lastMoveSent); 
+  DEBUG(resultsLen ? " with results. Length=" : ". Length="); DEBUGLN(moveFrameLen);
+  bool sent=transmit(moveFrame,moveFrameLen);
+  moveUnacked= !sent || awaitsReply();
+  return sent;
+}
+
+//If we hear nothing for this long with adaptiveLink on, we go back to the home profile
+#define LINK_SILENCE_TIMEOUT 15000
+
+/*
+ * Internal routine that sends our move and doesn't give up if the radio never gets an
+ * acknowledgment. Usually the move arrived and only the acknowledgment was lost. Either way
+ * it stays in moveFrame and retransmit sends it again until our opponent replies. Our opponent
+ * recognizes a duplicate by its move number and answers it again. With adaptiveLink we also
+ * go back to the home profile. Returns false only if the move would not fit in a frame.
+ */
+bool baseGame::deliverMove(void) {
+  if(sendMove()) {
+    return true;
+  }
+  if(moveFrameLen==0) {
+    return false;
+  }
+  DEBUGLN("Move was not acknowledged. Will send it again.");
+  moveUnacked=true;
+  if(adaptiveLink) {
+    resendAtHome();
+  }
+  return true;
+}
+
+//Number of times we try to send results that end the game
+#define FINAL_RESULTS_TRIES 3
+
+/*
+ * Internal routine that sends the results of our opponent's move in a frame of their own.
+ * Results that end the game always get a link-level acknowledgment because once the game
+ * is over we will no longer be around to answer a repeated move. Other results that are never
+ * acknowledged are sent again when our opponent repeats its move. See answerRepeat.
+ */
+void baseGame::sendResults(void) {
+  resultsFrameLen=Results->encode(resultsFrame,sizeof(resultsFrame));
+  journal(JOURNAL_SENT,resultsFrame,resultsFrameLen);
+  lastResultsSent=Results->resultsNum;
+  resultsTimer=millis();
+  DEBUG("Sending results "); DEBUGLN(lastResultsSent);
+  if(gameState==GAME_OVER) {
+    //Nobody will ask for these again once the game is over so we try harder
+    for(uint8_t i=0; (i<FINAL_RESULTS_TRIES) && !Radio->send(resultsFrame,resultsFrameLen); i++) {
+      DEBUGLN("Final results were not acknowledged. Sending them again.");
+    }
   } else {
-    gameState=MY_TURN;
+    transmit(resultsFrame,resultsFrameLen);
   }
-  currentMoveNum=1;
 }
 
 /*
- * Internal routine for handling my move. It calls Move->decideMyMove() which is a virtual method
- * you will supply in your derived move class to actually decide what your move will be. Then this
- * method transmits it and then waits indefinitely for the other device to send us a "results" message.
- * We then call Results->processResults() which is a virtual method you will supply in your derived
- * results class. See the baseResults definition and comments in "TwoPlayerGame_base_packet.h"
- * for an explanation of what is a result.
+ * Internal routine called while we wait on our opponent. If our move has not been
+ * acknowledged or answered in time, send it again and wait twice as long for the next try.
+ * Right after resendAtHome we don't wait. We send it once each step until it gets through
+ * or the other device has had time to come home too.
  */
-void baseGame::doMyTurn(void) {
-  Move->moveNum = currentMoveNum;
-  Move->decideMyMove();
-  if(!Move->send()) {
-    fatalError("No ack from send move");
+void baseGame::retransmit(void) {
+  if(!moveUnacked) {
+    homeRetry=false;
     return;
   }
-  DEBUGLN("Waiting for results.");
-  Results->require();
-  if(Results->resultsNum != currentMoveNum) {
-    DEBUG("Results.resultsNum incorrect. Value is:"); DEBUG(Results->resultsNum);
-    DEBUG (" expected:"); DEBUGLN(currentMoveNum);
-    fatalError("Results number mismatch error.");
+  if(homeRetry) {
+    if((millis()-homeRetryStart) >= LINK_SILENCE_TIMEOUT+1000) {
+      DEBUGLN("Move still not acknowledged at home link profile.");
+      homeRetry=false;
+    } else if(transmit(moveFrame,moveFrameLen)) {
+      homeRetry=false;
+      moveUnacked=awaitsReply();
+      ackTimer=millis();
+      retransmitted=true;
+    }
     return;
   }
-  if(Results->processResults()) { //returns true if the game ended
-    gameState=GAME_OVER;
-  } else {
-    gameState=OPPONENTS_TURN;     //otherwise it's our opponents turn
+  if((millis()-ackTimer) < Radio->Rtt.timeout()) {
+    return;
   }
-  //now that I've got results, the move is complete so increment the move number.
-  currentMoveNum++;
+  DEBUG("No reply to move "); DEBUG(lastMoveSent); DEBUGLN(". Sending it again.");
+  if(transmit(moveFrame,moveFrameLen) && !awaitsReply()) {
+    moveUnacked=false;    //acknowledged at last and no reply is coming until our opponent moves
+  }
+  ackTimer=millis();
+  retransmitted=true;
+  Radio->Rtt.backoff();
+}
+
+/*
+ * Internal routine called when our opponent sends move number "n" again after we already
+ * handled it. Whatever we sent in reply never arrived so we send it again. That could be
+ * results by themselves, our next move, or both. A repeat that shows up right after we sent
+ * our reply crossed paths with it, so we leave it alone. Otherwise every answered repeat would
+ * become a repeat on the other side and the two devices would never stop answering each other.
+ */
+void baseGame::answerRepeat(uint16_t n) {
+  DEBUG("Repeat of move "); DEBUG(n); DEBUGLN(" received.");
+  uint32_t now=millis();
+  uint16_t recent=Radio->Rtt.timeout()/2;
+  if(resultsFrameLen && (lastResultsSent==n) && ((now-resultsTimer) >= recent)) {
+    transmit(resultsFrame,resultsFrameLen);
+    resultsTimer=now;
+  }
+  if(moveFrameLen && (lastMoveSent==n+1) && ((now-ackTimer) >= recent)) {
+    transmit(moveFrame,moveFrameLen);
+    ackTimer=now;
+  }
+}
+
+/*
+ * Internal routine called by player 1 at the start of each of its turns when adaptiveLink is on.
+ * If the policy wants a different profile we tell the other device and switch once it has
+ * acknowledged. Without an acknowledgment we can't tell whether the other device switched so
+ * we go home and let the silence timeout bring it home too if it did. Returns true if we
+ * switched and must wait for the other device to echo the profile.
+ */
+bool baseGame::adaptLink(void) {
+  uint8_t p=Policy.evaluate(Radio->Stats);
+  if(p==Policy.current) {
+    return false;
+  }
+  DEBUG("Changing link profile to "); DEBUGLN(p);
+  Packet.type=LINK_PROFILE_PACKET;
+  Packet.subType=(packetSubType_t)p;  //Not a mistake
+  if(Packet.send() && Policy.apply(p)) {
+    linkEchoed=false;
+    return true;
+  }
+  Policy.reset();
+  return false;
+}
+
+/*
+ * Internal routine called by player 1 from doMyTurn until it returns true. The acknowledgment
+ * of a LINK_PROFILE_PACKET only means the other device received it, not that it has switched.
+ * If we sent our move straight away it could still be on the old profile and miss it. So once
+ * we have switched we wait for it to echo the packet on the new profile. If no echo comes in
+ * time we go home, and so does the other device when its echo isn't acknowledged.
+ */
+bool baseGame::linkSettled(void) {
+  if(phase==START_PHASE) {
+    if(!adaptLink()) {
+      return true;
+    }
+    nextPhase(WAIT_LINK_PHASE);
+  }
+  receiveFrame();
+  if(linkEchoed) {
+    return true;
+  }
+  if((millis()-phaseStart) >= Radio->Rtt.timeout()) {
+    DEBUGLN("Link profile was not echoed. Returning to home link profile.");
+    Policy.reset();
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Internal routine called when sending our move failed with adaptiveLink on. The other device
+ * may be on a different profile. We go home and have retransmit keep trying, one send per step,
+ * long enough for its silence timeout to bring it home as well.
+ */
+void baseGame::resendAtHome(void) {
+  DEBUGLN("Send failed. Returning to home link profile.");
+  Policy.reset();
+  homeRetry=true;
+  homeRetryStart=millis();
+}
+
+/*
+ * Returns true once we have found the other device and are playing or finishing the coin toss.
+ * Before that there is nobody to send heartbeats to.
+ */
+bool baseGame::engaged(void) {
+  switch(gameState) {
+    case MY_TURN:
+    case OPPONENTS_TURN:
+      return true;
+    case OFFERING_GAME:
+    case SEEKING_GAME:
+      return (phaseState==gameState) && 
+        ((phase==WAIT_FOUND_PHASE) || (phase==WAIT_FLIP_PHASE) || (phase==SEND_FLIP_PHASE));
+    default:
+      return false;
+  }
+}
+
+/*
+ * Keeps the heartbeat going. Heartbeats are filed in Radio->Inbox like anything else so we take
+ * them out here before they can crowd out something that matters. Anything received at all shows 
+ * the other device is alive, not just heartbeats.
+ */
+void baseGame::service(void) {
+  if(!heartbeats) {
+    return;
+  }
+  Radio->pump();
+  while(Radio->Inbox.take(HEARTBEAT_PACKET,NULL,NULL)) {
+    Radio->Stats.countHeartbeatReceived();
+  }
+  if(Radio->Stats.received != heardCount) {
+    heardCount=Radio->Stats.received;
+    lastHeard=millis();
+  }
+  if(engaged() && ((millis()-lastBeat) >= heartbeatInterval)) {
+    basePacket Beat(Radio);
+    Beat.type=HEARTBEAT_PACKET;
+    uint8_t buf[MAX_FRAME_SIZE];
+    Radio->sendNoAck(buf,Beat.encode(buf,sizeof(buf)));
+    Radio->Stats.countHeartbeatSent();
+    lastBeat=millis();
+  }
+}
+
+/*
+ * Internal routine called while we wait on the other device. If we have heard nothing for
+ * too long we assume it has gone home so we do too.
+ */
+void baseGame::checkSilence(void) {
+  if(adaptiveLink && (Policy.current!=Policy.home) && ((millis()-lastHeard) > LINK_SILENCE_TIMEOUT)) {
+    DEBUGLN("Link silent too long. Returning to home link profile.");
+    Policy.reset();
+  }
+}
+
+/*
+ * Internal routine called when the move numbers disagree and resync is on. We stop playing and
+ * ask the other device for a snapshot. See awaitResync.
+ */
+void baseGame::requestResync(void) {
+  resyncPacket Request;
+  uint8_t buf[MAX_FRAME_SIZE];
+  Request.moveNum=currentMoveNum;
+  Request.resumed=resuming;
+  DEBUG("Requesting resync at move "); DEBUGLN(currentMoveNum);
+  transmit(buf,Request.encode(buf,sizeof(buf)));
+  resyncing=true;
+  resyncTimer=millis();
+}
+
+//Types of frames handled while resyncing
+#define RESYNC_FRAMES (DISPATCH_TYPE(RESYNC_REQUEST_PACKET) | DISPATCH_TYPE(RESYNC_PACKET))
+
+/*
+ * Internal routine called by step() in place of the current state while we wait on a snapshot.
+ * Moves and results stay in the Inbox until we know what move number they should have. If no 
+ * answer comes in time we ask again and wait twice as long. Returns true once a snapshot has been
+ * restored, at which point gameState and currentMoveNum have been set. If we are trying to resume
+ * a saved game but the other device is looking for a new one, the saved game is over so we start
+ * a new one too and return true.
+ */
+bool baseGame::awaitResync(void) {
+  uint8_t buf[MAX_FRAME_SIZE];
+  uint8_t len = sizeof(buf);
+  Radio->pump();
+  if(resuming && (Radio->Inbox.waiting(DISCOVER_PACKET) || Radio->Inbox.waiting(OFFERING_GAME_PACKET))) {
+    DEBUGLN("Opponent is looking for a new game. Saved game abandoned.");
+    resyncing=resuming=false;
+    if(discovery) {
+      setPlayer(0);
+    }
+    gameState=OFFERING_GAME;
+    initialize();
+    return true;
+  }
+  if(Radio->Inbox.takeAny(RESYNC_FRAMES,buf,&len)) {
+    lastHeard=millis();
+    if(handleResync(buf,len)) {
+      return true;
+    }
+  }
+  if(resyncing && ((millis()-resyncTimer) >= Radio->Rtt.timeout())) {
+    DEBUGLN("No snapshot received.");
+    Radio->Rtt.backoff();
+    requestResync();
+  }
+  return false;
+}
+
+/*
+ * Internal routine that handles a RESYNC_REQUEST_PACKET or RESYNC_PACKET. A request is answered
+ * with a snapshot if we have the history that counts, otherwise with a request of our own. That is
+ * whoever has the higher move number. If they are the same, a device that just resumed a saved game
+ * may have missed something after it was saved so the other one wins. Otherwise player 1 does. A
+ * snapshot is only wanted if we asked for one. Once it is restored we forget everything about moves
+ * and results in flight because they belong to the history we just replaced. Returns true if a 
+ * snapshot was restored.
+ */
+bool baseGame::handleResync(uint8_t* buf, uint8_t len) {
+  resyncPacket R;
+  uint8_t used=R.decode(buf,len);
+  if(used==0) {
+    return false;
+  }
+  if(R.type==RESYNC_REQUEST_PACKET) {
+    DEBUG("Resync requested at move "); DEBUGLN(R.moveNum);
+    bool tieWon= (R.resumed!=resuming) ? R.resumed : (myPlayerNum==1);
+    if((currentMoveNum>R.moveNum) || ((currentMoveNum==R.moveNum) && tieWon)) {
+      sendSnapshot();
+    } else {
+      requestResync();
+    }
+    return false;
+  }
+  if(!resyncing) {
+    return false;   //a repeat of one we already restored
+  }
+  uint16_t oldMoveNum=currentMoveNum;
+  gameState_t oldState=gameState;
+  currentMoveNum=R.moveNum;
+  gameState= R.myTurn ? OPPONENTS_TURN : MY_TURN;
+  packetCodec c(buf+used,len-used,false);
+  if(!restore(c)) {
+    DEBUGLN("Snapshot could not be restored.");
+    currentMoveNum=oldMoveNum;
+    gameState=oldState;
+    return false;
+  }
+  DEBUG("Snapshot restored at move "); DEBUGLN(R.moveNum);
+  resyncing=resuming=false;
+  resultsPending=moveArrived=resultsArrived=false;
+  moveUnacked=retransmitted=false;
+  moveFrameLen=resultsFrameLen=0;
+  lastMoveSent=lastResultsGot=currentMoveNum-1;
+  lastResultsSent=0;
+  Radio->Rtt.endBackoff();
+  return true;
+}
+
+/*
+ * Internal routine that answers a resync request with our move number, whose turn it is, and
+ * the game's snapshot. If we are waiting on results for our move it is not part of the snapshot
+ * so we send it again. If we had asked for a snapshot ourselves we no longer need one.
+ */
+void baseGame::sendSnapshot(void) {
+  resyncPacket R;
+  uint8_t buf[MAX_FRAME_SIZE];
+  R.type=RESYNC_PACKET;
+  R.moveNum=currentMoveNum;
+  R.myTurn= (gameState==MY_TURN);
+  uint8_t len=R.encode(buf,sizeof(buf));
+  packetCodec c(buf+len,sizeof(buf)-len,true);
+  snapshot(c);
+  if(!c.ok) {
+    fatalError("Snapshot too large for one frame");
+    return;
+  }
+  DEBUG("Sending snapshot at move "); DEBUG(currentMoveNum); DEBUG(". Length="); DEBUGLN(len+c.len);
+  transmit(buf,len+c.len);
+  resyncing=resuming=false;
+  if(movePending() && moveFrameLen) {
+    moveUnacked= !transmit(moveFrame,moveFrameLen) || awaitsReply();
+    ackTimer=millis();
+    retransmitted=true;
+  }
+}
+
+/*
+ * Returns true if our move has been sent and we are still waiting on its results.
+ */
+bool baseGame::movePending(void) {
+  return (gameState==MY_TURN) && (phaseState==MY_TURN) && (phase==WAIT_RESULTS_PHASE);
+}
+
+/*
+ * Internal routine called by setup if Store is set. If a game was saved we pick it up where it 
+ * left off instead of calling initialize. Anything that happened after it was saved, on either
+ * device, is sorted out by asking the other device to resync. A save we can't use is forgotten.
+ * Returns true if a game was resumed.
+ */
+bool baseGame::resumeGame(void) {
+  if(!(Store && resync)) {
+    return false;
+  }
+  if(!Store->begin()) {
+    DEBUGLN("Store could not be used.");
+    Store=NULL;
+    return false;
+  }
+  uint8_t buf[STORE_SLOT_SIZE];
+  uint8_t len=Store->load(buf,sizeof(buf));
+  saved= (len>0);
+  if(!saved) {
+    return false;
+  }
+  packetCodec c(buf,len,false);
+  uint8_t player=0;
+  gameState_t state=OFFERING_GAME;
+  uint16_t moveNum=0;
+  c.field(player); c.field(state); c.field(moveNum);
+  bool usable= c.ok && ((state==MY_TURN) || (state==OPPONENTS_TURN)) &&
+               (discovery ? ((player==1) || (player==2)) : (player==myPlayerNum));
+  if(usable) {
+    if(discovery) {
+      setPlayer(player);
+    }
+    currentMoveNum=moveNum;
+    gameState=state;
+    usable=resume(c);
+  }
+  if(!usable) {
+    DEBUGLN("Saved game could not be resumed.");
+    if(discovery) {
+      setPlayer(0);
+    }
+    gameState=OFFERING_GAME;
+    saveGame();   //forgets it
+    return false;
+  }
+  DEBUG("Resumed saved game at move "); DEBUGLN(currentMoveNum);
+  journalStart(true);
+  newGame();
+  resuming=true;
+  requestResync();
+  return true;
+}
+
+/*
+ * Internal routine called by step() each time a state is finished. At the start of each turn
+ * the game is saved in Store. Once the game is over the save is forgotten, just once.
+ */
+void baseGame::saveGame(void) {
+  if(!(Store && resync)) {
+    return;
+  }
+  if((gameState!=MY_TURN) && (gameState!=OPPONENTS_TURN)) {
+    if(saved) {
+      Store->forget();
+      saved=false;
+    }
+    return;
+  }
+  uint8_t buf[STORE_SLOT_SIZE-STORE_HEADER];
+  packetCodec c(buf,sizeof(buf),true);
+  c.field(myPlayerNum); c.field(gameState); c.field(currentMoveNum);
+  persist(c);
+  if(!c.ok) {
+    DEBUGLN("Game too large to save.");
+    return;
+  }
+  Store->save(buf,c.len);
+  saved=true;
+}
+
+/*
+ * Internal routine called when the hash of the game we received disagrees with our own. Returns
+ * true if the game is over because resync is off.
+ */
+bool baseGame::stateMismatch(void) {
+  DEBUG("State hash mismatch. Ours is:"); DEBUGLN(stateHash());
+  if(resync) {
+    requestResync();
+    return false;
+  }
+  fatalError("State hash mismatch error.");
+  return true;
+}
+
+//Types of frames handled by receiveFrame
+#define GAME_FRAMES (DISPATCH_TYPE(MOVE_PACKET) | DISPATCH_TYPE(RESULTS_PACKET) | DISPATCH_TYPE(LINK_PROFILE_PACKET) | \
+                     RESYNC_FRAMES)
+
+/*
+ * Internal routine that takes a move, results, or link profile frame from Radio->Inbox if one 
+ * is waiting. They come out in the order they arrived. Other types stay in the Inbox. Each packet
+ * within the frame is unpacked into either the Move or Results object. Normally there is just one 
+ * packet but with piggybackResults there may be a results packet followed by a move packet.
+ * 
+ * We may receive repeats, always with appAcks and otherwise whenever an acknowledgment was lost
+ * and our opponent sent something again. A repeated move is checked before it is unpacked so that
+ * it cannot overwrite a newer one we have not processed yet. The move #0 pass that may start our
+ * opponent's first turn is not a repeat. A move is always the last packet in a frame so we simply
+ * ignore the rest of the frame. Results only count if they are for our last move and we have not
+ * already accepted them. Resync packets are always alone in a frame.
+ */
+void baseGame::receiveFrame(void) {
+  uint8_t buf[MAX_FRAME_SIZE];
+  uint8_t len = sizeof(buf);
+  Radio->pump();
+  if(!Radio->Inbox.takeAny(GAME_FRAMES,buf,&len)) {
+    return;
+  }
+  lastHeard=millis();
+  uint16_t n;
+  bool pass;
+  uint8_t i=0;
+  while(i<len) {
+    uint8_t used=0;
+    switch(basePacket::frameType(buf+i)) {
+      case MOVE_PACKET:
+        n=basePacket::frameNumber(buf+i,len-i);
+        //Move #0 is the pass our opponent sends when we won the coin toss. See doOpponentsTurn.
+        pass= (n==0) && (gameState==OPPONENTS_TURN) && (currentMoveNum==1);
+        if(!pass && (n < ((gameState==MY_TURN) ? currentMoveNum+1 : currentMoveNum))) {
+          answerRepeat(n);
+          return;
+        }
+        if(moveArrived) {
+          return;   //a repeat of the one we are holding
+        }
+        if((used=Move->decode(buf+i,len-i))) {
+          journal(JOURNAL_RECEIVED,buf+i,used);
+          moveArrived=true;
+          if(perfectInformation && (Move->moveNum > lastMoveSent) && moveUnacked) {
+            moveUnacked=false;  //they could not have moved without our move
+            Radio->Rtt.endBackoff();
+          }
+        }
+        break;
+      case RESULTS_PACKET:
+        if((used=Results->decode(buf+i,len-i))) {
+          bool fresh= (Results->resultsNum==lastMoveSent) && (Results->resultsNum != lastResultsGot);
+          if(fresh && !retransmitted && !piggybackResults && !perfectInformation) {
+            //Only plain results come straight back so only they tell us how long a reply takes
+            Radio->Rtt.sample(micros()-exchangeStart);
+          }
+          if(fresh) {
+            journal(JOURNAL_RECEIVED,buf+i,used);
+            resultsArrived=true;
+            moveUnacked=false;
+            Radio->Rtt.endBackoff();
+            lastResultsGot=Results->resultsNum;
+          }
+        }
+        break;
+      case RESYNC_REQUEST_PACKET:
+      case RESYNC_PACKET:
+        handleResync(buf+i,len-i);
+        return;
+      case LINK_PROFILE_PACKET:
+        //Player 2 switches and echoes it on the new profile. Player 1 waits for the echo.
+        if((used=Packet.decode(buf+i,len-i))) {
+          uint8_t p=(uint8_t)Packet.subType;
+          if(myPlayerNum==1) {
+            linkEchoed= linkEchoed || (p==Policy.current);
+          } else if(Policy.apply(p) && Packet.send()) {
+            DEBUG("Link profile changed to "); DEBUGLN(p);
+          } else {
+            Policy.reset();
+          }
+        }
+        break;
+      default:
+        DEBUG("Got packet. Was wrong type '"); DEBUG(packetTypeStr[basePacket::frameType(buf+i)]);
+        DEBUGLN("', ignoring.");
+        break;
+    }
+    if(used==0) {
+      return;   //unknown or damaged, ignore the rest of the frame
+    }
+    i+=used;
+  }
+}
+
+/*
+ * Internal routine for handling my move. It calls Move->decideMyMove() which is a virtual method
+ * you will supply in your derived move class to actually decide what your move will be. Then this
+ * method transmits it and then waits for the other device to send us a "results" message.
+ * We then call Results->processResults() which is a virtual method you will supply in your derived
+ * results class. See the baseResults definition and comments in "TwoPlayerGame_base_packet.h"
+ * for an explanation of what is a result. 
+ * 
+ * In a perfect information game we predict our own results and process them right away unless 
+ * we think our move ended the game. In that case we wait for the official results.
+ */
+bool baseGame::doMyTurn(void) {
+  switch(phase) {
+    case START_PHASE:
+    case WAIT_LINK_PHASE:
+      if(adaptiveLink && (myPlayerNum==1) && !linkSettled()) {
+        return false;
+      }
+      Move->moveNum = currentMoveNum;
+      Move->hash = stateHash();   //before decideMyMove changes anything
+      Move->decideMyMove();
+      checkSilence();
+      if(perfectInformation) {
+        bool over=Results->predictResults(Move);
+        Move->predicted=Results->subType;
+        if(!deliverMove()) {
+          fatalError("Move too large for one frame");
+          return true;
+        }
+        if(!over) {
+          DEBUGLN("Predicted results.");
+          Results->processResults();
+          gameState=OPPONENTS_TURN;
+          currentMoveNum++;
+          return true;
+        }
+      } else if(!deliverMove()) {
+        fatalError("Move too large for one frame");
+        return true;
+      }
+      DEBUGLN("Waiting for results.");
+      nextPhase(WAIT_RESULTS_PHASE);
+      return false;
+    case WAIT_RESULTS_PHASE:
+      if(!resultsArrived) {
+        receiveFrame();
+      }
+      if(!resultsArrived) {
+        checkSilence();
+        retransmit();
+        return false;
+      }
+      resultsArrived=false;
+      if(Results->resultsNum != currentMoveNum) {
+        DEBUG("Results.resultsNum incorrect. Value is:"); DEBUG(Results->resultsNum);
+        DEBUG (" expected:"); DEBUGLN(currentMoveNum);
+        if(resync) {
+          requestResync();
+          return false;
+        }
+        fatalError("Results number mismatch error.");
+        return true;
+      }
+      if(Results->processResults()) { //returns true if the game ended
+        gameState=GAME_OVER;
+      } else {
+        gameState=OPPONENTS_TURN;     //otherwise it's our opponents turn
+      }
+      //now that I've got results, the move is complete so increment the move number.
+      currentMoveNum++;
+      if(hashCheck && !perfectInformation && (gameState==OPPONENTS_TURN) && (Results->hash!=stateHash())) {
+        DEBUG("Results hash incorrect. Value is:"); DEBUGLN(Results->hash);
+        stateMismatch();
+      }
+      return true;
+  }
+  return false;
 }
 
 /*
@@ -165,36 +1225,120 @@ void baseGame::doMyTurn(void) {
  * in your derived results class. It will decide the results of your opponent's move and will 
  * generate the results packet which we will then send to our opponent. See baseResults and the 
  * comments surrounding it to see what we mean by "results" in "TwoPlayerGame_base_packet.h".
+ * If piggybackResults is on, the results are held and sent along with our next move unless
+ * they ended the game. In a perfect information game they are not sent at all unless they
+ * ended the game or disagree with what our opponent predicted.
  */
-void baseGame::doOpponentsTurn(void) {
-  Move->require();  //wait indefinitely for your opponent's move
+bool baseGame::doOpponentsTurn(void) {
+  if(!moveArrived) {  //the move may have already come in along with our results
+    receiveFrame();
+  }
+  if(resultsArrived) {
+    //In a perfect information game our opponent only sends results for our last move
+    //if our prediction was wrong. Theirs are the official results.
+    resultsArrived=false;
+    if(perfectInformation && (Results->resultsNum+1 == currentMoveNum)) {
+      DEBUGLN("Prediction was overruled.");
+      if(Results->processResults()) {
+        gameState=GAME_OVER;
+        return true;
+      }
+    }
+  }
+  if(!moveArrived) {  //nothing yet from your opponent
+    checkSilence();
+    retransmit();
+    return false;
+  }
+  moveArrived=false;
   //if I won the coin toss then the other player passes by sending me move #0
   //so I have to adjust appropriately.
   if(Move->moveNum==0) {
     currentMoveNum=0;
   }
-  // if it's not an initial pass move and numbers don't match then warn
+  // if it's not an initial pass move and numbers don't match then warn or resync
   if( (Move->moveNum != currentMoveNum) && (Move->moveNum>0)) {
     DEBUG("Opponents move number incorrect. Value is:"); DEBUG(Move->moveNum);
     DEBUG(" expected:"); DEBUGLN(currentMoveNum);
+    if(resync) {
+      requestResync();
+      return false;
+    }
     fatalError("Opponents move number mismatch error.");
-    return;
+    return true;
+  }
+  if(hashCheck && (Move->moveNum>0) && (Move->hash != stateHash())) {
+    DEBUG("Opponents move hash incorrect. Value is:"); DEBUGLN(Move->hash);
+    return stateMismatch();
   }
   if(Results->generateResults(Move)) {  //returns true if the game ended as a result of your opponents move
     gameState=GAME_OVER;
   } else {
     gameState=MY_TURN;                  //otherwise now it's my turn
   };
-  Results->send();
+  Results->hash=stateHash();
+  if(perfectInformation && (gameState==MY_TURN) && (Results->subType==Move->predicted)) {
+    DEBUGLN("Prediction was correct. No results sent.");
+  } else if(piggybackResults && (gameState==MY_TURN)) {
+    resultsPending=true;                //send them with our next move
+  } else {
+    sendResults();
+  }
   //now that he has completed his move, I processed it and sent him his results,
   //I can now increment the move counter to count his move
   currentMoveNum++;
+  return true;
 }
 
 /*
  * internal routine to handle the end of game. It calls your virtual function "processGameOver"
  */
-void baseGame::gameOver(void) {
+bool baseGame::gameOver(void) {
+  #if(TPG_DEBUG)
+    Radio->Stats.print();
+    if(lowPower) {
+      Serial.print("Asleep "); Serial.print(Idle.percentAsleep()); 
+      Serial.print("% of the game, sleeps="); Serial.println(Idle.sleeps);
+    }
+  #endif
+  Radio->Inbox.clear();   //anything left over belongs to the game that just ended
+  if(Journal) {
+    Journal->flush();     //the game is over so nobody is waiting on us
+  }
   processGameOver();
+  Idle.reset();           //the next game starts its own count
   gameState=OFFERING_GAME;
+  return true;
+}
+
+/*
+ * Internal routine for when the other device has gone silent. Anything it left behind belongs
+ * to the game we are giving up on.
+ */
+bool baseGame::opponentLost(void) {
+  Radio->Inbox.clear();
+  if(Journal) {
+    Journal->flush();
+  }
+  processOpponentLost();
+  gameState=OFFERING_GAME;
+  return true;
+}
+
+/*
+ * Internal routine that records the start of a game in Journal. Everything needed to set up
+ * the same game again goes in: who we are, who moves first, the move number, and the settings 
+ * that change which packets are sent.
+ */
+void baseGame::journalStart(bool resumed) {
+  if(!Journal) {
+    return;
+  }
+  uint8_t flags= ((gameState==MY_TURN) ? JOURNAL_MY_TURN : 0) | (piggybackResults ? JOURNAL_PIGGYBACK : 0) |
+                 (perfectInformation ? JOURNAL_PERFECT : 0) | (hashCheck ? JOURNAL_HASH : 0) |
+                 (appAcks ? JOURNAL_APP_ACKS : 0) | (resumed ? JOURNAL_RESUMED : 0);
+  uint8_t buf[4];
+  packetCodec c(buf,sizeof(buf),true);
+  c.field(myPlayerNum); c.field(flags); c.field(currentMoveNum);
+  Journal->record(JOURNAL_START,buf,c.len);
 }
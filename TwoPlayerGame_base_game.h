@@ -16,13 +16,12 @@
  * 
  *    #include <TwoPlayerGame.h>
  *    #include "myGame.h" //all of your game specific code here
- *    #define IS_PLAYER_1 true; //change to false on one of the two devices
  *    
  *    myRadio Radio;      //Your custom Radio object derived from baseRadio
  *    myMove Move;        //Your custom Move object derived from base Move
  *    myResults Results;  //Your custom Results object derived from base Results
  *    //Create an instance of my game
- *    myGame Gamee(&Move, &Results, &Radio, IS_PLAYER_1);
+ *    myGame Game(&Move, &Results, &Radio);
  *    
  *    void setup() {
  *      Game.setup(); //One time initialization of everything
@@ -32,23 +31,33 @@
  *      Game.loopContents();
  *    }
  *    
- *  You should compile and upload this code to your device and then change IS_PLAYER_1 false
- *  and recompile and upload it to the other device. This is the ONLY difference in
- *  the software between your two devices.
+ *  If you want to do other things such as animation or audio while waiting on your opponent,
+ *  call "Game.step()" instead of "Game.loopContents()". It never waits on the radio. See below.
+ *    
+ *  You should compile and upload exactly the same code to both devices. When they find each other
+ *  the game engine decides which one is player 1. 
+ *  
+ *  Older programs pass a fourth parameter "IS_PLAYER_1" to the game constructor which is true on
+ *  one device and false on the other. That still works. The two devices then have to be built
+ *  separately and the offering and seeking steps described below are used instead of discovery.
  */
 /*
  * Enumerate various states in which the game engine can be. Define strings for debug purposes.
  */
 enum gameState_t {
-  OFFERING_GAME, SEEKING_GAME, MY_TURN, OPPONENTS_TURN,  GAME_OVER
+  OFFERING_GAME, SEEKING_GAME, MY_TURN, OPPONENTS_TURN,  GAME_OVER, OPPONENT_LOST
 };
-extern const char* gameStateStr[5];
+extern const char* gameStateStr[6];
 
 /*
  * This is the primary class that is the logic and game flow for the game engine. You will create
  * a derived class with your game for specific data and methods. 
  * 
  * The game logic is implemented as a state machine using gameState as follows:
+ *    0. If the game was constructed without isPlayer_1, gameState=OFFERING_GAME means the two devices
+ *        are discovering each other instead of steps 1 through 3. They exchange DISCOVER_PACKETs at
+ *        random times, decide which one is player 1, and player 1 does the coin flip. See discoverGame
+ *        in "TwoPlayerGame_base_game.cpp". Both devices may enter this state at the same time. 
  *    1. After initializing everything it goes into gameState=OFFERING_GAME. The radio will send
  *        multiple packets saying that it is offering a game and it waits for an accepting packet.
  *        If that fails after a specified amount of time it goes into gameState=SEEKING_GAME.
@@ -58,12 +67,25 @@ extern const char* gameStateStr[5];
  *        method to determine who goes first. The outcome of the flip is sent to the accepting player.
  *        If the flip was true, offering player goes first otherwise accepting player goes first.
  *    4. After a move is sent, a "Results" packet is sent back showing the results of your move.
- *        See the discussion on "Results" in "TwoPlayerGame_base_packet.h".
+ *        See the discussion on "Results" in "TwoPlayerGame_base_packet.h". If piggybackResults
+ *        is true, the results are held until the player who generated them has decided on their
+ *        own next move and then both are sent together in a single frame. If perfectInformation
+ *        is true, the player who moved predicts the results and they are only sent back if the game
+ *        is over or the prediction was wrong.
  *    5. The gameState alternates between MY_TURN and OPPONENTS_TURN until a player wins, ties,
  *        or resigns at which point gameState=GAME_OVER. Depending on your game design
- *        you may then reset gameState to OFFERING_GAME however if both devices enter that state
- *        simultaneously it is possible neither one accepts the others offer. Users 
- *        will have to coordinate and stagger their restart efforts.
+ *        you may then reset gameState to OFFERING_GAME. With offering and seeking, if both devices 
+ *        enter that state simultaneously it is possible neither one accepts the others offer and 
+ *        users will have to stagger their restart efforts. Discovery has no such problem.
+ *    6. If heartbeats is on and we are waiting on the other device but have heard nothing from it for
+ *        livenessDeadline milliseconds, gameState=OPPONENT_LOST. Your processOpponentLost method is
+ *        called and then gameState=OFFERING_GAME so that we look for a new game.
+ *    7. If resync is on and the two devices ever disagree about the move number, or hashCheck is on and 
+ *        they disagree about the state of the game, they exchange a snapshot of the game instead of 
+ *        giving up. See "resync" and "hashCheck" below.
+ *    8. If Store is set, the game is saved at the start of every turn. After a reset, setup picks the
+ *        saved game back up in the same state instead of calling initialize, and asks the other device
+ *        to resync. See "Store" below.
  *        
  * The class contains the following data and methods:
  *    uint16_t currentMoveNum;  
@@ -91,14 +113,133 @@ extern const char* gameStateStr[5];
  *      RF69HCW packet radio is available in "TwoPlayerGame_RF69HCW.h" and "TwoPlayerGame_RF69HCWcpp".
  *      
  *    uint8_t myPlayerNum;
- *      My player number either 1 or 2 computed by constructor based on isPlayer_1 parameter.    
+ *    uint8_t otherPlayerNum;
+ *      My player number and my opponent's, either 1 or 2. Computed by the constructor based on the 
+ *      isPlayer_1 parameter or by discovery. While discovering they are both zero.
+ *      
+ *    bool discovery;
+ *      True if the game was constructed without isPlayer_1 so that player numbers are decided at runtime.
+ *      
+ *    uint32_t deviceId;
+ *      A number that is different on every device, used by discovery to decide who is player 1. The 
+ *      higher one wins. On SAMD processors setup reads it from the chip's serial number. Anywhere else 
+ *      it is a random number. You may set it yourself before calling setup.
+ *      
+ *    bool piggybackResults;
+ *      Defaults to false. If you set it to true in your constructor or setup method, the results of 
+ *      your opponent's move are not sent right away. Instead they ride along in the same frame as your
+ *      next move. That cuts the number of radio exchanges per turn in half. The trade off is that your
+ *      opponent does not learn the results of their move until you have decided on yours. Results that
+ *      end the game are always sent immediately. Both devices MUST use the same setting.
+ *      
+ *    bool perfectInformation;
+ *      Defaults to false. Set it to true in your constructor or setup method if both players can see
+ *      everything, as in tic-tac-toe or checkers. You MUST then implement Results->predictResults. 
+ *      After you move, the engine predicts your results and processes them without waiting. Your 
+ *      opponent still generates results but only sends them if they end the game or if they disagree
+ *      with your prediction. If you predicted that your move ends the game, the engine waits for the 
+ *      official results as usual. Both devices MUST use the same setting.
+ *      
+ *    bool appAcks;
+ *      Defaults to false. If you set it to true, moves and results are sent with Radio->sendNoAck 
+ *      so that the radio does not transmit a link-level acknowledgment for every one of them. Instead
+ *      the reply itself is the acknowledgment. Results acknowledge a move. In a perfect information
+ *      game the next move does. If no reply arrives, the engine sends our move again after 
+ *      Radio->Rtt.timeout() milliseconds, doubling the wait each time. If our 
+ *      opponent sends a move we have already handled, our reply must have been lost so we send it 
+ *      again. Offering, seeking, and results that end the game always use link-level acknowledgments. 
+ *      Both devices MUST use the same setting.
+ *      
+ *    bool adaptiveLink;
+ *      Defaults to false. If you set it to true, player 1 uses "Policy" at the start of each of its turns
+ *      to choose radio settings based on how well the link has been working. If they should change, it 
+ *      sends a LINK_PROFILE_PACKET with the new profile number as its subtype and once it is acknowledged 
+ *      both devices switch. Player 2 echoes the packet on the new profile and player 1 waits for the 
+ *      echo before sending its move. Every game starts over at the home profile. If either device hears nothing 
+ *      for LINK_SILENCE_TIMEOUT milliseconds, or a send fails, it assumes the two have ended up on 
+ *      different settings and goes back to the home profile. Both devices MUST use the same setting.
+ *      Only radios with more than one modulation or power level benefit.
+ *      
+ *    linkPolicy Policy;
+ *      Decides which radio settings to use when adaptiveLink is on. You may change its thresholds in your
+ *      setup method. See "TwoPlayerGame_link_policy.h".
+ *      
+ *    bool heartbeats;
+ *      Defaults to false. Without it, if the other device loses power we wait for its move forever. If you
+ *      set it to true, the engine sends a tiny HEARTBEAT_PACKET every heartbeatInterval milliseconds once 
+ *      the two devices have found each other, and gives up on the other device if nothing at all arrives 
+ *      from it for livenessDeadline milliseconds while we are waiting on it. Heartbeats are sent by "step()"
+ *      and by "service()". Any of your own code that can run longer than livenessDeadline, most importantly
+ *      the loop in your decideMyMove that waits for buttons, MUST call service() over and over. Otherwise 
+ *      the other device will decide you are gone while you are thinking. Heartbeats are counted in 
+ *      Radio->Stats. Both devices MUST use the same setting.
+ *      
+ *    uint16_t heartbeatInterval;
+ *    uint16_t livenessDeadline;
+ *      Milliseconds between heartbeats and of silence before the other device is considered lost.
+ *      Defaults are HEARTBEAT_INTERVAL and LIVENESS_DEADLINE. The deadline should be several intervals.
+ *      A lost device is always noticed within livenessDeadline milliseconds plus the time of one step.
+ *      
+ *    bool resync;
+ *      Defaults to false, in which case a move or results with the wrong number or hash is a fatal error. If you
+ *      set it to true you MUST implement snapshot and restore. When either device notices the numbers 
+ *      disagree it sends a RESYNC_REQUEST_PACKET holding its move number. The device that is further 
+ *      along has the history that counts. If they are even it is the one that did not just resume a saved
+ *      game, or player 1 if that doesn't decide it. It answers with a RESYNC_PACKET 
+ *      holding its move number, whose turn it is, and your snapshot of the game. If the device that was
+ *      asked is the one behind, it sends a RESYNC_REQUEST_PACKET of its own instead. The other device
+ *      calls restore and both carry on from there. If the device with the history was waiting on results 
+ *      for its move, it sends the move again right after the snapshot. A request that goes unanswered is 
+ *      sent again after Radio->Rtt.timeout() milliseconds, doubling the wait each time. Both devices 
+ *      MUST use the same setting.
+ *      
+ *    bool hashCheck;
+ *      Defaults to false. If you set it to true you MUST implement stateHash. Every move carries the 
+ *      sender's stateHash from the start of its turn and every results packet carries the sender's 
+ *      stateHash just after generateResults. The receiver compares it with its own at the same point
+ *      in the game. If they differ the two devices have drifted apart even though the move numbers agree,
+ *      so we resync right away if resync is on or call fatalError if not. That catches the problem on 
+ *      the very next packet instead of many moves later. Results are not checked in a perfect information 
+ *      game because predicted results are processed before the official ones. Both devices MUST use the
+ *      same setting.
+ *      
+ *    baseStore* Store;
+ *      Defaults to NULL. If you point it at a store object in your constructor and resync is on, the 
+ *      game is saved in the store at the start of every turn: whose turn it is, the move number, the
+ *      player numbers, and whatever your persist method adds. When setup finds a saved game it calls 
+ *      your resume method instead of initialize and goes straight back to that turn. Whatever happened
+ *      after the save, on either device, is then sorted out by a resync, which is usually finished 
+ *      before the screen has been redrawn. If the other device is looking for a new game instead, the 
+ *      saved one is abandoned and initialize is called after all. The save is forgotten at the end of 
+ *      every game. setup sets Store to NULL if its begin method fails. See "TwoPlayerGame_base_store.h"
+ *      and "TwoPlayerGame_file_store.h".
  *      
+ *    baseJournal* Journal;
+ *      Defaults to NULL. If you point it at a journal object in your constructor, the start of every game 
+ *      and every move and results packet sent or received is recorded in it with the time it happened.
+ *      Records wait in RAM and are only written out by "idle" when nothing else needs doing, and at the 
+ *      end of each game, so the journal never holds up a turn. setup sets Journal to NULL if its begin 
+ *      method fails. See "TwoPlayerGame_base_journal.h", "TwoPlayerGame_file_journal.h", and the 
+ *      "journal_replay" utility which plays a journal back.
+ *      
+ *    bool lowPower;
+ *      Defaults to false. If you set it to true, "loopContents" puts the processor to sleep between steps
+ *      instead of spinning and calls your dimDisplay method when it has been waiting a long time. 
+ *      See "idle" below and "TwoPlayerGame_idle_policy.h".
+ *      
+ *    idlePolicy Idle;
+ *      Sleeps, decides when to dim, and counts how much of each game was spent asleep. You may change
+ *      Idle.dimDelay in your setup method. Idle.percentAsleep() in your processGameOver method tells you
+ *      how the game went. The count starts over after each game.
+ *      
+ *    baseGame(baseMove* move_ptr, baseResults* results_ptr, baseRadio* radio_ptr);
  *    baseGame(baseMove* move_ptr, baseResults* results_ptr, baseRadio* radio_ptr, bool isPlayer_1);
- *      Constructor for the game object. See the sample program code at the top of this file.  
- *      You should create a constructor for your derived game class as follows:
+ *      Constructors for the game object. See the sample program code at the top of this file.  
+ *      The first one uses discovery. The second one fixes the player numbers. You should create 
+ *      a constructor for your derived game class as follows:
  * 
- *        myGame(myMove* move_ptr, myResults* results_ptr, myRadio* radio_ptr, bool isPlayer_1)
- *            : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) 
+ *        myGame(myMove* move_ptr, myResults* results_ptr, myRadio* radio_ptr)
+ *            : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr) 
  *        {
  *          //Perform any other initialization here.
  *        };
@@ -111,6 +252,26 @@ extern const char* gameStateStr[5];
  *    virtual void loopContents(void);  
  *      Call this method inside your main "loop()" function. See sample code above. If you create 
  *      a virtual method in your class you MUST call baseGame::loopContents(); from it.
+ *      It calls "step()" over and over until the current gameState has been completely handled.
+ *      In other words it waits for the radio exactly as the engine always has.
+ *      
+ *    bool step(void);
+ *      Does whatever work the current gameState needs right now and returns immediately. It never
+ *      waits for a packet. Each state is broken into small phases which advance when the expected
+ *      packet arrives or a timer runs out. Returns true when the current gameState has been
+ *      completely handled and gameState has moved on. You may call this from your main "loop()"
+ *      instead of "loopContents()" if you want to do other things while waiting.
+ *      
+ *    void service(void);
+ *      Only used if heartbeats is on. Sends a heartbeat if one is due and notices anything received. Call
+ *      it from any of your code that can run a long time. It never waits.
+ *      
+ *    void idle(void);
+ *      Called by "loopContents()" each time step returns false. If lowPower is on it sleeps until the 
+ *      next interrupt and dims or brightens the display as needed. A received packet or your userActive 
+ *      method returning true brightens it. Whether or not lowPower is on, it is also where Journal is 
+ *      written out and your idleWork method is called. It doesn't sleep while idleWork has more to
+ *      do. If you call step() yourself you may call this between steps.
  *      
  *    virtual void initialize(void);
  *      This method is called any time a new game starts. If you have your own virtual
@@ -118,9 +279,9 @@ extern const char* gameStateStr[5];
  *      
  *    bool coinFlip(void);
  *      You MUST implement this pure virtual method in your derived game class. It determines 
- *      who goes first. The Offering player calls this method. If it returns true then the offering 
- *      player goes first, otherwise the accepting player goes first. Outcome of the flip is sent 
- *      to the accepting player via a COIN_FLIP_PACKET.
+ *      who goes first. The Offering player, or player 1 with discovery, calls this method. If it 
+ *      returns true then that player goes first, otherwise the other player goes first. Outcome of 
+ *      the flip is sent to the other player via a COIN_FLIP_PACKET.
  *      
  *    void processGameOver(void);
  *      You MUST implement this method in your derived game class. It will be called at the end
@@ -128,28 +289,224 @@ extern const char* gameStateStr[5];
  *      
  *    void fatalError (const char* s);
  *      You MUST implement this method in your derived game class. It would only be called in the 
- *      event of an unrecoverable error such as failure to receive acknowledgment of a data packet 
- *      or some other programming logic error.
+ *      event of an unrecoverable error such as failure to receive acknowledgment while accepting a
+ *      game or some other programming logic error. A move or results that are never acknowledged are 
+ *      not fatal. They are sent again and the other device ignores any duplicates.
  *      
  *    void processFlip(bool coin){};
  *      Used by accepting player to process an incoming COIN_FLIP_PACKET. Base method does nothing.
  *      You may optionally override this virtual to print a message or take other action.
  *      
  *    void foundGame(void) {};
- *      Used by accepting player to print a message that a game has been found and we are waiting
- *      on the offering player to do the coin toss.
+ *      Used by accepting player, or player 2 with discovery, to print a message that a game has been 
+ *      found and we are waiting on the other player to do the coin toss.
+ *      
+ *    void playerElected(void) {};
+ *      Called on both devices when discovery has decided which one is player 1. myPlayerNum and
+ *      otherPlayerNum are now valid. Base method does nothing. Override it if anything in your
+ *      game depends on the player number. It is not called if you passed isPlayer_1 to the constructor.
+ *      
+ *    void snapshot(packetCodec& c) {};
+ *      Only used if resync is on, in which case you MUST implement it. List the state of the game as 
+ *      this device sees it using c.field() exactly as a packet's "fields" method does. It must describe
+ *      the game after every move before currentMoveNum has been completely handled. If movePending()
+ *      is true your move currentMoveNum is waiting on results and MUST be left out because it will be 
+ *      sent again. Everything must fit in one frame along with a 4 byte header. See "TwoPlayerGame_packet_codec.h".
+ *      
+ *    bool restore(packetCodec& c) {return false;};
+ *      Only used if resync is on, in which case you MUST implement it. Read the other device's snapshot
+ *      with c.field() and bring your own game into agreement with it. Remember it describes the game 
+ *      from the other side. For example in Battleship its shots are shots at your ships. Read every 
+ *      field and check c.ok before changing anything. Return true if the snapshot was used, false if it
+ *      was damaged in which case we ask again. currentMoveNum and gameState have already been set to
+ *      agree with the other device. With hashCheck on you must also bring your stateHash up to date.
+ *      
+ *    void persist(packetCodec& c) {};
+ *      Only used if Store is set, in which case you MUST implement it. List everything needed to pick 
+ *      the game up again after a reset using c.field(). Unlike a snapshot it is the game as this device
+ *      sees it, including secrets like where your ships are. It is called at the start of every turn
+ *      so you never have a move waiting on results. It must fit in STORE_SLOT_SIZE-10 bytes.
+ *      
+ *    bool resume(packetCodec& c) {return false;};
+ *      Only used if Store is set, in which case you MUST implement it. Called by setup in place of
+ *      initialize to read back what persist wrote. myPlayerNum, otherPlayerNum, currentMoveNum, and
+ *      gameState have already been set. playerElected is not called. Check c.ok and anything else
+ *      you can, bring your stateHash up to date, and draw the screen. Return false if the saved game 
+ *      can't be used and a new one is started instead.
+ *      
+ *    bool movePending(void);
+ *      Returns true if our move has been sent and we are waiting on its results. Your snapshot must
+ *      leave that move out.
+ *      
+ *    uint32_t stateHash(void) {return 0;};
+ *      Only used if hashCheck is on, in which case you MUST implement it. Return a hash of everything
+ *      both players know about the game. It must be the same on both devices whenever they agree, so
+ *      anything only one player knows, like where your own ships are, must be left out. Update it a 
+ *      little at a time in generateResults and processResults, or in decideMyMove for your own move, 
+ *      rather than working it out from scratch. The engine reads it at the start of your turn before
+ *      decideMyMove and just after generateResults. See "TwoPlayerGame_zobrist_hash.h" for an easy way.
+ *      
+ *    void processOpponentLost(void) {};
+ *      Only used if heartbeats is on. Called when the other device has gone silent. Base method does 
+ *      nothing. Override it to tell the user. The engine then looks for a new game.
+ *      
+ *    void dimDisplay(bool dim) {};
+ *      Only used if lowPower is on. Called with true when we have been waiting Idle.dimDelay milliseconds
+ *      and with false when it is time to brighten again. Base method does nothing. Override it to turn
+ *      down your backlight.
+ *      
+ *    bool userActive(void) {return false;};
+ *      Only used if lowPower is on. Return true if the user is pressing a button so that a dimmed display
+ *      brightens. Base method returns false.
+ *      
+ *    bool idleWork(void) {return false;};
+ *      Called by idle each time the engine is waiting. Do a few milliseconds of background work here,
+ *      for example gameSearch::ponder while your opponent decides their move. Return true if there
+ *      is more to do so that idle doesn't sleep. Base method does nothing and returns false.
  *      
  *    gameState_t gameState;    
  *      The internal state of the game engine. Legal values are: OFFERING_GAME, SEEKING_GAME, 
- *      MY_TURN, OPPONENTS_TURN, and GAME_OVER.
- *      
- *    void offeringGame(void);
- *    void seekingGame(void);
- *    void doMyTurn(void);
- *    void doOpponentsTurn(void);
- *    void gameOver(void); 
- *      These internal private methods handle each of the game states.
+ *      MY_TURN, OPPONENTS_TURN, GAME_OVER, and OPPONENT_LOST.
+ *      
+ *    bool offeringGame(void);
+ *    bool seekingGame(void);
+ *    bool discoverGame(void);
+ *    bool doMyTurn(void);
+ *    bool doOpponentsTurn(void);
+ *    bool gameOver(void); 
+ *    bool opponentLost(void);
+ *      These internal private methods handle each of the game states. Each one is called by "step()"
+ *      and returns true when its state is finished. They keep track of where they are using "phase".
+ *      
+ *    bool sendMove(void);
+ *      Internal routine that sends our move, along with any pending results if piggybackResults is on.
+ *      
+ *    bool deliverMove(void);
+ *      Internal routine that calls sendMove. If the move is never acknowledged it is sent again later 
+ *      instead of ending the game. Returns false only if the move is too large for a frame.
+ *      
+ *    bool awaitsReply(void);
+ *      Internal routine that returns true if our opponent answers a move right away, so we should send
+ *      it again if no answer comes. That is always true with appAcks. Otherwise only plain results do.
+ *      
+ *    void sendResults(void);
+ *      Internal routine that sends the results of our opponent's move by themselves.
+ *      
+ *    bool transmit(uint8_t* buf, uint8_t len);
+ *      Internal routine that sends a frame with or without a link-level acknowledgment depending on appAcks.
+ *      
+ *    void retransmit(void);
+ *    void answerRepeat(uint16_t n);
+ *      Internal routines used by appAcks and when an acknowledgment is lost. The first sends our move 
+ *      again if it has not been acknowledged or answered in time. The second sends our reply again when 
+ *      our opponent repeats move number "n".
+ *      
+ *    void sendDiscover(void);
+ *    bool pollDiscovery(void);
+ *    void heardDiscover(uint32_t id, uint32_t theirPeer);
+ *    void setPlayer(uint8_t n);
+ *    static uint32_t uniqueDeviceId(void);
+ *    uint16_t jitter(uint16_t n);
+ *    uint32_t peerId, toldId, jitterState, discoveryTimer;
+ *    uint16_t discoveryWindow, discoveryWait;
+ *      Internal routines and data used by discovery. See the comments in "TwoPlayerGame_base_game.cpp".
+ *      
+ *    bool engaged(void);
+ *    uint32_t lastBeat, heardCount;
+ *      Internal routine and data used by heartbeats. The first returns true if we have found the other 
+ *      device and so should send heartbeats. The others are when we last sent one and Radio->Stats.received
+ *      when we last looked.
+ *      
+ *    void requestResync(void);
+ *    bool awaitResync(void);
+ *    bool handleResync(uint8_t* buf, uint8_t len);
+ *    void sendSnapshot(void);
+ *    bool resyncing;
+ *    uint32_t resyncTimer;
+ *      Internal routines and data used by resync. The first asks for a snapshot. The second is called by
+ *      "step()" instead of the routine for the current state while we wait for one and returns true once 
+ *      it has been restored. The third handles a RESYNC_REQUEST_PACKET or RESYNC_PACKET and returns true 
+ *      if it restored a snapshot. The fourth answers a request. The data is whether we are waiting on a 
+ *      snapshot and when we last asked for one.
+ *      
+ *    bool resumeGame(void);
+ *    void saveGame(void);
+ *    bool resuming;
+ *    bool saved;
+ *      Internal routines and data used by Store. The first picks up a saved game and returns true if 
+ *      there was one. The second saves the game at the start of a turn or forgets it once the game is
+ *      over. The data is whether we are waiting on the resync that follows resuming a game and whether 
+ *      there is a save to forget.
+ *      
+ *    void journalStart(bool resumed);
+ *    void journal(journalRecord_t kind, const uint8_t* buf, uint8_t len);
+ *      Internal routines used by Journal. The first records the start of a game or of a saved game we
+ *      "resumed". The second records one packet if there is a Journal.
+ *      
+ *    bool stateMismatch(void);
+ *      Internal routine called when a hash disagrees. Asks for a resync or calls fatalError. Returns
+ *      true if it called fatalError.
+ *      
+ *    void wake(void);
+ *    uint32_t lastReceived;
+ *      Internal routine and data used by lowPower. The first brightens the display if it was dimmed and 
+ *      starts the dim timer over. The second is Radio->Stats.received when we last looked.
+ *      
+ *    void receiveFrame(void);
+ *      Internal routine that takes a frame from Radio->Inbox if one is waiting and unpacks the move and/or 
+ *      results packets within it into Move and Results. Sets moveArrived or resultsArrived.
+ *      
+ *    bool resultsPending;
+ *    bool moveArrived;
+ *    bool resultsArrived;
+ *      Internal flags for results waiting to be sent and packets waiting to be processed.
+ *      
+ *    void newGame(void);
+ *      Internal routine that clears the flags and saved frames left over from the previous game.
+ *      
+ *    bool adaptLink(void);
+ *    bool linkSettled(void);
+ *    bool linkEchoed;
+ *    void resendAtHome(void);
+ *    void checkSilence(void);
+ *    uint32_t lastHeard;
+ *    bool homeRetry;
+ *    uint32_t homeRetryStart;
+ *      Internal routines and data used by adaptiveLink. The first asks Policy whether to change
+ *      profiles and tells the other device. The second calls it at the start of player 1's turn
+ *      and then waits until "linkEchoed" shows the other device has switched too. The third goes 
+ *      back to the home profile and sets "homeRetry" so that retransmit sends our move once per 
+ *      step until it gets through or enough time has passed since "homeRetryStart". The fourth 
+ *      goes back to the home profile if we haven't heard anything since "lastHeard" for too long.
+ *      
+ *    basePacket Packet;
+ *    uint8_t phase;
+ *    uint8_t tries;
+ *    uint32_t phaseStart;
+ *    uint32_t stateStart;
+ *    gameState_t phaseState;
+ *      Internal data used by "step()" to remember which phase of a state we are in, how many times
+ *      we have tried it, and when the phase and the state began.
+ *      
+ *    uint32_t exchangeStart;
+ *      Time in microseconds when we sent something we expect a reply to. The time it takes for the
+ *      reply to arrive is given to Radio->Rtt.
+ *      
+ *    uint8_t moveFrame[MAX_FRAME_SIZE];
+ *    uint8_t resultsFrame[MAX_FRAME_SIZE];
+ *    uint8_t moveFrameLen, resultsFrameLen;
+ *    uint16_t lastMoveSent, lastResultsSent, lastResultsGot;
+ *    bool moveUnacked;
+ *    uint32_t ackTimer, resultsTimer;
+ *    bool retransmitted;
+ *      Internal data used to send things again. Copies of the last frame holding our move and the last 
+ *      frame holding only results, the numbers of what they contain, whether our move still needs an
+ *      answer, when each was last sent, and whether we had to send our move more than once.
  */
+//Default heartbeat settings in milliseconds
+#define HEARTBEAT_INTERVAL 2000
+#define LIVENESS_DEADLINE  20000
+
 class baseGame {
   public:
     uint16_t currentMoveNum; 
@@ -158,9 +515,29 @@ class baseGame {
     baseRadio* Radio;
     uint8_t myPlayerNum;      //For initializing my radio
     uint8_t otherPlayerNum;   //Destination of our transmissions
+    bool discovery;           //Player numbers are decided at runtime
+    uint32_t deviceId;        //Different on every device, decides who is player 1
+    bool piggybackResults;    //Send results in the same frame as our next move
+    bool perfectInformation;  //Both sides predict results so they are rarely sent
+    bool appAcks;             //Replies acknowledge moves instead of the radio
+    bool adaptiveLink;        //Adjust radio settings to the link quality
+    linkPolicy Policy;        //Decides which radio settings to use
+    bool lowPower;            //Sleep between steps and dim the display while waiting
+    idlePolicy Idle;          //Sleeps and counts time asleep
+    bool heartbeats;          //Send heartbeats and give up on a silent opponent
+    uint16_t heartbeatInterval; //milliseconds between heartbeats
+    uint16_t livenessDeadline;  //milliseconds of silence before giving up
+    bool resync;              //Exchange a snapshot instead of giving up when move numbers disagree
+    bool hashCheck;           //Send a hash of the game with every move and results
+    baseStore* Store;         //Where the game is saved so it survives a reset
+    baseJournal* Journal;     //Where every game is recorded
+    baseGame(baseMove* move_ptr, baseResults* results_ptr, baseRadio* radio_ptr);
     baseGame(baseMove* move_ptr, baseResults* results_ptr, baseRadio* radio_ptr, bool isPlayer_1);
     virtual void setup(void); 
     virtual void loopContents(void);
+    bool step(void);
+    void service(void);
+    void idle(void);
   protected:
     virtual void initialize(void){gameState=OFFERING_GAME;};
     virtual bool coinFlip(void)=0;
@@ -168,14 +545,109 @@ class baseGame {
     virtual void fatalError(const char* s)=0;
     virtual void processFlip(bool coin) {};
     virtual void foundGame(void) {};
+    virtual void playerElected(void) {};
+    virtual void snapshot(packetCodec& c) {};
+    virtual bool restore(packetCodec& c) {return false;};
+    virtual void persist(packetCodec& c) {};
+    virtual bool resume(packetCodec& c) {return false;};
+    bool movePending(void);
+    virtual uint32_t stateHash(void) {return 0;};
+    virtual void processOpponentLost(void) {};
+    virtual void dimDisplay(bool dim) {};
+    virtual bool userActive(void) {return false;};
+    virtual bool idleWork(void) {return false;};
     gameState_t gameState;    //The internal state of the game engine, see definitions above
   private:
     //Internal routines that handle each of the various states of the engine
-    void offeringGame(void);
-    void seekingGame(void);
-    void doMyTurn(void);
-    void doOpponentsTurn(void);
-    void gameOver(void); 
+    bool offeringGame(void);
+    bool seekingGame(void);
+    bool discoverGame(void);
+    bool doMyTurn(void);
+    bool doOpponentsTurn(void);
+    bool gameOver(void); 
+    bool opponentLost(void);
+    bool sendMove(void);
+    bool deliverMove(void);
+    bool awaitsReply(void) {return appAcks || !(piggybackResults || perfectInformation);};
+    void sendResults(void);
+    bool transmit(uint8_t* buf, uint8_t len);
+    void retransmit(void);
+    void answerRepeat(uint16_t n);
+    void receiveFrame(void);
+    bool resultsPending;      //Results generated but not yet sent
+    bool moveArrived;         //Move received but not yet processed
+    bool resultsArrived;      //Results received but not yet processed
+    //Internal data used by step() to keep track of where we are within a state
+    basePacket Packet;        //handshake packets while offering or seeking
+    uint8_t phase;
+    uint8_t tries;
+    uint32_t phaseStart;
+    uint32_t stateStart;
+    gameState_t phaseState;
+    uint32_t exchangeStart;   //micros() when we sent something that needs a reply
+    void nextPhase(uint8_t p) {phase=p; phaseStart=millis();};
+    //Internal data used to send things again
+    uint8_t moveFrame[MAX_FRAME_SIZE];    //last frame holding our move
+    uint8_t resultsFrame[MAX_FRAME_SIZE]; //last frame holding only results
+    uint8_t moveFrameLen;
+    uint8_t resultsFrameLen;
+    uint16_t lastMoveSent;    //number of the move in moveFrame
+    uint16_t lastResultsSent; //number of the results in resultsFrame
+    uint16_t lastResultsGot;  //number of the last results we accepted
+    bool moveUnacked;         //moveFrame has not been answered yet
+    uint32_t ackTimer;        //when moveFrame was last sent
+    uint32_t resultsTimer;    //when resultsFrame was last sent
+    bool retransmitted;       //moveFrame was sent more than once
+    void newGame(void);
+    //Internal routines and data used by adaptiveLink
+    bool adaptLink(void);
+    bool linkSettled(void);
+    bool linkEchoed;          //player 2 has echoed our new link profile
+    void resendAtHome(void);
+    void checkSilence(void);
+    uint32_t lastHeard;       //when we last received anything
+    bool homeRetry;           //resending our move once per step at the home profile
+    uint32_t homeRetryStart;  //when we went home
+    //Internal routine and data used by heartbeats
+    bool engaged(void);
+    uint32_t lastBeat;        //when we last sent a heartbeat
+    uint32_t heardCount;      //Radio->Stats.received when we last looked
+    //Internal routines and data used by resync
+    void requestResync(void);
+    bool awaitResync(void);
+    bool handleResync(uint8_t* buf, uint8_t len);
+    void sendSnapshot(void);
+    bool stateMismatch(void);
+    bool resyncing;           //waiting on a snapshot
+    uint32_t resyncTimer;     //when we last asked for one
+    //Internal routines and data used by Store
+    bool resumeGame(void);
+    void saveGame(void);
+    bool resuming;            //waiting on the resync after resuming a saved game
+    bool saved;               //Store holds a game that must be forgotten when it ends
+    //Internal routines used by Journal
+    void journalStart(bool resumed);
+    void journal(journalRecord_t kind, const uint8_t* buf, uint8_t len) {
+      if(Journal) {
+        Journal->record(kind,buf,len);
+      }
+    };
+    //Internal routine and data used by lowPower
+    void wake(void);
+    uint32_t lastReceived;    //Radio->Stats.received when we last looked
+    //Internal routines and data used by discovery
+    void sendDiscover(void);
+    bool pollDiscovery(void);
+    void heardDiscover(uint32_t id, uint32_t theirPeer);
+    void setPlayer(uint8_t n);
+    static uint32_t uniqueDeviceId(void);
+    uint16_t jitter(uint16_t n);
+    uint32_t peerId;          //ID of the device we last heard from
+    uint32_t toldId;          //peer ID in the last DISCOVER_PACKET we sent
+    uint32_t jitterState;     //random number generator state
+    uint32_t discoveryTimer;  //when we last sent a DISCOVER_PACKET
+    uint16_t discoveryWindow; //random wait before the next one is up to this long
+    uint16_t discoveryWait;   //chosen wait before the next one
 };
 
 #endif //not defined _TwoPlayerGame_base_game_h_
@@ -0,0 +1,48 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * Source code for the baseJournal class. See "TwoPlayerGame_base_journal.h" for details.
+ */
+#include "TwoPlayerGame_base_journal.h"
+
+void baseJournal::record(journalRecord_t kind, const uint8_t* data, uint8_t len) {
+  if(used+JOURNAL_HEADER+len > JOURNAL_BUFFER_SIZE) {
+    dropped++;
+    return;
+  }
+  uint32_t now=millis();
+  uint32_t gap=now-lastRecord;
+  if(gap > 0xffff) {
+    gap=0xffff;
+  }
+  if(used==0) {
+    firstWaiting=now;
+  }
+  lastRecord=now;
+  buf[used]=kind;
+  buf[used+1]=gap & 0xff;
+  buf[used+2]=gap >> 8;
+  buf[used+3]=len;
+  memcpy(buf+used+JOURNAL_HEADER,data,len);
+  used+=JOURNAL_HEADER+len;
+  records++;
+}
+
+/*
+ * If the write fails the records are lost. Keeping them would only fill the buffer and
+ * then we would lose the ones after them instead.
+ */
+void baseJournal::flush(void) {
+  if(used==0) {
+    return;
+  }
+  if(!append(buf,used)) {
+    failed+=used;
+  }
+  used=0;
+}
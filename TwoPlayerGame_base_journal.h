@@ -0,0 +1,109 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_base_journal_h_
+#define _TwoPlayerGame_base_journal_h_
+#include <Arduino.h>
+/*
+ * Base class for an object that keeps a record of every game played so that a problem seen in the
+ * field can be reproduced later. See "baseGame::Journal". A derived class "fileJournal" that appends
+ * to a file on the Arcada file system is in "TwoPlayerGame_file_journal.h". You may create your own
+ * for other kinds of memory. Like the radio, you create an instance and give its address to the game.
+ *
+ * The game engine records the start of each game and every move and results packet it sends or
+ * receives, exactly as it went over the air. Retransmissions and repeats are left out. Records are
+ * only ever added to the end. Each one holds:
+ *
+ *    byte 0      kind, one of the journalRecord_t values below
+ *    bytes 1-2   milliseconds since the record before it, at most 65535
+ *    byte 3      length of the data
+ *    bytes 4-    the data
+ *
+ * For JOURNAL_SENT and JOURNAL_RECEIVED the data is a single encoded packet. A frame holding results
+ * and a move together becomes two records, results first. For JOURNAL_START it is our player number,
+ * the JOURNAL_ flags below, and the 16-bit move number the game starts from, least significant byte
+ * first. "utilities/journal_replay" plays a journal back through the game engine.
+ *
+ * Writing to flash or an SD card can take several milliseconds so records are not written as they
+ * happen. They are collected in a buffer in RAM and the game engine writes them out in its idle time
+ * between steps when nothing has arrived for it to handle. If the buffer fills up before then, new
+ * records are thrown away rather than making the game wait.
+ *
+ * Your derived class MUST implement these two methods.
+ *
+ *    bool begin(void);
+ *      Called once by baseGame::setup before anything is written. Returns true if the memory is ready.
+ *
+ *    bool append(const uint8_t* buf, uint16_t len);
+ *      Adds "len" bytes to the end of the journal. Returns true if successful.
+ *
+ *    uint32_t records;
+ *    uint32_t dropped;
+ *      Number of records added to the buffer and number thrown away because it was full.
+ *
+ *    uint32_t failed;
+ *      Number of bytes lost because append failed.
+ *
+ *    void record(journalRecord_t kind, const uint8_t* data, uint8_t len);
+ *      Adds a record to the buffer. Never waits.
+ *
+ *    bool due(void);
+ *      Returns true if the buffer should be written out. That is when it is at least JOURNAL_FLUSH_AT
+ *      bytes full or the oldest record in it has waited JOURNAL_FLUSH_DELAY milliseconds.
+ *
+ *    void flush(void);
+ *      Writes out everything in the buffer.
+ *
+ *    uint8_t buf[JOURNAL_BUFFER_SIZE];
+ *    uint16_t used;
+ *    uint32_t lastRecord;
+ *    uint32_t firstWaiting;
+ *      Internal data. The buffer, the number of bytes in it, millis() of the last record, and millis()
+ *      of the oldest record not yet written.
+ */
+
+//Bytes of records held in RAM between writes
+#define JOURNAL_BUFFER_SIZE 512
+//Write when the buffer is this full...
+#define JOURNAL_FLUSH_AT 256
+//...or the oldest record has waited this many milliseconds
+#define JOURNAL_FLUSH_DELAY 2000
+//Bytes in front of the data of each record
+#define JOURNAL_HEADER 4
+
+enum journalRecord_t {
+  NO_JOURNAL_RECORD, JOURNAL_START, JOURNAL_SENT, JOURNAL_RECEIVED
+};
+
+//Bits in the flags of a JOURNAL_START record
+#define JOURNAL_MY_TURN         0x01  //we move first
+#define JOURNAL_PIGGYBACK       0x02  //piggybackResults
+#define JOURNAL_PERFECT         0x04  //perfectInformation
+#define JOURNAL_HASH            0x08  //hashCheck
+#define JOURNAL_APP_ACKS        0x10  //appAcks
+#define JOURNAL_RESUMED         0x20  //a saved game picked up after a reset
+
+class baseJournal {
+  public:
+    uint32_t records;
+    uint32_t dropped;
+    uint32_t failed;
+    baseJournal(void) {records=dropped=failed=0; used=0; lastRecord=firstWaiting=0;};
+    virtual bool begin(void)=0;
+    virtual bool append(const uint8_t* buf, uint16_t len)=0;
+    void record(journalRecord_t kind, const uint8_t* data, uint8_t len);
+    bool due(void) {
+      return (used >= JOURNAL_FLUSH_AT) || (used && ((millis()-firstWaiting) >= JOURNAL_FLUSH_DELAY));
+    };
+    void flush(void);
+  private:
+    uint8_t buf[JOURNAL_BUFFER_SIZE];
+    uint16_t used;            //bytes waiting in buf
+    uint32_t lastRecord;      //millis() of the last record
+    uint32_t firstWaiting;    //millis() of the oldest record in buf
+};
+#endif  //not defined _TwoPlayerGame_base_journal_h_
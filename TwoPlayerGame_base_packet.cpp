@@ -8,8 +8,9 @@
 #include "TwoPlayerGame.h"
 
 //String versions of the type and subType enums for debugging and other purposes
-const char* packetTypeStr[7]={"No packet type","Offering Game Packet", "Accepting Game Packet", "Move Packet", 
-                                "Results Packet", "Found Game Packet","Coin Flip Packet"};
+const char* packetTypeStr[12]={"No packet type","Offering Game Packet", "Accepting Game Packet", "Move Packet", 
+                                "Results Packet", "Found Game Packet","Coin Flip Packet", "Link Profile Packet",
+                                "Discover Packet", "Heartbeat Packet", "Resync Request Packet", "Resync Packet"};
 const char* packetSubTypeStr[10]= {"No subtype", "Normal Move", "Pass Move", "Quit Move", "Normal Results", 
                                     "Hit Results", "Miss Results", "Win Results", "Lose Results", "Tie Results",};
 
@@ -21,14 +22,61 @@ const char* packetSubTypeStr[10]= {"No subtype", "Normal Move", "Pass Move", "Qu
  * Base packet class stuff
  ************************************************************************************/
 
+/*
+ * Packs the header byte followed by the fields of this packet into "buf". Returns the
+ * number of bytes used or zero if the packet was too large for the buffer.
+ */
+uint8_t basePacket::encode(uint8_t* buf, uint8_t size) {
+  packetCodec c(buf,size,true);
+  uint8_t header= (type << 4) | (subType & 0x0f);
+  c.field(header);
+  fields(c);
+  return c.ok ? c.len : 0;
+}
+
+/*
+ * Unpacks a received frame into this packet. Returns the number of bytes used or zero if 
+ * the frame was too short to hold all of our fields. Fields are stored as they are read so
+ * we only find out a frame is short after some of them have changed. Our old contents are
+ * therefore packed into a scratch frame first and unpacked again if the new frame fails.
+ */
+uint8_t basePacket::decode(uint8_t* buf, uint8_t len) {
+  uint8_t saved[MAX_FRAME_SIZE];
+  uint8_t savedLen=encode(saved,sizeof(saved));
+  uint8_t used=unpack(buf,len);
+  if((used==0) && savedLen) {
+    unpack(saved,savedLen);
+  }
+  return used;
+}
+
+/*
+ * Internal routine that does the unpacking for "decode".
+ */
+uint8_t basePacket::unpack(uint8_t* buf, uint8_t len) {
+  packetCodec c(buf,len,false);
+  uint8_t header=0;
+  c.field(header);
+  type=(packetType_t)(header >> 4);
+  subType=(packetSubType_t)(header & 0x0f);
+  fields(c);
+  return c.ok ? c.len : 0;
+}
+
 /*
  * This is the base send packet function that actually sends the packet data. It returns true if 
  * packet is acknowledged. 
  */
 bool basePacket::send(void) {
+  uint8_t buf[MAX_FRAME_SIZE];
   DEBUG("BP::send "); 
   DEBUG_PRINT;
-  if(Radio->send((uint8_t*)this+PACKET_OFFSET, my_size()-PACKET_OFFSET)) {
+  uint8_t len=encode(buf,sizeof(buf));
+  if(len==0) {
+    DEBUGLN(" (ERROR:packet too large)");
+    return false;
+  }
+  if(Radio->send(buf,len)) {
     DEBUGLN(" (ack received)");
     return true;
   }
@@ -37,47 +85,62 @@ bool basePacket::send(void) {
 }  
 
 /*
- * Waits specified time for a packet of the specified type. Returns true if the packet was received and the 
- * type was correct. Returns false if time ran out or if it was the wrong packet type.
+ * Internal routine that unpacks a frame of the type we want into this packet and returns true. 
+ * If it is damaged this packet is left untouched and we return false.
+ */
+static bool acceptFrame(basePacket* p, uint8_t* buf, uint8_t len) {
+  if(!p->decode(buf,len)) {
+    DEBUGLN("Got packet. Was too short, ignoring.");
+    return false;
+  }
+  DEBUG("Got packet. "); 
+  #if(TPG_DEBUG)
+    p->print();
+  #endif
+  DEBUGLN("Was required type.");
+  return true;
+}
+
+/*
+ * Waits specified time for a packet of the specified type. Returns true if the packet was received.
+ * Returns false if time ran out. Packets of other types that arrive meanwhile are kept for later.
  */
 bool basePacket::requireTypeTimeout(packetType_t t,uint16_t timeout) {
-  uint8_t len = my_size()-PACKET_OFFSET;
-  if(Radio->recvTimeout((uint8_t*)this+PACKET_OFFSET,&len,timeout)) {
-    DEBUG("Got timed packet. "); 
-    DEBUG_PRINT;
-    //we got a packet but if it's the wrong type then return false
-    if(type==t){
-      DEBUGLN("Was required type.");
+  uint32_t StartTime=millis();
+  do {
+    if(pollType(t)) {
+      Radio->Stats.countBlocked(StartTime);
       return true;
-    } else {
-      DEBUGLN("Was wrong type.");
-      return false;
     }
-  }
-  //if we timed out return false
+    yield();
+  } while((millis()-StartTime) < timeout);
+  Radio->Stats.countBlocked(StartTime);
   return false;
 }
 
+/*
+ * Checks for a packet of the specified type without waiting. Everything the radio has received
+ * is moved into Radio->Inbox first. Returns true only if a packet of the correct type was waiting 
+ * there. Packets of any other type stay in the Inbox until somebody wants them.
+ */
+bool basePacket::pollType(packetType_t t) {
+  uint8_t buf[MAX_FRAME_SIZE];
+  uint8_t len = sizeof(buf);
+  Radio->pump();
+  if(!Radio->Inbox.take(t,buf,&len)) {
+    return false;
+  }
+  return acceptFrame(this,buf,len);
+}
+
 /*
  * Waits forever for a packet of the specified type. Returns only if the packet type was correct. 
  */
 void basePacket::requireType(packetType_t t) {
-  uint8_t len = my_size()-PACKET_OFFSET;
-  while(true) {
-    if(Radio->available()) {
-      if(Radio->recv((uint8_t*)this+PACKET_OFFSET,&len)) {
-        DEBUG("Got packet. "); 
-        DEBUG_PRINT;
-        //we got a packet but only exit if it's the right type
-        if(type==t){
-          DEBUGLN("Was required type.");
-          return;
-        } else {
-          DEBUGLN("Was wrong type, ignoring.");
-        }
-      }
-    }
+  uint32_t StartTime=millis();
+  while(!pollType(t)) {
   }
+  Radio->Stats.countBlocked(StartTime);
 }
 
 #if(TPG_DEBUG)
@@ -86,18 +149,18 @@ void basePacket::requireType(packetType_t t) {
    * classes such as baseMove.print() and baseResults.print() to print the packet information nonspecific to them. 
    */
   void basePacket::print(void) {
-    Serial.print("BP::print 'this'=0x"); Serial.print((uint32_t)this,HEX);
+    uint8_t Buffer[MAX_FRAME_SIZE];
+    uint8_t len=encode(Buffer,sizeof(Buffer));
+    Serial.print("BP::print 'this'=0x"); Serial.print((uintptr_t)this,HEX);
     #if(0)
-      uint8_t Buffer[30];
-      memcpy(Buffer,this,my_size());
       Serial.print(" Dump=(");
-      for(uint8_t i=0;i<my_size();i++) {
+      for(uint8_t i=0;i<len;i++) {
         Serial.print(Buffer[i],HEX); Serial.print (" ");
       }
       Serial.println(")");
     #endif
     Serial.print("  Type='");Serial.print(packetTypeStr[type]); 
-    Serial.print("' Size=");Serial.print(my_size()); Serial.print(" ");
+    Serial.print("' Size=");Serial.print(len); Serial.print(" ");
     if(subType != NO_SUBTYPE) {
       Serial.print("subtype='"); Serial.print(packetSubTypeStr[subType]);
       Serial.print("' ");
@@ -38,40 +38,34 @@
  */
 enum packetType_t {
   NO_PACKET_TYPE, OFFERING_GAME_PACKET, ACCEPTING_GAME_PACKET, MOVE_PACKET, RESULTS_PACKET, 
-  FOUND_GAME_PACKET,COIN_FLIP_PACKET
+  FOUND_GAME_PACKET,COIN_FLIP_PACKET, LINK_PROFILE_PACKET, DISCOVER_PACKET, HEARTBEAT_PACKET,
+  RESYNC_REQUEST_PACKET, RESYNC_PACKET
 };
 enum packetSubType_t {
   NO_SUBTYPE, NORMAL_MOVE, PASS_MOVE, QUIT_MOVE, NORMAL_RESULTS, HIT_RESULTS, MISS_RESULTS, WIN_RESULTS, 
 	LOSE_RESULTS, TIE_RESULTS, FLIP_TRUE, FLIP_FALSE
 };
-extern const char* packetTypeStr[7];
+extern const char* packetTypeStr[12];
 extern const char* packetSubTypeStr[10];
 
 /*
  * We want to transmit data from a packet object on this device to an identical packet object on the
- * other device. If we start at address "this" it would include the pointer to the function table. Although
- * we are compiling identical code on identical devices we can't be 100% sure those addresses would be 
- * the same. Similarly the first data item in a packet is a pointer to the radio object which we don't 
- * want to overwrite either. So we have to offset everything by "2*sizeof(void*)". We know that 
- * "sizeof(void*)" is 4 but who knows... we might someday port this to a 64-bit platform. Therefore 
- * using "sizeof(void*)" ensures we get it right. 
+ * other device. Rather than copying the raw bytes of the object (which would include the pointer to the 
+ * function table, the pointer to the radio, and whatever padding the compiler decided to add) each packet
+ * class describes its data one item at a time in a virtual "fields" method. A packetCodec object
+ * uses that method to pack the data into a frame for sending, and to unpack a received frame. See
+ * "TwoPlayerGame_packet_codec.h" for details.
+ * 
+ * Every frame begins with a single header byte. The upper 4 bits are the packet type and the lower
+ * 4 bits are the subtype. After that come the fields. For a move that is the 16-bit move number followed
+ * by whatever your derived move class adds. For example a Battleship move with a single byte shot
+ * location is only 4 bytes long.
  * 
  * WARNING: when implementing your derived Move and Results classes is recommended you DO NOT make use of
  * pointers to data unless you create a mechanism to send the pointed to data in a separate packet and then
- * reassemble it on the other side.
- * 
- * In addition to needing to know where in the object we want to start transmitting data, we also need to 
- * know the size of the derived packet object. The virtual method "my_size()" correctly tells a base method 
- * the size of the actual object. Therefore the data we will transmit in each packet starts at 
- * "this+(2*sizeof(void))" and the length of the data is "my_size()-(2*sizeof(void))". NOTE: the my_size() 
- * gives the size of the object but object sizes are typically rounded off to multiples of 4. So if you have 
- * an odd amount of data, there will be some garbage data at the end to pad it out to a multiple of 4. Make 
- * sure you compile the code for both devices using the same compiler and the same settings to ensure that 
- * such padding occurs the same on both devices.
- * 
- * Below we define PACKET_OFFSET to account for the function table pointer and the pointer to the radio object.
+ * reassemble it on the other side. Only the items you list in your "fields" method are transmitted.
  */
-#define PACKET_OFFSET (2*sizeof(void*))
+#include "TwoPlayerGame_packet_codec.h"
 
 /*
  * The base class for handling a packet. You need not create your own derived class from basePacket.
@@ -87,9 +81,26 @@ extern const char* packetSubTypeStr[10];
  *    basePacket(baseRadio* radio_ptr); 
  *      Constructors.
  *      
- *    virtual size_t my_size() { return sizeof( *this ); }
- *      Returns the size of the actual object as instantiated. ALL CLASSES derived from this
- *      type MUST implement this method EXACTLY as shown above.
+ *    virtual void fields(packetCodec& c);
+ *      Lists the data items that are transmitted after the header byte. The base packet has none.
+ *      Derived classes that add data MUST override this method and call the fields method of the
+ *      class they are derived from before listing their own items.
+ *      
+ *    uint8_t encode(uint8_t* buf, uint8_t size);
+ *      Packs the header byte and all fields into "buf" which holds "size" bytes. Returns the length 
+ *      of the frame or zero if it did not fit.
+ *      
+ *    uint8_t decode(uint8_t* buf, uint8_t len);
+ *      Unpacks a received frame of "len" bytes into this object. Returns the number of bytes used or zero 
+ *      if the frame was too short, in which case the object is left exactly as it was. A frame may hold 
+ *      more than one packet back to back. The return value tells you where the next one begins.
+ *      
+ *    static packetType_t frameType(uint8_t* buf);
+ *      Returns the packet type of an encoded frame without unpacking it.
+ *      
+ *    static uint16_t frameNumber(uint8_t* buf, uint8_t len);
+ *      Returns the move number of an encoded MOVE_PACKET or the results number of an encoded 
+ *      RESULTS_PACKET without unpacking it. Returns zero if the frame is too short.
  *      
  *    virtual bool send(void);            
  *      Sends the packet.
@@ -101,10 +112,21 @@ extern const char* packetSubTypeStr[10];
  *    bool requireTypeTimeout(packetType_t t,uint16_t timeout);
  *      Waits for the specified time in attempt to receive a particular type of packet from the 
  *      other device. Returns true if the proper packet was received before timeout. Returns false 
- *      if either time ran out or a received packet was the wrong type.
+ *      if time ran out. Packets of other types that arrive meanwhile are kept in Radio->Inbox.
+ *      
+ *    bool requireTypeTimeout(packetType_t t);
+ *      Same as above but waits for the time given by Radio->Rtt.timeout() which is based on how 
+ *      long the other device has been taking to reply.
+ *      
+ *    bool pollType(packetType_t t);
+ *      Checks for a packet of a particular type without waiting. Anything the radio has received is
+ *      moved into Radio->Inbox and if a packet of the proper type is waiting there it is unpacked and
+ *      the method returns true. Packets of other types are left in the Inbox for whoever wants them.
+ *      Returns false if nothing suitable had arrived. This is what the game engine uses internally
+ *      so that it never has to sit and wait on the radio.
  *      
  *    void requireType(packetType_t t);
- *      Waits indefinitely for a packet of a particular type. Ignores any of other packets.
+ *      Waits indefinitely for a packet of a particular type. Packets of other types are kept in Radio->Inbox.
  *      
  *    virtual void print(void); 
  *      Prints debug messages on the serial monitor. Derived classes that have "print" methods
@@ -117,18 +139,84 @@ class basePacket {
     packetSubType_t subType;
     basePacket(void) {subType=NO_SUBTYPE;}
     basePacket(baseRadio* radio_ptr) {subType=NO_SUBTYPE; Radio=radio_ptr;};
-    virtual size_t my_size() { return sizeof( *this ); }
+    virtual void fields(packetCodec& c) {};
+    uint8_t encode(uint8_t* buf, uint8_t size);
+    uint8_t decode(uint8_t* buf, uint8_t len);
+    static packetType_t frameType(uint8_t* buf) {return (packetType_t)(buf[0] >> 4);};
+    static uint16_t frameNumber(uint8_t* buf, uint8_t len) {return (len<3) ? 0 : buf[1] | (buf[2] << 8);};
     virtual bool send(void);
     virtual bool send(packetType_t t) {type=t; return send();};
     bool requireTypeTimeout(packetType_t t,uint16_t timeout);
+    bool requireTypeTimeout(packetType_t t) {return requireTypeTimeout(t,Radio->Rtt.timeout());};
+    bool pollType(packetType_t t);
     void requireType(packetType_t t);
     #if(TPG_DEBUG)
       virtual void print(void); //Prints debug messages on the serial monitor.
     #endif
+  private:
+    uint8_t unpack(uint8_t* buf, uint8_t len);
 };
 
 
 
+/*************************************************************************************
+ * Discover class derived from Packet class
+ ************************************************************************************/
+/*
+ * Used by the game engine when both devices run identical software and have to find each other 
+ * and decide which one is player 1. See "baseGame::discoverGame". You need not use it yourself.
+ * 
+ *    uint32_t deviceId;
+ *      The ID of the device that sent the packet.
+ *      
+ *    uint32_t peerId;
+ *      The ID of the last device the sender heard from or zero if it hasn't heard anyone.
+ */
+class discoverPacket : public basePacket {
+  public:
+    uint32_t deviceId;
+    uint32_t peerId;
+    discoverPacket(void) {type=DISCOVER_PACKET; deviceId=peerId=0;};
+    virtual void fields(packetCodec& c) {c.field(deviceId); c.field(peerId);};
+};
+
+
+/*************************************************************************************
+ * Resync class derived from Packet class
+ ************************************************************************************/
+/*
+ * Used by the game engine to put the two devices back in step when they disagree about the move
+ * number. See "baseGame::resync". You need not use it yourself. A RESYNC_REQUEST_PACKET asks the
+ * other device for a snapshot of the game. A RESYNC_PACKET is the answer. The game's own snapshot
+ * follows it in the same frame.
+ * 
+ *    uint16_t moveNum;
+ *      The sender's current move number.
+ *      
+ *    bool myTurn;
+ *      Only transmitted in a RESYNC_PACKET. True if move number moveNum is the sender's to make.
+ *      
+ *    bool resumed;
+ *      Only transmitted in a RESYNC_REQUEST_PACKET. True if the sender has just picked up a saved
+ *      game after a reset so its history may be a little out of date.
+ */
+class resyncPacket : public basePacket {
+  public:
+    uint16_t moveNum;
+    bool myTurn;
+    bool resumed;
+    resyncPacket(void) {type=RESYNC_REQUEST_PACKET; moveNum=0; myTurn=resumed=false;};
+    virtual void fields(packetCodec& c) {
+      c.field(moveNum);
+      if(type==RESYNC_PACKET) {
+        c.field(myTurn);
+      } else {
+        c.field(resumed);
+      }
+    };
+};
+
+
 /*************************************************************************************
  * Move class derived from Packet class
  ************************************************************************************/
@@ -151,12 +239,24 @@ class basePacket {
  *    uint16_t moveNum;
  *      The number of this move.
  *      
+ *    packetSubType_t predicted;
+ *    bool withPrediction;
+ *      In a perfect information game (see baseGame::perfectInformation) the player making the move 
+ *      works out the results for themselves and sends the subType they expect in "predicted". It is only
+ *      transmitted when the game engine has set "withPrediction". You need not touch either of these.
+ *      
+ *    uint32_t hash;
+ *    bool withHash;
+ *      With baseGame::hashCheck the game engine puts the sender's stateHash from the start of its turn
+ *      in "hash". It is only transmitted when the game engine has set "withHash". You need not touch 
+ *      either of these.
+ *      
  *    baseMove(void) 
  *      Constructor.
  *      
- *    virtual size_t my_size() { return sizeof( *this ); }
- *      Returns the size of the actual object as instantiated. ALL CLASSES derived from this
- *      type MUST implement this method EXACTLY as shown above.
+ *    virtual void fields(packetCodec& c);
+ *      Transmits moveNum. Your derived move class MUST override this method to list its own data.
+ *      It MUST call baseMove::fields(c) first. See "TwoPlayerGame_packet_codec.h" for an example.
  *      
  *    virtual void decideMyMove(void)
  *      You MUST implement and override this pure virtual function. It will prompt the user
@@ -166,6 +266,9 @@ class basePacket {
  *    void require(void)
  *      Wait forever for a MOVE_PACKET from the other device.
  *      
+ *    bool poll(void)
+ *      Returns true if a MOVE_PACKET has arrived from the other device. Does not wait.
+ *      
  *    virtual void print(void); 
  *      Prints debug messages on the serial monitor. Derived classes that have "print" methods
  *      for debugging may want to call this function first. This method calls basePacket::print();
@@ -174,10 +277,25 @@ class basePacket {
 class baseMove : public basePacket {
   public:
     uint16_t moveNum;
-    baseMove(void) {type=MOVE_PACKET;subType=NORMAL_MOVE;};
-    virtual size_t my_size() { return sizeof( *this ); };
+    packetSubType_t predicted;
+    bool withPrediction;
+    uint32_t hash;
+    bool withHash;
+    baseMove(void) {
+      type=MOVE_PACKET;subType=NORMAL_MOVE;predicted=NO_SUBTYPE;withPrediction=false;hash=0;withHash=false;
+    };
+    virtual void fields(packetCodec& c) {
+      c.field(moveNum);
+      if(withPrediction) {
+        c.field(predicted);
+      }
+      if(withHash) {
+        c.field(hash);
+      }
+    };
     virtual void decideMyMove(void)=0;
     void require(void) {requireType(MOVE_PACKET);};
+    bool poll(void) {return pollType(MOVE_PACKET);};
     #if(TPG_DEBUG)
       virtual void print(void);
     #endif
@@ -202,6 +320,11 @@ class baseMove : public basePacket {
  * TIE_RESULTS. Even if you know your move was a winner, it's officially the other player's responsibility to 
  * declare that the game is over as a result of your move.
  * 
+ * However in an open board game you can save half of the packets by setting baseGame::perfectInformation
+ * and implementing "predictResults". Then the player who moves works out the results of their own move 
+ * using the same rules the opponent will use. The opponent only sends a results packet if the game is 
+ * over or if their results disagree with the prediction. 
+ * 
  * The following items are inherited from basePacket...
  *    baseRadio* Radio;
  *      The game engine initializes the Radio pointer automatically. 
@@ -218,16 +341,25 @@ class baseMove : public basePacket {
  *    uint16_t resultsNum; 
  *      The move number to which these results refer.
  *      
+ *    uint32_t hash;
+ *    bool withHash;
+ *      With baseGame::hashCheck the game engine puts the sender's stateHash just after generateResults 
+ *      in "hash". It is only transmitted when the game engine has set "withHash". You need not touch 
+ *      either of these.
+ *      
  *    baseResults(void) 
  *      Constructor.
  *      
- *    virtual size_t my_size() { return sizeof( *this ); }
- *      Returns the size of the actual object as instantiated. ALL CLASSES derived from this
- *      type MUST implement this method EXACTLY as shown above.
+ *    virtual void fields(packetCodec& c);
+ *      Transmits resultsNum. Your derived results class MUST override this method to list its own
+ *      data. It MUST call baseResults::fields(c) first.
  *      
  *    virtual void require(void) 
  *      Waits forever for a RESULTS_PACKET.
  *      
+ *    virtual bool poll(void)
+ *      Returns true if a RESULTS_PACKET has arrived. Does not wait.
+ *      
  *    virtual bool generateResults(baseMove* Move)
  *      You MUST implement a derived generateResults method in your game implementation to produce 
  *      a packet of data to send back to your opponent telling them the results of their efforts. 
@@ -239,6 +371,12 @@ class baseMove : public basePacket {
  *      You MUST implement a derived processResults method in your game implementation to react to the 
  *      results packet you will receive after you make a move.  Returns true if the results ended the game.
  *      
+ *    virtual bool predictResults(baseMove* Move)
+ *      Only used if baseGame::perfectInformation is true in which case you MUST implement it. It is called 
+ *      with your own move just before it is sent. Fill in the results exactly as your opponent's 
+ *      generateResults will but without any side effects such as drawing or changing the board. Returns 
+ *      true if you expect the move to end the game. The base method predicts NORMAL_RESULTS.
+ *      
  *    virtual void print(void); 
  *      Prints debug messages on the serial monitor. Derived classes that have "print" methods
  *      for debugging may want to call this function first. This method calls basePacket::print();
@@ -247,11 +385,22 @@ class baseMove : public basePacket {
 class baseResults : public basePacket {
   public:
     uint16_t resultsNum;
-    baseResults(void) {type=RESULTS_PACKET; subType=NORMAL_RESULTS;};
-    virtual size_t my_size() { return sizeof( *this ); };
+    uint32_t hash;
+    bool withHash;
+    baseResults(void) {type=RESULTS_PACKET; subType=NORMAL_RESULTS; hash=0; withHash=false;};
+    virtual void fields(packetCodec& c) {
+      c.field(resultsNum);
+      if(withHash) {
+        c.field(hash);
+      }
+    };
     virtual void require(void) {requireType(RESULTS_PACKET);};
+    virtual bool poll(void) {return pollType(RESULTS_PACKET);};
     virtual bool generateResults(baseMove* Move)=0;
     virtual bool processResults(void)=0;
+    virtual bool predictResults(baseMove* Move) {
+      resultsNum=Move->moveNum; subType=NORMAL_RESULTS; return false;
+    };
     #if(TPG_DEBUG)
       virtual void print(void);//Prints debug information about the results. Calls basePacket::print
     #endif  
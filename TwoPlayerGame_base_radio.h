@@ -8,6 +8,9 @@
 #ifndef _TwoPlayerGame_base_radio_h_
 #define _TwoPlayerGame_base_radio_h_
 #include <Arduino.h>
+#include "TwoPlayerGame_radio_stats.h"
+#include "TwoPlayerGame_rtt_estimator.h"
+#include "TwoPlayerGame_packet_dispatcher.h"
 /*
  * Base class for object handling data transmission. You may use the provided derived class
  * RF69HCW provided or you may create a derived class that implements your own data transmission system.
@@ -18,10 +21,13 @@
  * originally used in this system. You could (and we may later) implement other systems such as
  * Bluetooth or infrared transmit and receive. Making the Radio a separate class and object
  * makes it easier to drop in other communication methods without changing the base code of the game engine.
+ * A second derived class "LoopbackRadio" in "TwoPlayerGame_loopback.h" connects two game objects running
+ * in the same program through memory rather than over the air. It is used for testing and benchmarking.
  * 
- * Each device has its own unique address. Player 1 will be a device #1 and Player 2 will be device #2
- * This device number is the ONLY difference between the software on one device versus the other.
- * EVERYTHING else is identical. See the "baseGame" constructor for details.
+ * Each device has its own unique address. Player 1 will be a device #1 and Player 2 will be device #2.
+ * You can either choose the player numbers yourself when you build each device's software or let the
+ * game engine decide who is who at runtime so that the software on both devices is identical.
+ * See the "baseGame" constructors for details. Until the engine has decided, both addresses are zero.
  *
  *    bool setup(uint8_t myPlayerNum, uint8_t otherPlayerNum)
  *      Gets called ONCE during your Game.setup call inside your main program setup(). Returns true
@@ -31,6 +37,23 @@
  *      Sends a packet of data starting at memory address "packet_ptr" with the number of bytes 
  *      specified by "len". Returns true if sent data was acknowledged as received.
  *        
+ *    bool sendNoAck(uint8_t* packet_ptr,uint8_t len);
+ *      Same as send except that the other device is told not to send a link-level acknowledgment and 
+ *      we do not wait for one. Returns true if the packet was transmitted. It may or may not have been 
+ *      received. The game engine uses this when a reply packet will prove delivery anyway. If your radio 
+ *      cannot do this, the base method simply calls send. Your recv and recvTimeout MUST acknowledge 
+ *      packets sent with send and MUST NOT acknowledge packets sent with sendNoAck.
+ *        
+ *    bool broadcast(uint8_t* packet_ptr,uint8_t len);
+ *      Sends a packet without an acknowledgment to any device that is listening no matter what its
+ *      address is. Used while the two devices are finding each other and don't know their addresses
+ *      yet. Returns true if the packet was transmitted. The base method calls sendNoAck.
+ *      
+ *    bool setAddresses(uint8_t myPlayerNum, uint8_t otherPlayerNum);
+ *      Changes our own address and the address we send to without setting up the radio again. Zero 
+ *      means not yet decided. While our address is zero we only receive broadcasts. Returns true if
+ *      successful. The base method just saves the two numbers.
+ *      
  *    bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout)
  *      Attempts to receive a packet and waits until the specified timeout. The packet_ptr
  *      is the start address of the data. The len_ptr points to an uint8_t specifying
@@ -43,16 +66,65 @@
  *      
  *    bool available(void)
  *      Returns true if data is available to be received.
+ *      
+ *    uint8_t modulations(void);
+ *    bool setModulation(uint8_t m);
+ *    const char* modulationName(uint8_t m);
+ *      Optional. A radio may support several modulation settings trading speed for range. They are
+ *      numbered from zero, fastest first, and zero is the setting used after setup. "modulations" returns
+ *      how many there are, "setModulation" switches to one of them and returns true if successful, and 
+ *      "modulationName" returns a short description for printing. Both devices MUST use the same setting
+ *      or they will not hear each other. The base methods support just one setting.
+ *      
+ *    uint8_t powerLevels(void);
+ *    bool setPowerLevel(uint8_t p);
+ *      Optional. Same idea for transmit power. Level zero is full power which is what is used after setup.
+ *      Higher numbers are weaker. The base methods support just one level.
+ *      
+ *    radioStats Stats;
+ *      Counters and histograms describing the quality of the link. Your send, sendNoAck, recv, and 
+ *      recvTimeout methods should call its "count" methods. See "TwoPlayerGame_radio_stats.h".
+ *      
+ *    rttEstimator Rtt;
+ *      Estimate of how long the other device takes to reply. The game engine feeds it and derives all of 
+ *      its timeouts from it. Your radio class need not do anything with it. See "TwoPlayerGame_rtt_estimator.h".
+ *      
+ *    packetDispatcher Inbox;
+ *    void pump(void);
+ *      Received frames waiting to be used, sorted by packet type. "pump" moves everything your recv 
+ *      method has to offer into Inbox. The game engine and basePacket only receive this way so that a
+ *      packet of one type is never lost while they wait for another. If you call recv yourself, 
+ *      frames you receive never reach Inbox. See "TwoPlayerGame_packet_dispatcher.h".
  */
 
 class baseRadio {
   public:
     uint8_t myPlayerNum;    //my radios address
     uint8_t otherPlayerNum; //opponent's radio address
+    radioStats Stats;       //link quality measurements
+    rttEstimator Rtt;       //how long the other device takes to reply
+    packetDispatcher Inbox; //received frames sorted by type
     virtual bool setup(uint8_t myPlayerNum, uint8_t otherPlayerNum)=0;
     virtual bool send(uint8_t* packet_ptr,uint8_t len)=0;
+    virtual bool sendNoAck(uint8_t* packet_ptr,uint8_t len) {return send(packet_ptr,len);};
+    virtual bool broadcast(uint8_t* packet_ptr,uint8_t len) {return sendNoAck(packet_ptr,len);};
+    virtual bool setAddresses(uint8_t myD, uint8_t otherD) {myPlayerNum=myD; otherPlayerNum=otherD; return true;};
     virtual bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout)=0;
     virtual bool recv(uint8_t* packet_ptr,uint8_t* len_ptr)=0;
     virtual bool available(void)=0;
+    virtual uint8_t modulations(void) {return 1;};
+    virtual bool setModulation(uint8_t m) {return m==0;};
+    virtual const char* modulationName(uint8_t m) {return "default";};
+    virtual uint8_t powerLevels(void) {return 1;};
+    virtual bool setPowerLevel(uint8_t p) {return p==0;};
+    void pump(void) {
+      uint8_t buf[MAX_FRAME_SIZE];
+      for(uint8_t i=0; (i<DISPATCH_FRAMES) && available(); i++) {
+        uint8_t len=sizeof(buf);
+        if(recv(buf,&len)) {
+          Inbox.store(buf,len);
+        }
+      }
+    };
 };
 #endif  //not defined _TwoPlayerGame_base_radio_h_
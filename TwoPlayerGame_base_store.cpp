@@ -0,0 +1,98 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * Source code for the baseStore class. See "TwoPlayerGame_base_store.h" for details.
+ */
+#include "TwoPlayerGame_base_store.h"
+
+uint16_t baseStore::crc(const uint8_t* buf, uint8_t len, uint16_t c) {
+  for(uint8_t i=0;i<len;i++) {
+    c ^= (uint16_t)buf[i] << 8;
+    for(uint8_t b=0;b<8;b++) {
+      c= (c & 0x8000) ? (c << 1) ^ 0x1021 : (c << 1);
+    }
+  }
+  return c;
+}
+
+/*
+ * A slot is good if it starts with STORE_MAGIC, its length fits, and its CRC matches. A slot
+ * that was being written when the power failed fails the CRC.
+ */
+bool baseStore::check(const uint8_t* buf) {
+  if((buf[0]!=STORE_MAGIC) || (buf[3] > STORE_SLOT_SIZE-STORE_HEADER)) {
+    return false;
+  }
+  return crc(buf+STORE_HEADER,buf[3],crc(buf+1,3)) == (buf[4] | (uint16_t)buf[5] << 8);
+}
+
+/*
+ * Finds the good slot with the newest sequence number. Sequence numbers wrap around so we
+ * compare differences. The next save goes into the slot after it. If no slot is good we
+ * start at slot zero.
+ */
+bool baseStore::scan(void) {
+  uint8_t buf[STORE_SLOT_SIZE];
+  bool found=false;
+  uint16_t newest=0;
+  next=0;
+  for(uint8_t s=0;s<slotCount;s++) {
+    if(!readSlot(s,buf) || !check(buf)) {
+      continue;
+    }
+    uint16_t n= buf[1] | (uint16_t)buf[2] << 8;
+    if(!found || ((int16_t)(n-newest) > 0)) {
+      found=true;
+      newest=n;
+      next=(s+1) % slotCount;
+    }
+  }
+  sequence= found ? newest+1 : 0;
+  scanned=true;
+  return found;
+}
+
+bool baseStore::save(const uint8_t* data, uint8_t len) {
+  if(len > STORE_SLOT_SIZE-STORE_HEADER) {
+    return false;
+  }
+  if(!scanned) {
+    scan();
+  }
+  uint8_t buf[STORE_SLOT_SIZE];
+  memset(buf,0,sizeof(buf));
+  buf[1]=sequence & 0xff;
+  buf[2]=sequence >> 8;
+  buf[3]=len;
+  if(len) {
+    memcpy(buf+STORE_HEADER,data,len);
+  }
+  uint16_t c=crc(buf+STORE_HEADER,len,crc(buf+1,3));
+  buf[0]=STORE_MAGIC;
+  buf[4]=c & 0xff;
+  buf[5]=c >> 8;
+  bool ok=writeSlot(next,buf);
+  writes++;
+  //Even if the write failed we move on so that one bad slot doesn't stop us
+  next=(next+1) % slotCount;
+  sequence++;
+  return ok;
+}
+
+uint8_t baseStore::load(uint8_t* data, uint8_t size) {
+  if(!scan()) {
+    return 0;
+  }
+  uint8_t buf[STORE_SLOT_SIZE];
+  uint8_t newest=(next+slotCount-1) % slotCount;
+  if(!readSlot(newest,buf) || !check(buf) || (buf[3]>size)) {
+    return 0;
+  }
+  memcpy(data,buf+STORE_HEADER,buf[3]);
+  return buf[3];
+}
@@ -0,0 +1,101 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_base_store_h_
+#define _TwoPlayerGame_base_store_h_
+#include <Arduino.h>
+/*
+ * Base class for an object that keeps the game safe in flash memory, on an SD card, or anywhere
+ * else that survives a reset. The game engine uses it to pick a game back up after a brown-out
+ * or reset instead of starting over. See "baseGame::Store". A derived class "fileStore" that uses
+ * the Arcada file system is in "TwoPlayerGame_file_store.h". You may create your own for other
+ * kinds of memory. Like the radio, you create an instance and give its address to the game.
+ *
+ * The memory is divided into a few "slots" of STORE_SLOT_SIZE bytes each. Every save goes into
+ * the slot after the one used last time, so each slot is written only once every few turns.
+ * That spreads the wear over several places because flash can only be erased so many times. It
+ * also means the previous save is still there if the power fails in the middle of a write.
+ * Each slot holds:
+ *
+ *    byte 0      STORE_MAGIC
+ *    bytes 1-2   sequence number, one higher than the save before it
+ *    byte 3      length of the data
+ *    bytes 4-5   CRC-16 of bytes 1 through 3 and the data
+ *    bytes 6-    the data
+ *
+ * When reading we take the slot with the newest sequence number whose CRC is correct.
+ * A save with no data at all means there is no game to pick up.
+ *
+ * Your derived class MUST implement the first three of these methods.
+ *
+ *    bool begin(void);
+ *      Called once by baseGame::setup before anything is read or written. Returns true if the
+ *      memory is ready.
+ *
+ *    bool readSlot(uint8_t slot, uint8_t* buf);
+ *    bool writeSlot(uint8_t slot, const uint8_t* buf);
+ *      Read or write all STORE_SLOT_SIZE bytes of slot number "slot" which goes from zero to
+ *      slotCount-1. Return true if successful. A slot that has never been written may contain
+ *      anything or may fail to read.
+ *
+ *    uint8_t slotCount;
+ *      Number of slots, set by the constructor. Defaults to STORE_SLOTS.
+ *
+ *    uint32_t writes;
+ *      Number of slots written so far.
+ *
+ *    bool save(const uint8_t* data, uint8_t len);
+ *      Writes "len" bytes into the next slot. Returns false if they don't fit or the write failed.
+ *
+ *    uint8_t load(uint8_t* data, uint8_t size);
+ *      Copies the newest good save into "data" which holds "size" bytes. Returns its length or zero
+ *      if there isn't one.
+ *
+ *    void forget(void);
+ *      Saves nothing so that load finds nothing.
+ *
+ *    bool scan(void);
+ *    bool check(const uint8_t* buf);
+ *    static uint16_t crc(const uint8_t* buf, uint8_t len, uint16_t c=0xffff);
+ *    uint8_t next;
+ *    uint16_t sequence;
+ *    bool scanned;
+ *      Internal routines and data. "scan" finds the newest good slot the first time we read or
+ *      write and returns true if there was one. "check" returns true if a slot is good. "crc"
+ *      computes a CRC-16/CCITT of "len" bytes continuing from "c". The data are the slot the next
+ *      save goes into, its sequence number, and whether we have scanned yet.
+ */
+
+//Bytes in each slot, including the 6 byte header
+#define STORE_SLOT_SIZE 128
+//Default number of slots
+#define STORE_SLOTS 4
+//First byte of every slot that has been saved
+#define STORE_MAGIC 0x5A
+//Bytes of the header in front of the data
+#define STORE_HEADER 6
+
+class baseStore {
+  public:
+    uint8_t slotCount;
+    uint32_t writes;
+    baseStore(uint8_t n=STORE_SLOTS) {slotCount= n ? n : 1; writes=0; scanned=false;};
+    virtual bool begin(void)=0;
+    virtual bool readSlot(uint8_t slot, uint8_t* buf)=0;
+    virtual bool writeSlot(uint8_t slot, const uint8_t* buf)=0;
+    bool save(const uint8_t* data, uint8_t len);
+    uint8_t load(uint8_t* data, uint8_t size);
+    void forget(void) {save(NULL,0);};
+  private:
+    bool scan(void);
+    bool check(const uint8_t* buf);
+    static uint16_t crc(const uint8_t* buf, uint8_t len, uint16_t c=0xffff);
+    uint8_t next;       //slot the next save goes into
+    uint16_t sequence;  //sequence number of the next save
+    bool scanned;       //next and sequence are valid
+};
+#endif  //not defined _TwoPlayerGame_base_store_h_
@@ -0,0 +1,191 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_bitboard_h_
+#define _TwoPlayerGame_bitboard_h_
+#include <Arduino.h>
+/*
+ * A set of squares on a rectangular board of W columns and H rows, one bit per square, for games
+ * played on a grid. Squares are numbered across each row starting at the top left, so square "i"
+ * is in column i % W of row i / W. The size is fixed when you compile so a 10 x 10 board is four
+ * 32-bit words, 16 bytes, and a 20 x 20 board is 52 bytes.
+ *
+ * The point is to answer questions about many squares at once. Keep one bitBoard for each kind
+ * of thing on the board, for example every square holding a ship and every square that has been
+ * fired at. Then "does this ship overlap another one" is intersects(), "is this ship sunk" is
+ * contains() and "has every ship been hit everywhere" is contains() again, each a few word
+ * operations no matter how many squares are involved.
+ *
+ * There is no constructor so a bitBoard can sit in a structure with an initializer list. Global
+ * ones start empty. Call clear() on any other before using it. Bits past the last square are
+ * never set.
+ *
+ *    static const uint8_t width;
+ *    static const uint8_t height;
+ *    static const uint16_t cells;
+ *      W, H, and the number of squares W*H.
+ *
+ *    uint32_t bits[words];
+ *      The squares. Bit i % 32 of bits[i / 32] is square i.
+ *
+ *    void clear(void);
+ *      Empties the board.
+ *
+ *    bool test(uint16_t i);
+ *    void set(uint16_t i);
+ *    void reset(uint16_t i);
+ *      Tests, adds, or removes square "i". It MUST be less than cells.
+ *
+ *    bool any(void);
+ *    uint16_t count(void);
+ *      Returns true if any square is set, or how many are.
+ *
+ *    bool intersects(const bitBoard& b);
+ *      Returns true if any square is in both boards.
+ *
+ *    bool contains(const bitBoard& b);
+ *      Returns true if every square of "b" is also in this board.
+ *
+ *    bitBoard& operator|=(const bitBoard& b);
+ *    bitBoard& operator&=(const bitBoard& b);
+ *    void remove(const bitBoard& b);
+ *      Adds the squares of "b", keeps only the squares also in "b", or takes away the squares of "b".
+ *
+ *    bool line(uint16_t start, uint8_t length, bool vertical);
+ *      Makes this board a straight line of "length" squares beginning at "start" and going right,
+ *      or down if "vertical". Returns false and leaves the board empty if the line would go off
+ *      the edge of the board.
+ *
+ *    static uint16_t lines(uint8_t length);
+ *    static void nthLine(uint8_t length, uint16_t n, uint16_t& start, bool& vertical);
+ *      The first returns how many places a line of "length" squares fits on the board, going right
+ *      or down. The second gives the start and direction of place number "n", counting from zero,
+ *      horizontal ones first. A random "n" below lines(length) picks any of them with equal chance.
+ *
+ *    static uint16_t randomLines(uint8_t count, const uint8_t* lengths, uint16_t* start,
+ *                                bool* vertical, bitBoard* line, bitBoard& all);
+ *      Places "count" lines that don't overlap, such as a fleet of ships, with every such layout
+ *      equally likely. Line "i" is lengths[i] squares long. Each is given a place chosen by
+ *      nthLine and if it overlaps one already placed the whole layout is thrown away and we start
+ *      again. Moving only the line that overlaps would favour some layouts over others because the
+ *      lines placed first get the empty board to themselves. Fills in start[], vertical[] and
+ *      line[] for each line and every square of all of them in "all". Returns how many layouts
+ *      were tried. Make sure the lines can all fit or it never returns.
+ *
+ *    static uint8_t column(uint16_t i);
+ *    static uint8_t row(uint16_t i);
+ *      Returns the column or row of square "i".
+ */
+template<uint8_t W, uint8_t H> class bitBoard {
+  public:
+    static const uint8_t width=W;
+    static const uint8_t height=H;
+    static const uint16_t cells=(uint16_t)W*H;
+    static const uint8_t words=(cells+31)/32;
+    uint32_t bits[words];
+    void clear(void) {memset(bits,0,sizeof(bits));};
+    bool test(uint16_t i) const {return (bits[i >> 5] >> (i & 31)) & 1;};
+    void set(uint16_t i) {bits[i >> 5] |= 1UL << (i & 31);};
+    void reset(uint16_t i) {bits[i >> 5] &= ~(1UL << (i & 31));};
+    bool any(void) const {
+      uint32_t a=0;
+      for(uint8_t w=0;w<words;w++) {
+        a |= bits[w];
+      }
+      return a!=0;
+    };
+    uint16_t count(void) const {
+      uint16_t n=0;
+      for(uint8_t w=0;w<words;w++) {
+        n += __builtin_popcountl(bits[w]);
+      }
+      return n;
+    };
+    bool intersects(const bitBoard& b) const {
+      uint32_t a=0;
+      for(uint8_t w=0;w<words;w++) {
+        a |= bits[w] & b.bits[w];
+      }
+      return a!=0;
+    };
+    bool contains(const bitBoard& b) const {
+      uint32_t a=0;
+      for(uint8_t w=0;w<words;w++) {
+        a |= b.bits[w] & ~bits[w];
+      }
+      return a==0;
+    };
+    bitBoard& operator|=(const bitBoard& b) {
+      for(uint8_t w=0;w<words;w++) {
+        bits[w] |= b.bits[w];
+      }
+      return *this;
+    };
+    bitBoard& operator&=(const bitBoard& b) {
+      for(uint8_t w=0;w<words;w++) {
+        bits[w] &= b.bits[w];
+      }
+      return *this;
+    };
+    void remove(const bitBoard& b) {
+      for(uint8_t w=0;w<words;w++) {
+        bits[w] &= ~b.bits[w];
+      }
+    };
+    bool line(uint16_t start, uint8_t length, bool vertical) {
+      clear();
+      if((start>=cells) || (length==0) ||
+         (vertical ? (row(start)+length > H) : (column(start)+length > W))) {
+        return false;
+      }
+      if(!vertical && (length<32)) {  //a run of bits, in one word or split across two
+        uint32_t run=(1UL << length)-1;
+        uint8_t b=start & 31;
+        bits[start >> 5]=run << b;
+        if(b+length > 32) {
+          bits[(start >> 5)+1]=run >> (32-b);
+        }
+        return true;
+      }
+      for(uint8_t k=0;k<length;k++) {
+        set(start + (vertical ? k*W : k));
+      }
+      return true;
+    };
+    static uint16_t lines(uint8_t length) {
+      return ((length<=W) ? (W-length+1)*H : 0) + ((length<=H) ? W*(H-length+1) : 0);
+    };
+    static void nthLine(uint8_t length, uint16_t n, uint16_t& start, bool& vertical) {
+      uint16_t across= (length<=W) ? (W-length+1) : 0;
+      vertical= (n >= across*H);
+      if(vertical) {
+        start=n-across*H;   //every column of the top H-length+1 rows
+      } else {
+        start=(n/across)*W + n%across;
+      }
+    };
+    static uint16_t randomLines(uint8_t count, const uint8_t* lengths, uint16_t* start,
+                                bool* vertical, bitBoard* line, bitBoard& all) {
+      uint16_t tries=0;
+      bool overlap;
+      do {
+        tries++;
+        overlap=false;
+        all.clear();
+        for(uint8_t i=0;(i<count) && !overlap;i++) {
+          nthLine(lengths[i], random(lines(lengths[i])), start[i], vertical[i]);
+          line[i].line(start[i], lengths[i], vertical[i]);
+          overlap=line[i].intersects(all);
+          all |= line[i];
+        }
+      } while(overlap);
+      return tries;
+    };
+    static uint8_t column(uint16_t i) {return i % W;};
+    static uint8_t row(uint16_t i) {return i / W;};
+};
+#endif  //not defined _TwoPlayerGame_bitboard_h_
@@ -0,0 +1,46 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_file_journal_h_
+#define _TwoPlayerGame_file_journal_h_
+#include <Adafruit_Arcada.h>
+#include "TwoPlayerGame_base_journal.h"
+/*
+ * This module defines a class "fileJournal" for use with the Two Player Game system. It is derived
+ * from the baseJournal class defined in "TwoPlayerGame_base_journal.h". See that file for details.
+ *
+ * It appends every record to the file JOURNAL_PATH on the file system that Arcada mounts, internal
+ * QSPI flash or an SD card, the same one that holds the "/wav" files. The file keeps growing from
+ * game to game until you delete it. Copy it to your computer over USB and send it to the
+ * "journal_replay" utility to play the games back. Use it as follows:
+ *
+ *    Adafruit_Arcada Device;
+ *    fileJournal GameLog(&Device);
+ *
+ *    //in your game's constructor
+ *    Journal=&GameLog;
+ */
+//File holding the journal
+#define JOURNAL_PATH "/journal.tpj"
+
+class fileJournal : public baseJournal {
+  public:
+    fileJournal(Adafruit_Arcada* device_ptr) {Device=device_ptr;};
+    bool begin(void) {return Device->filesysBegin();};
+    bool append(const uint8_t* buf, uint16_t len) {
+      File f=Device->open(JOURNAL_PATH, FILE_WRITE);  //FILE_WRITE starts at the end
+      if(!f) {
+        return false;
+      }
+      bool ok= (f.write(buf,len)==len);
+      f.close();
+      return ok;
+    };
+  private:
+    Adafruit_Arcada* Device;
+};
+#endif  //not defined _TwoPlayerGame_file_journal_h_
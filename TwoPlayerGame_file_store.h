@@ -0,0 +1,68 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_file_store_h_
+#define _TwoPlayerGame_file_store_h_
+#include <Adafruit_Arcada.h>
+#include "TwoPlayerGame_base_store.h"
+/*
+ * This module defines a class "fileStore" for use with the Two Player Game system. It is derived
+ * from the baseStore class defined in "TwoPlayerGame_base_store.h". See that file for details.
+ *
+ * It keeps each slot in a file of its own in the STORE_PATH folder of the file system that
+ * Arcada mounts, internal QSPI flash or an SD card, the same one that holds the "/wav" files.
+ * Use it as follows:
+ *
+ *    Adafruit_Arcada Device;
+ *    fileStore SaveFile(&Device);
+ *
+ *    //in your game's constructor
+ *    Store=&SaveFile;
+ *
+ * Every file is written at its full size in place. After the first save the file never changes
+ * size so the FAT never has to be rewritten. Only the file's own data and its directory entry are.
+ */
+//Folder holding the slot files
+#define STORE_PATH "/saved"
+
+class fileStore : public baseStore {
+  public:
+    fileStore(Adafruit_Arcada* device_ptr, uint8_t n=STORE_SLOTS) : baseStore(n) {Device=device_ptr;};
+    bool begin(void) {
+      if(!Device->filesysBegin()) {
+        return false;
+      }
+      return Device->exists(STORE_PATH) || Device->mkdir(STORE_PATH);
+    };
+    bool readSlot(uint8_t slot, uint8_t* buf) {
+      File f=Device->open(name(slot), FILE_READ);
+      if(!f) {
+        return false;
+      }
+      bool ok= (f.read(buf,STORE_SLOT_SIZE)==STORE_SLOT_SIZE);
+      f.close();
+      return ok;
+    };
+    bool writeSlot(uint8_t slot, const uint8_t* buf) {
+      File f=Device->open(name(slot), FILE_WRITE);
+      if(!f) {
+        return false;
+      }
+      f.seek(0);    //FILE_WRITE starts at the end
+      bool ok= (f.write(buf,STORE_SLOT_SIZE)==STORE_SLOT_SIZE);
+      f.close();
+      return ok;
+    };
+  private:
+    Adafruit_Arcada* Device;
+    char path[sizeof(STORE_PATH)+12];
+    const char* name(uint8_t slot) {
+      sprintf(path,"%s/slot%d.bin",STORE_PATH,slot);
+      return path;
+    };
+};
+#endif  //not defined _TwoPlayerGame_file_store_h_
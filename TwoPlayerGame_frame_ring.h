@@ -0,0 +1,77 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_frame_ring_h_
+#define _TwoPlayerGame_frame_ring_h_
+#include <Arduino.h>
+/*
+ * A ring of frame buffers with exactly one producer and one consumer. The producer, for example
+ * a radio interrupt handler, calls "push" and the consumer, usually the main loop, calls "pop".
+ * Neither one ever waits for the other and nothing turns interrupts off. That works because only
+ * push changes "tail" and only pop changes "head". Each side reads the other side's index with an
+ * acquire load and publishes its own with a release store so the frame is always completely
+ * copied before the other side can see that it is there.
+ *
+ * The indices run freely from 0 to 255 and wrap. The number of frames waiting is tail-head.
+ * SLOTS MUST be a power of two no larger than 128 so that the wrap lands on a slot boundary.
+ * SIZE is the largest frame in bytes.
+ *
+ *    uint32_t dropped;
+ *      Number of frames push threw away because the ring was full or the frame was too large.
+ *      Only the producer changes it.
+ *
+ *    bool push(const uint8_t* buf, uint8_t len);
+ *      Producer only. Copies a frame into the ring. Returns false if it was dropped.
+ *
+ *    bool pop(uint8_t* buf, uint8_t* len_ptr);
+ *      Consumer only. Copies the oldest frame out of the ring. On entry len_ptr points to the size
+ *      of the buffer, on return it holds the number of bytes copied. A frame larger than the buffer
+ *      is truncated just as RadioHead does. Returns false if the ring was empty.
+ *
+ *    bool empty(void);
+ *      Either side. Returns true if nothing is waiting.
+ */
+template<uint8_t SLOTS, uint8_t SIZE>
+class frameRing {
+  public:
+    uint32_t dropped;
+    frameRing(void) {head=tail=0; dropped=0;};
+    bool push(const uint8_t* buf, uint8_t len) {
+      uint8_t t=__atomic_load_n(&tail,__ATOMIC_RELAXED);
+      if((len>SIZE) || ((uint8_t)(t-__atomic_load_n(&head,__ATOMIC_ACQUIRE)) >= SLOTS)) {
+        dropped++;
+        return false;
+      }
+      memcpy(data[t & (SLOTS-1)],buf,len);
+      lengths[t & (SLOTS-1)]=len;
+      __atomic_store_n(&tail,(uint8_t)(t+1),__ATOMIC_RELEASE);
+      return true;
+    };
+    bool pop(uint8_t* buf, uint8_t* len_ptr) {
+      uint8_t h=__atomic_load_n(&head,__ATOMIC_RELAXED);
+      if(h==__atomic_load_n(&tail,__ATOMIC_ACQUIRE)) {
+        return false;
+      }
+      uint8_t i=h & (SLOTS-1);
+      if(*len_ptr > lengths[i]) {
+        *len_ptr=lengths[i];
+      }
+      memcpy(buf,data[i],*len_ptr);
+      __atomic_store_n(&head,(uint8_t)(h+1),__ATOMIC_RELEASE);
+      return true;
+    };
+    bool empty(void) {
+      return __atomic_load_n(&head,__ATOMIC_ACQUIRE)==__atomic_load_n(&tail,__ATOMIC_ACQUIRE);
+    };
+  private:
+    static_assert((SLOTS>0) && (SLOTS<=128) && ((SLOTS & (SLOTS-1))==0), "frameRing SLOTS must be a power of two up to 128");
+    uint8_t lengths[SLOTS];
+    uint8_t data[SLOTS][SIZE];
+    uint8_t head;   //next frame to pop, changed only by the consumer
+    uint8_t tail;   //next slot to fill, changed only by the producer
+};
+#endif  //not defined _TwoPlayerGame_frame_ring_h_
@@ -0,0 +1,43 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * Source code for the idlePolicy class. See "TwoPlayerGame_idle_policy.h" for details.
+ */
+#include "TwoPlayerGame_idle_policy.h"
+
+void idlePolicy::reset(void) {
+  sleeps=0;
+  asleepMicros=awakeMicros=0;
+  lastActivity=millis();
+  mark=micros();
+}
+
+/*
+ * The Cortex-M "wait for interrupt" instruction stops the processor clock until any interrupt
+ * is pending. Peripherals, USB and the system tick keep running. The barrier makes sure any
+ * memory writes have finished first. We measure each piece separately rather than comparing 
+ * with the time of reset so that micros() wrapping around every 71 minutes doesn't matter.
+ */
+void idlePolicy::sleep(void) {
+  uint32_t start=micros();
+  awakeMicros+= start-mark;
+  #if defined(ARDUINO_ARCH_SAMD)
+    __DSB();
+    __WFI();
+  #else
+    yield();
+  #endif
+  mark=micros();
+  asleepMicros+= mark-start;
+  sleeps++;
+}
+
+uint8_t idlePolicy::percentAsleep(void) {
+  uint64_t total=asleepMicros+awakeMicros+(micros()-mark);
+  return total ? (asleepMicros*100)/total : 0;
+}
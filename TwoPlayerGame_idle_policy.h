@@ -0,0 +1,73 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_idle_policy_h_
+#define _TwoPlayerGame_idle_policy_h_
+#include <Arduino.h>
+/*
+ * Most of a game is spent waiting for the other player to decide on a move. Without help the
+ * processor spins around "step()" as fast as it can the whole time and the backlight stays on.
+ * When baseGame::lowPower is on, the game engine uses an idlePolicy to do better. Between steps 
+ * it puts the processor to sleep until the next interrupt. On SAMD boards that is the radio 
+ * receiving a packet or the 1 millisecond system tick, whichever comes first, so nothing is ever 
+ * late by more than a millisecond. If we have been waiting for "dimDelay" milliseconds the engine 
+ * asks your game to dim the display. It asks it to brighten again when a packet arrives, a button 
+ * is pressed, or the wait is over. The idlePolicy itself knows nothing about the game, the 
+ * display, or the radio. It just sleeps, keeps time, and says when to dim.
+ *
+ * It also counts how much of the time we spent asleep. The game engine starts the count over at
+ * the start of each game so at the end you can report what fraction of the game was spent asleep.
+ * On boards without a sleep instruction "sleep" simply calls yield() and counts that.
+ *
+ *    uint32_t dimDelay;
+ *      Milliseconds of waiting before dimming. Zero means never. Default is IDLE_DIM_DELAY.
+ *
+ *    bool dimmed;
+ *      True if we have told the game to dim and not yet told it to brighten.
+ *
+ *    uint32_t sleeps;
+ *      Number of times we went to sleep since reset.
+ *
+ *    uint64_t asleepMicros, awakeMicros;
+ *      Total microseconds spent asleep and awake since reset. Time since the last call to "sleep" 
+ *      is not counted yet.
+ *
+ *    void reset(void);
+ *      Starts the counts and the dim timer over. It doesn't change "dimmed".
+ *
+ *    void activity(void);
+ *      Something happened. Starts the dim timer over.
+ *
+ *    bool dimDue(void);
+ *      Returns true if we are not dimmed and have been idle for at least dimDelay milliseconds.
+ *
+ *    void sleep(void);
+ *      Sleeps until the next interrupt and counts the time.
+ *
+ *    uint8_t percentAsleep(void);
+ *      Percentage of the time since reset spent asleep.
+ */
+#define IDLE_DIM_DELAY 15000    //milliseconds of waiting before the display is dimmed
+
+class idlePolicy {
+  public:
+    uint32_t dimDelay;
+    bool dimmed;
+    uint32_t sleeps;
+    uint64_t asleepMicros;
+    uint64_t awakeMicros;
+    idlePolicy(void) {dimDelay=IDLE_DIM_DELAY; dimmed=false; reset();};
+    void reset(void);
+    void activity(void) {lastActivity=millis();};
+    bool dimDue(void) {return !dimmed && dimDelay && ((millis()-lastActivity) >= dimDelay);};
+    void sleep(void);
+    uint8_t percentAsleep(void);
+  private:
+    uint32_t lastActivity;    //millis() when the dim timer started
+    uint32_t mark;            //micros() when we last woke up
+};
+#endif  //not defined _TwoPlayerGame_idle_policy_h_
@@ -0,0 +1,98 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * Source code for the linkPolicy class. See "TwoPlayerGame_link_policy.h" for details.
+ */
+#include "TwoPlayerGame_link_policy.h"
+
+linkPolicy::linkPolicy(void) {
+  Radio=NULL;
+  profiles=1;
+  home=current=0;
+  rssiStrong=LINK_RSSI_STRONG;
+  rssiWeak=LINK_RSSI_WEAK;
+  retryHighPercent=LINK_RETRY_HIGH;
+  retryLowPercent=LINK_RETRY_LOW;
+  upWindows=LINK_UP_WINDOWS;
+  goodWindows=0;
+  lastSent=lastRetries=lastFailures=lastRssiCount=0;
+  lastRssiTotal=0;
+}
+
+/*
+ * Modulations are numbered fastest first and power levels strongest first. Rungs 0 through
+ * home use modulations from slowest to fastest at full power. Rungs above home use the fastest
+ * modulation at power levels 1 and up.
+ */
+void linkPolicy::begin(baseRadio* radio_ptr) {
+  Radio=radio_ptr;
+  home=Radio->modulations()-1;
+  profiles=home+Radio->powerLevels();
+  current=home;
+  goodWindows=0;
+  lastSent=Radio->Stats.sent+Radio->Stats.sentNoAck;
+  lastRetries=Radio->Stats.retries;
+  lastFailures=Radio->Stats.failedAcks;
+  lastRssiCount=Radio->Stats.rssiCount;
+  lastRssiTotal=Radio->Stats.rssiTotal;
+}
+
+uint8_t linkPolicy::decide(int16_t rssi, uint32_t packets, uint32_t retries, uint32_t failures) {
+  if(packets==0) {
+    return current;   //nothing to go on
+  }
+  uint32_t retryPercent=retries*100/packets;
+  if(failures || (retryPercent>=retryHighPercent) || (rssi && (rssi<=rssiWeak))) {
+    goodWindows=0;
+    return current ? current-1 : 0;
+  }
+  if((retryPercent<=retryLowPercent) && (rssi==0 || rssi>=rssiStrong) && (current+1<profiles)) {
+    if(++goodWindows>=upWindows) {
+      goodWindows=0;
+      return current+1;
+    }
+  } else {
+    goodWindows=0;
+  }
+  return current;
+}
+
+uint8_t linkPolicy::evaluate(radioStats& s) {
+  uint32_t sent=s.sent+s.sentNoAck;
+  uint32_t rssiCount=s.rssiCount-lastRssiCount;
+  int16_t rssi= rssiCount ? (s.rssiTotal-lastRssiTotal)/(int32_t)rssiCount : 0;
+  uint8_t p=decide(rssi, sent-lastSent, s.retries-lastRetries, s.failedAcks-lastFailures);
+  lastSent=sent;
+  lastRetries=s.retries;
+  lastFailures=s.failedAcks;
+  lastRssiCount=s.rssiCount;
+  lastRssiTotal=s.rssiTotal;
+  return p;
+}
+
+bool linkPolicy::apply(uint8_t p) {
+  if((Radio==NULL) || (p>=profiles)) {
+    return false;
+  }
+  uint8_t modulation= (p<=home) ? home-p : 0;
+  if(modulation != ((current<=home) ? home-current : 0)) {
+    Radio->Rtt.reset();   //a new modulation changes how long replies take
+  }
+  bool ok= Radio->setModulation(modulation) && Radio->setPowerLevel((p<=home) ? 0 : p-home);
+  if(ok) {
+    current=p;
+  }
+  return ok;
+}
+
+void linkPolicy::reset(void) {
+  if(Radio && (current!=home)) {
+    apply(home);
+  }
+  goodWindows=0;
+}
@@ -0,0 +1,92 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_link_policy_h_
+#define _TwoPlayerGame_link_policy_h_
+#include "TwoPlayerGame_base_radio.h"
+/*
+ * The linkPolicy class decides which radio settings to use based on how well the link is working.
+ * It knows nothing about any particular radio. It only uses the radioStats counters and the
+ * optional modulation and power level methods of baseRadio. That means you can test it by feeding
+ * it made up statistics without any radio at all.
+ *
+ * The settings are arranged as a ladder of "profiles" numbered from 0, the most robust, up to the
+ * least robust. The bottom rungs use the slowest modulation at full power. Climbing the ladder we
+ * first speed up the modulation one step at a time. Once we reach the fastest modulation (which is
+ * what the radio uses after setup) the remaining rungs lower the transmit power one step at a time.
+ * A pair of devices sitting next to each other ends up at the top of the ladder with the fastest
+ * modulation and the lowest power. A pair at the edge of their range ends up near the bottom.
+ * The "home" profile is the fastest modulation at full power. Every game starts there.
+ *
+ * Each time "evaluate" is called it looks at what happened since the last time. If the signal
+ * was weak, too many packets needed retries, or any packet went unacknowledged, we step down one
+ * rung right away. If the signal was strong and there were almost no retries for UP_WINDOWS calls
+ * in a row, we step up one rung. The gap between the weak and strong thresholds and the number of
+ * good windows needed keep us from bouncing back and forth between two profiles.
+ *
+ *    uint8_t profiles;
+ *      Number of rungs on the ladder. Computed by begin.
+ *
+ *    uint8_t home;
+ *      The profile the radio uses after setup.
+ *
+ *    uint8_t current;
+ *      The profile we are now using.
+ *
+ *    int16_t rssiStrong, rssiWeak;
+ *    uint8_t retryHighPercent, retryLowPercent;
+ *    uint8_t upWindows;
+ *      Thresholds. You may change them after calling begin. Defaults are shown in the definitions below.
+ *
+ *    void begin(baseRadio* radio_ptr);
+ *      Builds the ladder from the number of modulations and power levels the radio supports and
+ *      resets to the home profile. Call it after the radio has been set up.
+ *
+ *    uint8_t evaluate(radioStats& s);
+ *      Compares the statistics to the copy saved last time and returns the profile we ought to be
+ *      using. It does not change the radio. Returns "current" if nothing should change.
+ *
+ *    uint8_t decide(int16_t rssi, uint32_t packets, uint32_t retries, uint32_t failures);
+ *      The heart of evaluate. Given the average signal strength and the number of packets sent,
+ *      retries, and failures in a window, returns the profile we ought to be using. "rssi" is
+ *      ignored if it is zero which means the radio doesn't measure it.
+ *
+ *    bool apply(uint8_t p);
+ *      Sets the radio to profile "p" and makes it current. Returns false if the radio refused.
+ *
+ *    void reset(void);
+ *      Goes back to the home profile and forgets the history.
+ */
+#define LINK_RSSI_STRONG   -60  //dBm, strong enough to consider climbing
+#define LINK_RSSI_WEAK     -85  //dBm, weak enough to step down
+#define LINK_RETRY_HIGH    25   //percent of packets needing a retry before we step down
+#define LINK_RETRY_LOW     5    //percent of packets needing a retry before we consider climbing
+#define LINK_UP_WINDOWS    3    //good windows in a row needed before climbing
+
+class linkPolicy {
+  public:
+    uint8_t profiles;
+    uint8_t home;
+    uint8_t current;
+    int16_t rssiStrong;
+    int16_t rssiWeak;
+    uint8_t retryHighPercent;
+    uint8_t retryLowPercent;
+    uint8_t upWindows;
+    linkPolicy(void);
+    void begin(baseRadio* radio_ptr);
+    uint8_t evaluate(radioStats& s);
+    uint8_t decide(int16_t rssi, uint32_t packets, uint32_t retries, uint32_t failures);
+    bool apply(uint8_t p);
+    void reset(void);
+  private:
+    baseRadio* Radio;
+    uint8_t goodWindows;      //good windows in a row so far
+    uint32_t lastSent, lastRetries, lastFailures, lastRssiCount;
+    int32_t lastRssiTotal;
+};
+#endif  //not defined _TwoPlayerGame_link_policy_h_
@@ -0,0 +1,131 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * This is the source code for the LoopbackRadio class. See the header file included below
+ * for details.
+ */
+#include "TwoPlayerGame_loopback.h"
+
+/*
+ * Called one time by baseGame::setup. There is no hardware so all we do is remember
+ * our address and the address of the other player and go back to the first modulation
+ * and full power.
+ */
+bool LoopbackRadio::setup(uint8_t myD,uint8_t otherD) {
+  Link->Modulation[Slot]=Link->Power[Slot]=0;
+  return setAddresses(myD,otherD);
+}
+
+/*
+ * Pretend settings. All they change is whether the other radio hears us and how strong
+ * we sound.
+ */
+bool LoopbackRadio::setModulation(uint8_t m) {
+  if(m>=Link->modulations) {
+    return false;
+  }
+  Link->Modulation[Slot]=m;
+  return true;
+}
+
+bool LoopbackRadio::setPowerLevel(uint8_t p) {
+  if(p>=Link->powerLevels) {
+    return false;
+  }
+  Link->Power[Slot]=p;
+  return true;
+}
+
+/*
+ * Our queue never changes. The link remembers our address so the other radio can tell
+ * whether its packets are addressed to us.
+ */
+bool LoopbackRadio::setAddresses(uint8_t myD, uint8_t otherD) {
+  myPlayerNum=myD;
+  otherPlayerNum=otherD;
+  Link->Address[Slot]=myD;
+  return (myD<=2) && (otherD<=2);
+}
+
+/*
+ * Places the packet in the other player's queue. It is "acknowledged" if there was room
+ * and the other radio has the address we are sending to. A failure chosen by failPercent
+ * loses either the packet or only its acknowledgment.
+ */
+bool LoopbackRadio::send(uint8_t* packet_ptr,uint8_t len) {
+  uint32_t StartTime=micros();
+  bool acked=reachable();
+  if(acked && Link->failPercent && (random(100) < Link->failPercent)) {
+    if(random(2)) {
+      Link->Queue[Slot^1].push(packet_ptr,len);
+    }
+    acked=false;
+  } else if(acked) {
+    acked=Link->Queue[Slot^1].push(packet_ptr,len);
+  }
+  Stats.countSend(len,micros()-StartTime,acked);
+  return acked;
+}
+
+/*
+ * Like a real radio, we report success whether or not the packet got there. A full queue
+ * or the wrong address loses the packet the same way a random drop does.
+ */
+bool LoopbackRadio::sendNoAck(uint8_t* packet_ptr,uint8_t len) {
+  if(reachable()) {
+    broadcast(packet_ptr,len);
+  } else {
+    Stats.countSendNoAck(len);
+  }
+  return true;
+}
+
+/*
+ * Same as sendNoAck except that the other radio gets it whatever its address. It still
+ * has to be on our modulation.
+ */
+bool LoopbackRadio::broadcast(uint8_t* packet_ptr,uint8_t len) {
+  if(tuned() && ((Link->dropPercent==0) || (random(100) >= Link->dropPercent))) {
+    Link->Queue[Slot^1].push(packet_ptr,len);
+  }
+  Stats.countSendNoAck(len);
+  return true;
+}
+
+/*
+ * Takes the oldest packet out of our queue. If the link has a signal strength it is
+ * weaker by the other radio's power level.
+ */
+bool LoopbackRadio::recv(uint8_t* packet_ptr,uint8_t* len_ptr) {
+  if(!Link->Queue[Slot].pop(packet_ptr,len_ptr)) {
+    return false;
+  }
+  Stats.countReceive(*len_ptr);
+  if(Link->rssi) {
+    Stats.countRssi(Link->rssi - LOOPBACK_POWER_STEP*Link->Power[Slot^1]);
+  }
+  return true;
+}
+
+/*
+ * Waits up to "timeout" milliseconds for a packet. Nobody else can put anything in our queue
+ * unless the other player gets a chance to run so this is only useful when the two players
+ * are on separate threads or when the other side has already sent.
+ */
+bool LoopbackRadio::recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout) {
+  uint32_t StartTime=millis();
+  do {
+    if(recv(packet_ptr,len_ptr)) {
+      Stats.countBlocked(StartTime);
+      return true;
+    }
+    yield();
+  } while((millis()-StartTime) < timeout);
+  Stats.countBlocked(StartTime);
+  return false;
+}
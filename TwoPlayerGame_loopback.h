@@ -0,0 +1,138 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * This module defines a class "LoopbackRadio" for use with the Two Player Game system.
+ * It is derived from the baseRadio class defined in "TwoPlayerGame_base_radio.h". See that
+ * file for details.
+ *
+ * Instead of transmitting over the air, two LoopbackRadio objects share a "loopbackLink"
+ * which is nothing more than a pair of in-memory packet queues, one for each direction.
+ * Each radio claims one of the queues when it is constructed and whatever it sends is placed
+ * in the other one. This lets
+ * you run both halves of a game in a single program on a single processor. It is useful
+ * for testing protocol changes and for measuring the speed of the game engine itself
+ * without any radio airtime getting in the way. It needs no hardware at all so it also
+ * works on any board or in a desktop Arduino emulation.
+ *
+ * A typical setup might look as follows:
+ *
+ *    loopbackLink Link;            //the shared "air" between the two radios
+ *    LoopbackRadio Radio1(&Link);  //radio for the first game object
+ *    LoopbackRadio Radio2(&Link);  //radio for the second game object
+ *
+ * Each radio is then passed to the constructor of its own game object exactly as you
+ * would pass an RF69Radio. See "utilities/loopback_benchmark" for an example.
+ *
+ * Because "send" simply places the packet in the other queue it is always "acknowledged"
+ * unless the queue is full. A full queue is treated as a failed send just like a missing
+ * ack on a real radio.
+ *
+ * Like a real radio, a packet sent to a player number other than the one the other radio
+ * currently has is never received. Broadcasts are always received. That lets you test the
+ * game engine deciding at runtime which device is player 1.
+ *
+ * Packets sent with "sendNoAck" have no link-level retries on a real radio so some of them
+ * never arrive. Set "dropPercent" in the loopbackLink to throw away that percentage of them
+ * at random so you can test how the game engine recovers.
+ *
+ * On a real radio even "send" sometimes gives up when every retry goes unacknowledged. Often
+ * the packet arrived and only the acknowledgments were lost. Set "failPercent" to make that
+ * percentage of sends report failure. Half of them are delivered anyway.
+ *
+ * The radio keeps the same Stats as a real one except that there are no retries. Round trip
+ * times are just the time it takes to copy the packet. There is no signal strength unless you
+ * set "rssi" in the loopbackLink to the strength in dBm of a packet sent at full power.
+ *
+ * A LoopbackRadio normally has one modulation and one power level, so baseGame's adaptiveLink
+ * has nothing to choose from. Set "modulations" and "powerLevels" in the loopbackLink before
+ * calling setup to pretend there are more. Like real radios, two radios on different
+ * modulations don't hear each other at all, broadcasts included. Each power level below full
+ * power makes the signal LOOPBACK_POWER_STEP dBm weaker. That lets you watch two game objects
+ * agree on a profile and fall back to the home profile when they lose each other. See
+ * "utilities/link_policy_test" for an example.
+ */
+#ifndef _TwoPlayerGame_loopback_h_
+#define _TwoPlayerGame_loopback_h_
+#include "TwoPlayerGame_base_radio.h"
+#include "TwoPlayerGame_frame_ring.h"
+
+//Same payload limit as the RF69HCW so that anything that works here will fit over the air
+#define LOOPBACK_MAX_MESSAGE_LEN 60
+
+//Number of packets that can be waiting in each direction. Must be a power of two.
+#define LOOPBACK_QUEUE_SIZE 8
+
+//dBm the signal drops for each power level below full power
+#define LOOPBACK_POWER_STEP 10
+
+#ifndef MAX_LEGAL_PACKET_SIZE
+  #define MAX_LEGAL_PACKET_SIZE LOOPBACK_MAX_MESSAGE_LEN
+#endif
+
+/*
+ * The queue of packets traveling in one direction is the same lock-free ring the RF69HCW 
+ * receive interrupt uses. See "TwoPlayerGame_frame_ring.h". That means the two players may
+ * run on separate threads, one pushing and the other popping.
+ */
+typedef frameRing<LOOPBACK_QUEUE_SIZE, LOOPBACK_MAX_MESSAGE_LEN> loopbackQueue;
+
+/*
+ * The shared connection between two loopback radios. Queue[0] holds packets for the first radio
+ * constructed and Queue[1] holds packets for the second. Address[] is the player number each of
+ * them currently answers to. Modulation[] and Power[] are the settings each is using.
+ *
+ *    uint8_t attach(void);
+ *      Called by the LoopbackRadio constructor. Returns which queue belongs to the new radio.
+ */
+class loopbackLink {
+  public:
+    loopbackQueue Queue[2];
+    uint8_t Address[2];
+    uint8_t Modulation[2];
+    uint8_t Power[2];
+    uint8_t dropPercent;      //percentage of sendNoAck packets to lose
+    uint8_t failPercent;      //percentage of send packets never acknowledged
+    uint8_t modulations;      //number of pretend modulations each radio offers
+    uint8_t powerLevels;      //number of pretend power levels each radio offers
+    int16_t rssi;             //dBm received at full power, zero for none
+    loopbackLink(void) {
+      dropPercent=failPercent=0; Address[0]=Address[1]=0; attached=0;
+      modulations=powerLevels=1; rssi=0;
+      Modulation[0]=Modulation[1]=Power[0]=Power[1]=0;
+    };
+    uint8_t attach(void) {return (attached++) & 1;};
+  private:
+    uint8_t attached;         //number of radios constructed so far
+};
+
+/*
+ * The class definition
+ */
+class LoopbackRadio : public baseRadio {
+  public:
+    LoopbackRadio(loopbackLink* link_ptr) {Link=link_ptr; Slot=Link->attach(); myPlayerNum=otherPlayerNum=0;};
+    bool setup(uint8_t myD,uint8_t otherD);
+    bool send(uint8_t* packet_ptr,uint8_t len);
+    bool sendNoAck(uint8_t* packet_ptr,uint8_t len);
+    bool broadcast(uint8_t* packet_ptr,uint8_t len);
+    bool setAddresses(uint8_t myD, uint8_t otherD);
+    bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout);
+    bool recv(uint8_t* packet_ptr,uint8_t* len_ptr);
+    bool available(void) {return !Link->Queue[Slot].empty();};
+    uint8_t modulations(void) {return Link->modulations;};
+    bool setModulation(uint8_t m);
+    const char* modulationName(uint8_t m) {return "loopback";};
+    uint8_t powerLevels(void) {return Link->powerLevels;};
+    bool setPowerLevel(uint8_t p);
+  private:
+    loopbackLink* Link;
+    uint8_t Slot;             //which of the link's queues is ours
+    bool tuned(void) {return Link->Modulation[0]==Link->Modulation[1];};
+    bool reachable(void) {return tuned() && (otherPlayerNum!=0) && (Link->Address[Slot^1]==otherPlayerNum);};
+};
+#endif  //not defined _TwoPlayerGame_loopback_h_
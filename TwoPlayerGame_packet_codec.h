@@ -0,0 +1,102 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_packet_codec_h_
+#define _TwoPlayerGame_packet_codec_h_
+#include <Arduino.h>
+/*
+ * Packets are not transmitted by copying the packet object itself. Instead every packet class
+ * lists its data items one at a time in a "fields" method and a packetCodec object either writes
+ * them into a frame buffer or reads them back out. The same "fields" method is used for both
+ * directions so that the sender and receiver can never disagree about the layout.
+ *
+ * The frame is tightly packed with no padding. Multi-byte integers are written least significant
+ * byte first. Enums and bools take a single byte. This means the frame is identical no matter
+ * which compiler, processor, or word size built the program so a PyBadge can talk to a
+ * PyGamer or to a 64-bit desktop program using the loopback radio.
+ *
+ * A typical "fields" method for a derived move class looks like this:
+ *
+ *    void myMove::fields(packetCodec& c) {
+ *      baseMove::fields(c);    //MUST call this first
+ *      c.field(x);             //uint8_t
+ *      c.field(y);             //int16_t
+ *      c.field(Data);          //an array such as int16_t Data[4]
+ *    }
+ *
+ *    packetCodec(uint8_t* buf_ptr, uint8_t size, bool isWriting);
+ *      Constructor. "buf_ptr" is the frame buffer and "size" is the number of bytes in it. When
+ *      writing, size is the room available. When reading, it is the number of bytes received.
+ *
+ *    bool writing;
+ *      True if we are building a frame to send, false if we are unpacking a received one.
+ *
+ *    uint8_t len;
+ *      Number of bytes written or read so far.
+ *
+ *    bool ok;
+ *      Becomes false if a field would not fit in the buffer (writing) or the frame was too short
+ *      (reading). Once false all further fields are ignored.
+ *
+ *    void field(...);
+ *      Writes or reads one data item. There are versions for 8, 16, and 32-bit integers, bool,
+ *      char, any enum with fewer than 256 values, and arrays of any of those.
+ *
+ *    void number(uint32_t& v, uint8_t n);
+ *      Writes or reads the low "n" bytes of v. Used by all of the integer versions of "field".
+ */
+
+//The largest frame we will ever build. Equal to the RF69HCW maximum message length.
+#define MAX_FRAME_SIZE 60
+
+class packetCodec {
+  public:
+    bool writing;
+    uint8_t len;
+    bool ok;
+    packetCodec(uint8_t* buf_ptr, uint8_t size, bool isWriting) {
+      buf=buf_ptr; bufSize=size; writing=isWriting; len=0; ok=true;
+    };
+    void number(uint32_t& v, uint8_t n) {
+      if(!ok || (len+n > bufSize)) {
+        ok=false;
+        return;
+      }
+      if(writing) {
+        for(uint8_t i=0;i<n;i++) {
+          buf[len+i]=(uint8_t)(v >> (8*i));
+        }
+      } else {
+        v=0;
+        for(uint8_t i=0;i<n;i++) {
+          v |= ((uint32_t)buf[len+i]) << (8*i);
+        }
+      }
+      len+=n;
+    };
+    void field(uint8_t& v)  {uint32_t t=v; number(t,1); v=(uint8_t)t;};
+    void field(int8_t& v)   {uint32_t t=(uint8_t)v; number(t,1); v=(int8_t)t;};
+    void field(char& v)     {uint32_t t=(uint8_t)v; number(t,1); v=(char)t;};
+    void field(bool& v)     {uint32_t t=v; number(t,1); v=(t!=0);};
+    void field(uint16_t& v) {uint32_t t=v; number(t,2); v=(uint16_t)t;};
+    void field(int16_t& v)  {uint32_t t=(uint16_t)v; number(t,2); v=(int16_t)t;};
+    void field(uint32_t& v) {number(v,4);};
+    void field(int32_t& v)  {uint32_t t=(uint32_t)v; number(t,4); v=(int32_t)t;};
+    template<class E> void field(E& e) {
+      static_assert(__is_enum(E), "packetCodec::field handles integers, bool, char, enums and arrays");
+      uint32_t t=(uint8_t)e; number(t,1); e=(E)t;
+    };
+    template<class T, size_t N> void field(T (&a)[N]) {
+      for(size_t i=0;i<N;i++) {
+        field(a[i]);
+      }
+    };
+  private:
+    uint8_t* buf;
+    uint8_t bufSize;
+};
+#endif //not defined _TwoPlayerGame_packet_codec_h_
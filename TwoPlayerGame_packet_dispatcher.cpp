@@ -0,0 +1,102 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * Source code for the packetDispatcher class. See "TwoPlayerGame_packet_dispatcher.h" for details.
+ */
+#include "TwoPlayerGame_packet_dispatcher.h"
+
+void packetDispatcher::clear(void) {
+  for(uint8_t t=0;t<DISPATCH_TYPES;t++) {
+    head[t]=tail[t]=NONE;
+  }
+  for(uint8_t i=0;i<DISPATCH_FRAMES;i++) {
+    links[i]= (i+1<DISPATCH_FRAMES) ? i+1 : NONE;
+  }
+  freeList=0;
+  used=0;
+  arrivals=0;
+}
+
+/*
+ * Returns the type whose oldest frame is older than that of any other type in "types" or
+ * NONE if none of them has anything waiting. Stamps wrap around so we compare differences.
+ */
+uint8_t packetDispatcher::oldest(uint16_t types) {
+  uint8_t best=NONE;
+  for(uint8_t t=0;t<DISPATCH_TYPES;t++) {
+    if((types & DISPATCH_TYPE(t)) && (head[t]!=NONE)) {
+      if((best==NONE) || ((int16_t)(stamps[head[t]]-stamps[head[best]]) < 0)) {
+        best=t;
+      }
+    }
+  }
+  return best;
+}
+
+/*
+ * Unlinks the oldest frame of "type", copies it out if "buf" is not NULL, and returns its buffer
+ * to the free list.
+ */
+void packetDispatcher::remove(uint8_t type, uint8_t* buf, uint8_t* len_ptr) {
+  uint8_t i=head[type];
+  if(buf) {
+    if(*len_ptr > lengths[i]) {
+      *len_ptr=lengths[i];
+    }
+    memcpy(buf,data[i],*len_ptr);
+  }
+  head[type]=links[i];
+  if(head[type]==NONE) {
+    tail[type]=NONE;
+  }
+  links[i]=freeList;
+  freeList=i;
+  used--;
+}
+
+bool packetDispatcher::store(uint8_t* buf, uint8_t len) {
+  if((len==0) || (len>MAX_FRAME_SIZE)) {
+    return false;
+  }
+  if(freeList==NONE) {
+    remove(oldest(0xffff),NULL,NULL);
+    dropped++;
+  }
+  uint8_t type=buf[0] >> 4;
+  uint8_t i=freeList;
+  freeList=links[i];
+  memcpy(data[i],buf,len);
+  lengths[i]=len;
+  stamps[i]=arrivals++;
+  links[i]=NONE;
+  if(tail[type]==NONE) {
+    head[type]=i;
+  } else {
+    links[tail[type]]=i;
+  }
+  tail[type]=i;
+  used++;
+  return true;
+}
+
+bool packetDispatcher::take(uint8_t type, uint8_t* buf, uint8_t* len_ptr) {
+  if(!waiting(type)) {
+    return false;
+  }
+  remove(type,buf,len_ptr);
+  return true;
+}
+
+bool packetDispatcher::takeAny(uint16_t types, uint8_t* buf, uint8_t* len_ptr) {
+  uint8_t type=oldest(types);
+  if(type==NONE) {
+    return false;
+  }
+  remove(type,buf,len_ptr);
+  return true;
+}
@@ -0,0 +1,80 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_packet_dispatcher_h_
+#define _TwoPlayerGame_packet_dispatcher_h_
+#include "TwoPlayerGame_packet_codec.h"
+/*
+ * A radio hands us frames in whatever order they arrive but the game engine usually wants one
+ * particular type of packet at a time. Rather than throwing away everything else, received
+ * frames are kept in a packetDispatcher until somebody asks for their type. A packet that shows
+ * up early, for example a COIN_FLIP_PACKET that arrives right behind a FOUND_GAME_PACKET, is
+ * still there when we get around to wanting it so it never has to be sent again.
+ *
+ * There is a fixed pool of DISPATCH_FRAMES frame buffers and no heap. Each frame is filed in a
+ * queue according to the type in the upper 4 bits of its header byte, so there are 16 queues.
+ * A frame holding more than one packet is filed under the type of the first one. If every buffer
+ * is in use when a new frame arrives, the oldest frame of any type is thrown away to make room
+ * because something that has been ignored that long is probably stale.
+ *
+ * Every radio contains one of these named "Inbox". Call Radio->pump() to move whatever the radio
+ * has received into it. basePacket and the game engine do that for you.
+ *
+ *    uint32_t dropped;
+ *      Number of frames thrown away to make room.
+ *
+ *    void clear(void);
+ *      Throws away every waiting frame. The game engine does this at the end of each game.
+ *
+ *    bool store(uint8_t* buf, uint8_t len);
+ *      Files a received frame. Returns false if it was empty or too large.
+ *
+ *    bool take(uint8_t type, uint8_t* buf, uint8_t* len_ptr);
+ *      Copies the oldest frame of the given type into "buf" and removes it. On entry len_ptr points
+ *      to the size of the buffer, on return it holds the length of the frame. A frame larger than
+ *      the buffer is truncated. Returns false if there was none.
+ *
+ *    bool takeAny(uint16_t types, uint8_t* buf, uint8_t* len_ptr);
+ *      Same as take except that it takes the oldest frame of any type whose bit is set in "types".
+ *      Use DISPATCH_TYPE(t) to make the bits. Frames of different types come out in the order
+ *      they arrived.
+ *
+ *    bool waiting(uint8_t type);
+ *      Returns true if a frame of the given type is waiting.
+ *
+ *    uint8_t count(void);
+ *      Returns the number of frames waiting of all types.
+ */
+#define DISPATCH_FRAMES 8       //frames that can be waiting at once
+#define DISPATCH_TYPES  16      //one queue for each possible packet type
+#define DISPATCH_TYPE(t) ((uint16_t)1 << (t))
+
+class packetDispatcher {
+  public:
+    uint32_t dropped;
+    packetDispatcher(void) {dropped=0; clear();};
+    void clear(void);
+    bool store(uint8_t* buf, uint8_t len);
+    bool take(uint8_t type, uint8_t* buf, uint8_t* len_ptr);
+    bool takeAny(uint16_t types, uint8_t* buf, uint8_t* len_ptr);
+    bool waiting(uint8_t type) {return (type<DISPATCH_TYPES) && (head[type]!=NONE);};
+    uint8_t count(void) {return used;};
+  private:
+    static const uint8_t NONE=0xff;
+    uint8_t data[DISPATCH_FRAMES][MAX_FRAME_SIZE];
+    uint8_t lengths[DISPATCH_FRAMES];
+    uint16_t stamps[DISPATCH_FRAMES];   //arrival order
+    uint8_t links[DISPATCH_FRAMES];     //next frame of the same type, or next free buffer
+    uint8_t head[DISPATCH_TYPES];       //oldest frame of each type
+    uint8_t tail[DISPATCH_TYPES];       //newest frame of each type
+    uint8_t freeList;
+    uint8_t used;
+    uint16_t arrivals;
+    uint8_t oldest(uint16_t types);
+    void remove(uint8_t type, uint8_t* buf, uint8_t* len_ptr);
+};
+#endif  //not defined _TwoPlayerGame_packet_dispatcher_h_
@@ -0,0 +1,118 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+/*
+ * Source code for the radioStats class. See "TwoPlayerGame_radio_stats.h" for details.
+ */
+#include "TwoPlayerGame_radio_stats.h"
+
+void radioStats::reset(void) {
+  sent=sentNoAck=failedAcks=retries=received=0;
+  bytesSent=bytesReceived=0;
+  rttMin=0xffffffff; rttMax=rttTotal=0;
+  for(uint8_t i=0;i<RADIO_RTT_BUCKETS;i++) {
+    rttHistogram[i]=0;
+  }
+  rssiLast=rssiMin=rssiMax=0;
+  rssiTotal=0;
+  rssiCount=0;
+  blockedMillis=0;
+  heartbeatsSent=heartbeatsReceived=0;
+}
+
+/*
+ * Records a packet sent with "send". Round trip times only mean something if the packet
+ * was acknowledged. The histogram bucket is found by halving the time in milliseconds
+ * until it reaches zero.
+ */
+void radioStats::countSend(uint8_t len, uint32_t rtt, bool acked) {
+  sent++;
+  bytesSent+=len;
+  if(!acked) {
+    failedAcks++;
+    return;
+  }
+  rttTotal+=rtt;
+  if(rtt<rttMin) rttMin=rtt;
+  if(rtt>rttMax) rttMax=rtt;
+  uint8_t bucket=0;
+  for(uint32_t ms=rtt/1000; ms && (bucket<RADIO_RTT_BUCKETS-1); ms>>=1) {
+    bucket++;
+  }
+  rttHistogram[bucket]++;
+}
+
+void radioStats::countRssi(int16_t rssi) {
+  if(rssiCount==0 || rssi<rssiMin) rssiMin=rssi;
+  if(rssiCount==0 || rssi>rssiMax) rssiMax=rssi;
+  rssiLast=rssi;
+  rssiTotal+=rssi;
+  rssiCount++;
+}
+
+uint32_t radioStats::rttAverage(void) {
+  uint32_t acked=sent-failedAcks;
+  return acked ? rttTotal/acked : 0;
+}
+
+/*
+ * Walks up the histogram until we have passed the requested percentage of round trips.
+ * Bucket "i" holds times under 2^i milliseconds. The last bucket has no upper limit so
+ * we report the longest time we have seen instead.
+ */
+uint32_t radioStats::rttPercentile(uint8_t percent) {
+  uint32_t acked=sent-failedAcks;
+  if(acked==0) {
+    return 0;
+  }
+  uint32_t wanted=(acked*percent+99)/100;
+  uint32_t total=0;
+  for(uint8_t i=0;i<RADIO_RTT_BUCKETS-1;i++) {
+    total+=rttHistogram[i];
+    if(total>=wanted) {
+      return 1UL << i;
+    }
+  }
+  return rttMax/1000;
+}
+
+void radioStats::print(void) {
+  Serial.print("Radio stats: sent="); Serial.print(sent);
+  Serial.print(" sentNoAck="); Serial.print(sentNoAck);
+  Serial.print(" failedAcks="); Serial.print(failedAcks);
+  Serial.print(" retries="); Serial.print(retries);
+  Serial.print(" received="); Serial.println(received);
+  Serial.print("  bytesSent="); Serial.print(bytesSent);
+  Serial.print(" bytesReceived="); Serial.print(bytesReceived);
+  Serial.print(" blockedMillis="); Serial.println(blockedMillis);
+  if(heartbeatsSent || heartbeatsReceived) {
+    Serial.print("  heartbeatsSent="); Serial.print(heartbeatsSent);
+    Serial.print(" heartbeatsReceived="); Serial.println(heartbeatsReceived);
+  }
+  if(sent>failedAcks) {
+    Serial.print("  RTT usec min="); Serial.print(rttMin);
+    Serial.print(" avg="); Serial.print(rttAverage());
+    Serial.print(" max="); Serial.print(rttMax);
+    Serial.print(" p50 ms<="); Serial.print(rttPercentile(50));
+    Serial.print(" p99 ms<="); Serial.println(rttPercentile(99));
+    Serial.print("  RTT histogram ms:");
+    for(uint8_t i=0;i<RADIO_RTT_BUCKETS;i++) {
+      Serial.print(i==RADIO_RTT_BUCKETS-1 ? " more=" : " <");
+      if(i<RADIO_RTT_BUCKETS-1) {
+        Serial.print(1UL << i); Serial.print("=");
+      }
+      Serial.print(rttHistogram[i]);
+    }
+    Serial.println();
+  }
+  if(rssiCount) {
+    Serial.print("  RSSI dBm last="); Serial.print(rssiLast);
+    Serial.print(" min="); Serial.print(rssiMin);
+    Serial.print(" avg="); Serial.print(rssiAverage());
+    Serial.print(" max="); Serial.println(rssiMax);
+  }
+}
@@ -0,0 +1,123 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_radio_stats_h_
+#define _TwoPlayerGame_radio_stats_h_
+#include <Arduino.h>
+/*
+ * Every radio object contains a "radioStats" object named "Stats" that keeps track of how well
+ * the link is working. The radio classes supplied with the library fill it in for you. If you write
+ * your own radio class you should call the "count" methods below from your send and receive methods
+ * so that your radio reports the same information. You can read any of the data members at any time,
+ * for example "Radio.Stats.failedAcks". Call "Radio.Stats.reset()" to start over.
+ *
+ * Round trip times are the time from the start of a send until its acknowledgment arrives. They are
+ * measured in microseconds. Besides the minimum, maximum, and total, they are counted in a histogram
+ * with RADIO_RTT_BUCKETS buckets. Bucket 0 counts round trips under 1 millisecond, bucket 1 under
+ * 2 milliseconds, bucket 2 under 4 milliseconds and so on. The last bucket counts everything longer.
+ *
+ *    uint32_t sent, sentNoAck;
+ *      Number of packets sent with send and with sendNoAck.
+ *
+ *    uint32_t failedAcks;
+ *      Number of packets sent with send that were never acknowledged.
+ *
+ *    uint32_t retries;
+ *      Number of times the radio transmitted a packet again because the acknowledgment didn't arrive.
+ *
+ *    uint32_t received;
+ *      Number of packets received.
+ *
+ *    uint32_t bytesSent, bytesReceived;
+ *      Total payload bytes in each direction. Headers and acknowledgments added by the radio are not counted.
+ *
+ *    uint32_t rttMin, rttMax, rttTotal;
+ *    uint32_t rttHistogram[RADIO_RTT_BUCKETS];
+ *      Round trip times of acknowledged packets in microseconds. See above.
+ *
+ *    int16_t rssiLast, rssiMin, rssiMax;
+ *    int32_t rssiTotal;
+ *    uint32_t rssiCount;
+ *      Received signal strength in dBm of received packets. Radios that have no such thing don't count it.
+ *
+ *    uint32_t blockedMillis;
+ *      Total time spent waiting in recvTimeout or basePacket::requireType.
+ *
+ *    uint32_t heartbeatsSent, heartbeatsReceived;
+ *      Heartbeat packets the game engine sent and received. They are also included in sentNoAck,
+ *      received, and the byte counts above so that their airtime is part of the totals. These
+ *      tell you how much of it they were responsible for. See baseGame::heartbeats.
+ *
+ *    void reset(void);
+ *      Sets everything back to zero.
+ *
+ *    void countSend(uint8_t len, uint32_t rtt, bool acked);
+ *    void countSendNoAck(uint8_t len);
+ *    void countRetries(uint32_t n);
+ *    void countReceive(uint8_t len);
+ *    void countRssi(int16_t rssi);
+ *    void countBlocked(uint32_t start);
+ *      Called by radio classes to record a packet sent with send, a packet sent with sendNoAck,
+ *      retransmissions, a packet received, its signal strength, and time spent waiting since
+ *      "start" which is a value previously returned by millis().
+ *
+ *    void countHeartbeatSent(void);
+ *    void countHeartbeatReceived(void);
+ *      Called by the game engine for each heartbeat.
+ *
+ *    uint32_t rttAverage(void);
+ *    int16_t rssiAverage(void);
+ *      Average round trip time in microseconds and average signal strength.
+ *
+ *    uint32_t rttPercentile(uint8_t percent);
+ *      Returns the upper limit in milliseconds of the histogram bucket containing the given percentile
+ *      of round trips. For example rttPercentile(99) returns 8 if at least 99% of round trips took
+ *      less than 8 milliseconds. Returns zero if nothing has been counted.
+ *
+ *    void print(void);
+ *      Prints everything on the serial monitor. The game engine calls this at the end of each game
+ *      when TPG_DEBUG is turned on.
+ */
+#define RADIO_RTT_BUCKETS 12
+
+class radioStats {
+  public:
+    uint32_t sent;
+    uint32_t sentNoAck;
+    uint32_t failedAcks;
+    uint32_t retries;
+    uint32_t received;
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+    uint32_t rttMin;
+    uint32_t rttMax;
+    uint32_t rttTotal;
+    uint32_t rttHistogram[RADIO_RTT_BUCKETS];
+    int16_t rssiLast;
+    int16_t rssiMin;
+    int16_t rssiMax;
+    int32_t rssiTotal;
+    uint32_t rssiCount;
+    uint32_t blockedMillis;
+    uint32_t heartbeatsSent;
+    uint32_t heartbeatsReceived;
+    radioStats(void) {reset();};
+    void reset(void);
+    void countSend(uint8_t len, uint32_t rtt, bool acked);
+    void countSendNoAck(uint8_t len) {sentNoAck++; bytesSent+=len;};
+    void countRetries(uint32_t n) {retries+=n;};
+    void countReceive(uint8_t len) {received++; bytesReceived+=len;};
+    void countRssi(int16_t rssi);
+    void countBlocked(uint32_t start) {blockedMillis+= millis()-start;};
+    void countHeartbeatSent(void) {heartbeatsSent++;};
+    void countHeartbeatReceived(void) {heartbeatsReceived++;};
+    uint32_t rttAverage(void);
+    int16_t rssiAverage(void) {return rssiCount ? rssiTotal/(int32_t)rssiCount : 0;};
+    uint32_t rttPercentile(uint8_t percent);
+    void print(void);
+};
+#endif  //not defined _TwoPlayerGame_radio_stats_h_
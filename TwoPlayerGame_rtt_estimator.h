@@ -0,0 +1,88 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_rtt_estimator_h_
+#define _TwoPlayerGame_rtt_estimator_h_
+#include <Arduino.h>
+/*
+ * Rather than using fixed timeouts the game engine measures how long the other device takes to
+ * reply and waits a little longer than that. This is the same method TCP uses, invented by Van
+ * Jacobson and Mike Karels. We keep a smoothed average round trip time "srtt" and a smoothed
+ * average of how far each sample strays from it "rttvar". Each new sample moves srtt 1/8 of the
+ * way toward it and rttvar 1/4 of the way toward its deviation. The timeout is srtt plus four
+ * times rttvar, limited to between minTimeout and maxTimeout. Until the first sample arrives
+ * we use initialTimeout.
+ *
+ * When a wait times out and we try again, call "backoff". It doubles the timeout each time until
+ * the next sample. Never take a sample from an exchange that was tried more than once because
+ * you can't tell which try the reply belongs to.
+ *
+ * Every radio contains one of these named "Rtt". The game engine feeds it and uses it for all of
+ * its waits. You can use it for your own with "Radio->Rtt.timeout()".
+ *
+ *    uint32_t srtt, rttvar;
+ *      Smoothed round trip time and its variation in microseconds. Both are zero until the first sample.
+ *
+ *    uint16_t minTimeout, maxTimeout, initialTimeout;
+ *      Limits in milliseconds. Defaults are shown below. You may change them.
+ *
+ *    void sample(uint32_t rtt);
+ *      Adds a round trip time in microseconds and cancels any backoff.
+ *
+ *    uint16_t timeout(void);
+ *      How many milliseconds to wait for a reply including any backoff.
+ *
+ *    void backoff(void);
+ *      Doubles the timeout until the next sample.
+ *
+ *    void endBackoff(void);
+ *      Cancels any backoff without taking a sample. Use it when a reply finally arrives but
+ *      you can't use it as a sample. Otherwise the backoff would never end if you seldom take samples.
+ *
+ *    void reset(void);
+ *      Forgets all samples. Use it when the link changes, for example a new modulation.
+ */
+#define RTT_INITIAL_TIMEOUT 1000
+#define RTT_MIN_TIMEOUT     20
+#define RTT_MAX_TIMEOUT     4000
+
+class rttEstimator {
+  public:
+    uint32_t srtt;
+    uint32_t rttvar;
+    uint16_t minTimeout;
+    uint16_t maxTimeout;
+    uint16_t initialTimeout;
+    rttEstimator(void) {
+      minTimeout=RTT_MIN_TIMEOUT; maxTimeout=RTT_MAX_TIMEOUT; initialTimeout=RTT_INITIAL_TIMEOUT;
+      reset();
+    };
+    void sample(uint32_t rtt) {
+      if(srtt==0) {
+        srtt= rtt ? rtt : 1;
+        rttvar=rtt/2;
+      } else {
+        uint32_t err= (rtt>srtt) ? rtt-srtt : srtt-rtt;
+        rttvar= rttvar - rttvar/4 + err/4;
+        srtt= srtt - srtt/8 + rtt/8;
+        if(srtt==0) srtt=1;
+      }
+      backoffShift=0;
+    };
+    uint16_t timeout(void) {
+      uint32_t t= srtt ? (srtt + 4*rttvar + 999)/1000 : initialTimeout;
+      if(t<minTimeout) t=minTimeout;
+      t <<= backoffShift;
+      return (t>maxTimeout) ? maxTimeout : t;
+    };
+    void backoff(void) {if(backoffShift<8) backoffShift++;};
+    void endBackoff(void) {backoffShift=0;};
+    void reset(void) {srtt=rttvar=0; backoffShift=0;};
+  private:
+    uint8_t backoffShift;
+};
+#endif  //not defined _TwoPlayerGame_rtt_estimator_h_
@@ -0,0 +1,218 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_search_h_
+#define _TwoPlayerGame_search_h_
+#include <Arduino.h>
+/*
+ * Looks ahead to find a good move for a computer player in any game where both players can see
+ * the whole board. It is the way chess programs have always done it: alpha-beta search, deepened
+ * one move at a time for as long as the time allowed lasts, with a transposition table remembering
+ * positions it has already searched. Everything lives inside the gameSearch object so there is no
+ * heap. Make it a global and its size shows up when you compile.
+ *
+ * You describe your game with a position class P. gameSearch only ever calls these:
+ *
+ *    typedef ... move_t;
+ *      A move. Keep it small, a square number for example.
+ *
+ *    uint8_t moves(move_t* list);
+ *      Fills in every legal move for the player to move and returns how many there are, never more
+ *      than MAX_MOVES. Returns zero when the game is over.
+ *
+ *    void apply(move_t m);
+ *    void undo(move_t m);
+ *      Makes move "m" and takes it back again. After apply it is the other player's turn.
+ *
+ *    int16_t evaluate(void);
+ *      How good the position is for the player to move. When the game is over it MUST be the result:
+ *      SEARCH_WIN for a win, -SEARCH_WIN for a loss, or zero for a draw. Otherwise it is a guess
+ *      well inside SEARCH_DECIDED either way. Zero will do if you have nothing better.
+ *
+ *    uint32_t hash(void);
+ *      A hash of the position including whose turn it is. A zobristHash kept up to date in apply and
+ *      undo is ideal.
+ *
+ * The search looks ahead from the player to move. A win found closer to the root scores more than
+ * one further away, and a loss less, so it wins as quickly as it can and loses as slowly.
+ *
+ *    template<class P, uint16_t TABLE_SIZE=1024, uint8_t MAX_PLY=16, uint8_t MAX_MOVES=16>
+ *      TABLE_SIZE is the number of transposition table entries and MUST be a power of two. Each is
+ *      8 bytes plus a move_t, about 10K for the default. MAX_PLY is the deepest the search goes
+ *      and MAX_MOVES the most moves a position can have. There is a move list of MAX_MOVES for
+ *      each ply.
+ *
+ *    P::move_t think(P& position, uint16_t ms, uint8_t maxDepth=MAX_PLY);
+ *      Call from decideMyMove. Returns the best move found in "ms" milliseconds, or sooner if it
+ *      searched "maxDepth" moves ahead or found a forced win or loss. The position is left as it
+ *      was. There MUST be a legal move.
+ *
+ *    void ponder(P& position, uint16_t ms);
+ *      The same without returning a move. Call it a few milliseconds at a time while your opponent
+ *      thinks, from baseGame::idleWork for example. What it finds stays in the table so think is
+ *      quicker afterwards. Pondering the same position again carries on one move deeper, and so
+ *      does thinking about the position last pondered.
+ *
+ *    void clear(void);
+ *      Forgets the table. Call it at the start of each game.
+ *
+ *    uint32_t nodes;
+ *    uint8_t depth;
+ *    int16_t score;
+ *      How many positions the last think or ponder visited, how many moves ahead it finished
+ *      searching and what that search scored the position.
+ */
+#define SEARCH_WIN  30000
+#define SEARCH_INFINITY 32000
+//Scores this close to SEARCH_WIN are forced wins or losses, adjusted for how far away they are.
+#define SEARCH_DECIDED (SEARCH_WIN-256)
+
+template<class P, uint16_t TABLE_SIZE=1024, uint8_t MAX_PLY=16, uint8_t MAX_MOVES=16>
+class gameSearch {
+  public:
+    typedef typename P::move_t move_t;
+    uint32_t nodes;
+    uint8_t depth;
+    int16_t score;
+    gameSearch(void) {clear();};
+    void clear(void) {
+      memset(table,0,sizeof(table));
+      ponderKey=0; depth=0;
+    };
+    move_t think(P& position, uint16_t ms, uint8_t maxDepth=MAX_PLY) {
+      uint8_t from= (position.hash()==ponderKey) ? depth+1 : 1;
+      ponderKey=0;
+      return deepen(position, ms, maxDepth, (from>maxDepth) ? maxDepth : from);
+    };
+    void ponder(P& position, uint16_t ms) {
+      uint32_t key=position.hash();
+      uint8_t from= (key==ponderKey) ? depth+1 : 1;
+      if(from<=MAX_PLY) {
+        deepen(position, ms, MAX_PLY, from);
+      }
+      ponderKey=key;
+    };
+  private:
+    enum bound_t {EMPTY_BOUND, EXACT_BOUND, LOWER_BOUND, UPPER_BOUND};
+    struct entry_t {
+      uint32_t key;
+      int16_t score;
+      uint8_t depth;
+      uint8_t bound;
+      move_t move;
+    };
+    static_assert((TABLE_SIZE & (TABLE_SIZE-1))==0, "TABLE_SIZE must be a power of two");
+    entry_t table[TABLE_SIZE];
+    move_t list[MAX_PLY+1][MAX_MOVES];
+    uint32_t startTime, ponderKey;
+    uint16_t budget;
+    bool aborted;
+
+    //Iterative deepening. Each pass starts from what the table learned in the one before.
+    move_t deepen(P& position, uint16_t ms, uint8_t maxDepth, uint8_t from) {
+      startTime=millis(); budget=ms;
+      nodes=0; aborted=false;
+      depth=from-1;
+      if(from==1) {
+        score=0;
+      }
+      uint8_t n=position.moves(list[0]);
+      move_t best=list[0][0];
+      entry_t& e=table[position.hash() & (TABLE_SIZE-1)];
+      if(maxDepth>MAX_PLY) {
+        maxDepth=MAX_PLY;
+      }
+      if(n && (from>1) && (e.key==position.hash())) {
+        best=e.move;    //Pondering got this far already
+      }
+      for(uint8_t d=from; d<=maxDepth; d++) {
+        int16_t s=search(position, d, -SEARCH_INFINITY, SEARCH_INFINITY, 0);
+        if(aborted) {
+          break;
+        }
+        depth=d; score=s;
+        if(n && (e.key==position.hash())) {
+          best=e.move;
+        }
+        if((s>=SEARCH_DECIDED) || (s<=-SEARCH_DECIDED)) {
+          break;    //Looking further won't change a forced result
+        }
+      }
+      return best;
+    };
+
+    //Alpha-beta in negamax form. Returns the score for the player to move.
+    int16_t search(P& position, uint8_t d, int16_t alpha, int16_t beta, uint8_t ply) {
+      if((++nodes & 255)==0 && (millis()-startTime >= budget)) {
+        aborted=true;
+      }
+      if(aborted) {
+        return 0;
+      }
+      move_t* moves=list[ply];
+      uint8_t n=position.moves(moves);
+      if(n==0) {
+        int16_t s=position.evaluate();
+        return (s>=SEARCH_WIN) ? s-ply : (s<=-SEARCH_WIN) ? s+ply : s;
+      }
+      if((d==0) || (ply==MAX_PLY)) {
+        return position.evaluate();
+      }
+      uint32_t key=position.hash();
+      entry_t& e=table[key & (TABLE_SIZE-1)];
+      if(e.key==key && e.bound!=EMPTY_BOUND) {
+        if(e.depth>=d) {
+          int16_t s=fromTable(e.score, ply);
+          if((e.bound==EXACT_BOUND) || ((e.bound==LOWER_BOUND) && (s>=beta))
+             || ((e.bound==UPPER_BOUND) && (s<=alpha))) {
+            return s;
+          }
+        }
+        for(uint8_t i=1;i<n;i++) {    //Try the move that was best last time first
+          if(moves[i]==e.move) {
+            moves[i]=moves[0]; moves[0]=e.move;
+            break;
+          }
+        }
+      }
+      int16_t first=alpha;
+      int16_t best=-SEARCH_INFINITY;
+      move_t bestMove=moves[0];
+      for(uint8_t i=0;i<n;i++) {
+        position.apply(moves[i]);
+        int16_t s=-search(position, d-1, -beta, -alpha, ply+1);
+        position.undo(moves[i]);
+        if(aborted) {
+          return 0;
+        }
+        if(s>best) {
+          best=s; bestMove=moves[i];
+        }
+        if(s>alpha) {
+          alpha=s;
+        }
+        if(alpha>=beta) {
+          break;
+        }
+      }
+      if((e.key!=key) || (d>=e.depth)) {
+        e.key=key; e.depth=d; e.move=bestMove;
+        e.score=toTable(best, ply);
+        e.bound= (best<=first) ? UPPER_BOUND : (best>=beta) ? LOWER_BOUND : EXACT_BOUND;
+      }
+      return best;
+    };
+
+    //Forced results are stored as distance from the position, not from the root
+    static int16_t toTable(int16_t s, uint8_t ply) {
+      return (s>=SEARCH_DECIDED) ? s+ply : (s<=-SEARCH_DECIDED) ? s-ply : s;
+    };
+    static int16_t fromTable(int16_t s, uint8_t ply) {
+      return (s>=SEARCH_DECIDED) ? s-ply : (s<=-SEARCH_DECIDED) ? s+ply : s;
+    };
+};
+#endif  //not defined _TwoPlayerGame_search_h_
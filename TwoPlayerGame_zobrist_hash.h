@@ -0,0 +1,54 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ **********************************************************/
+#ifndef _TwoPlayerGame_zobrist_hash_h_
+#define _TwoPlayerGame_zobrist_hash_h_
+#include <Arduino.h>
+/*
+ * A 32-bit summary of everything both players can see, used by baseGame::hashCheck to notice
+ * that the two devices no longer agree about the game. This is the method Albert Zobrist invented
+ * for chess programs. Every possible fact about the game, for example "player 1 hit square 37", is
+ * given a number called a feature. Each feature has its own random looking 32-bit key and the hash
+ * is all of the keys of the facts that are true exclusive-or'ed together. Adding or removing a fact
+ * is a single exclusive-or no matter how big the game is, and doing it twice undoes it.
+ *
+ * Rather than keeping a table of random keys in memory, the key for a feature is made by scrambling
+ * the feature number with the finishing step of the MurmurHash3 hash function. Every feature
+ * gets a different key and both devices always compute the same one.
+ *
+ * Features MUST mean the same thing on both devices. Describe players by player number or by
+ * whether they make the odd or even numbered moves, never as "me" and "my opponent".
+ *
+ *    uint32_t value;
+ *      The hash. Zero when nothing has been added.
+ *
+ *    void reset(void);
+ *      Sets the hash back to zero. Call it whenever a new game starts.
+ *
+ *    void toggle(uint16_t feature);
+ *      Adds a fact that was not true or removes one that was.
+ *
+ *    static uint32_t key(uint16_t feature);
+ *      Returns the key for a feature.
+ */
+class zobristHash {
+  public:
+    uint32_t value;
+    zobristHash(void) {reset();};
+    void reset(void) {value=0;};
+    void toggle(uint16_t feature) {value ^= key(feature);};
+    static uint32_t key(uint16_t feature) {
+      uint32_t h= (feature+1) * 0x9E3779B9UL;
+      h ^= h >> 16;
+      h *= 0x85EBCA6BUL;
+      h ^= h >> 13;
+      h *= 0xC2B2AE35UL;
+      h ^= h >> 16;
+      return h;
+    };
+};
+#endif  //not defined _TwoPlayerGame_zobrist_hash_h_
@@ -10,6 +10,7 @@
  **********************************************************/
 /*
  * This demonstration program implements a classic Battleship game using a 10 x 10 grid.
+ * Each board is kept as a few bitBoard masks rather than one value per square.
  */
 #include "Adafruit_Arcada.h"
 
@@ -25,6 +26,40 @@
 //initial state of sound effects. Can be toggled using "B" button during any move
 #define USE_AUDIO true
 
+//Set this to true to send the results of your opponent's shot along with your next shot.
+//Uses half as many radio exchanges but you don't learn if you hit until your opponent fires.
+//Both devices MUST use the same setting.
+#define PIGGYBACK_RESULTS false
+
+//Set this to true to sleep while waiting on your opponent and dim the display after a while.
+//Saves a lot of battery in a long game. Any button brightens the display again.
+#define LOW_POWER true
+//Backlight level while dimmed, 0 to 255
+#define DIM_BACKLIGHT 16
+
+//Set this to true to record every game in "/journal.tpj" so that it can be played back later
+//with the journal_replay utility. The file grows by a kilobyte or two a game until you delete it.
+#define KEEP_JOURNAL true
+
+//Set this to false to have random ship placement appear all at once instead of a ship at a time.
+//Either way the layout itself is chosen in well under a millisecond. See randomFleet.
+#define ANIMATE_PLACEMENT true
+
+//Set this to true to let the computer place your ships and choose your shots. See computer_player.h
+//Nothing waits on a button so the game plays itself. Handy for demonstrations and soak tests.
+#define COMPUTER_PLAYS false
+
+//Set this to true to play against the computer on this one device. No radio is needed. The computer
+//is a second game object talking to yours through computerRadio. See computer_opponent.h
+//A game against the computer is not saved.
+#define SINGLE_PLAYER false
+
+//Size of the grid. Anything up to 20 x 20 fits on the screen. Both devices MUST use the same size.
+//Resync and saving the game need both boards to fit in one frame so they are turned off for
+//grids of more than about 100 squares.
+#define GRID_WIDTH  10
+#define GRID_HEIGHT 10
+
 #if(ACCESSIBLE_INPUT)
   #include <AccessibleArcada.h>   //alternate input system for assistive technology
   AccessibleArcada Device;
@@ -32,6 +67,12 @@
   Adafruit_Arcada Device;
 #endif
 #include <TwoPlayerGame_wave.h>       //Everything for audio playback
+#include <TwoPlayerGame_file_store.h> //Saves the game so it survives a reset
+fileStore SaveFile(&Device);
+#if(KEEP_JOURNAL)
+  #include <TwoPlayerGame_file_journal.h> //Records every game
+  fileJournal GameLog(&Device);
+#endif
 
 //Font used in opening splash screen
 #include <Fonts/FreeSans12pt7b.h>
@@ -40,54 +81,122 @@
  * Various global variables not really part of the game engine object. Need to be able to
  * access these from a variety of locations so we made them global.
  *************************************************************************************/
+#define GRID_CELLS (GRID_WIDTH*GRID_HEIGHT)
+//A set of squares on our grid. See "TwoPlayerGame_bitboard.h"
+typedef bitBoard<GRID_WIDTH,GRID_HEIGHT> mask_t;
+//The number of a square. One byte unless the grid has more than 255 squares.
+#if (GRID_CELLS > 255)
+  typedef uint16_t cell_t;
+#else
+  typedef uint8_t cell_t;
+#endif
+//Ship index of a ship that has not been placed
+#define NOT_PLACED GRID_CELLS
+//Bytes needed for the shots on one board at two bits a square. See packShots
+#define SHOT_BYTES ((GRID_CELLS+3)/4)
+//A resync snapshot is both boards and a byte of sunk ships after a 4 byte resync packet
+#define SNAPSHOT_FITS (2*SHOT_BYTES+1 <= MAX_FRAME_SIZE-4)
+
 //Data structure for location of the ship and all its info
 struct ship_t {
-  int8_t index;     //Location of the ship. If -1 then the ship has not yet been placed.
-  uint8_t hits;     //The number of hits it has received
+  cell_t index;     //Location of the ship. If NOT_PLACED then the ship has not yet been placed.
   bool vertical;    //Orientation vertical or horizontal
   bool sunk;        //Has it been sunk?
   const uint8_t length;   //Length of the ship
   const char name[14];    //Text name of the ship
   const char wav[18];     //Name of the wave file declaring it sunk
+  mask_t mask;      //The squares it covers. Set by placeShip.
 };
 
 //Initial condition of the ships.
-//The initialization for index, hits, vertical, and sunk are to do a quick debug
+//The initialization for index, vertical, and sunk are to do a quick debug
 //test. They get overwritten if you use random or manual ship placements.
 ship_t Ships[5]= { 
-  {70,5,false, true,5,"Carrier", "carrier.wav"}, 
-  {20,4,true, true,4,"Battleship", "battleship.wav"}, 
-  {42,3,false, true,3,"Cruiser", "cruiser.wav"}, 
-  {46,3,true, true,3,"Submarine", "submarine.wav"},
-  {0,0,false, false,2, "Patrol Boat", "patrol.wav"}
+  {70,false, true,5,"Carrier", "carrier.wav", {}}, 
+  {20,true, true,4,"Battleship", "battleship.wav", {}}, 
+  {42,false, true,3,"Cruiser", "cruiser.wav", {}}, 
+  {46,true, true,3,"Submarine", "submarine.wav", {}},
+  {0,false, false,2, "Patrol Boat", "patrol.wav", {}}
   };
   
 //Which enemy ships we have destroyed
 bool EnemyShips[5];
-uint8_t EnemyHits;  //when this reaches 17 opponent wins
 //Put all the colors in one place to make it easier to tweak
 uint16_t shipColor=Device.display->color565(30, 30, 30);
 uint16_t seaColor=Device.display->color565(50, 50, 255);
 uint16_t radarColor=Device.display->color565(30,200, 0);
 uint16_t hitColor=Device.display->color565(255, 0, 0);
-//Possible contents of a grid
-//Once a ship has been hit or sunk we don't care which ship it is anymore.
-//So we don't need separate GRID_SHIP_HIT_x values for each ship.
-enum grid_t {GRID_EMPTY, GRID_MISS, GRID_HIT, GRID_SHIP_HIT, GRID_CURSOR, 
-            GRID_SHIP_0, GRID_SHIP_1, GRID_SHIP_2, GRID_SHIP_3, GRID_SHIP_4};
+//Possible contents of a grid square as drawn on the screen
+enum grid_t {GRID_EMPTY, GRID_MISS, GRID_HIT, GRID_SHIP_HIT, GRID_CURSOR, GRID_SHIP};
 //The radar board shows you your enemy's area and the sea board shows you your area
 enum board_t {SEA_BOARD, RADAR_BOARD};
 
 char message[40];   //buffer to be used with sprintf
-grid_t radar[100];  //our version of the opponent's board
-grid_t sea[100];    //The sea where our ships are located
+//The sea where our ships are located. A square fired at is a hit if it is in seaShips.
+mask_t seaShips;    //every square holding one of our ships
+mask_t seaShots;    //every square our opponent has fired at
+//Our version of the opponent's board
+mask_t radarShots;  //every square we have fired at
+mask_t radarHits;   //the ones that hit
+
+/*
+ * Returns what to draw at square "i" of a board.
+ */
+grid_t gridAt(board_t Type, cell_t i) {
+  if(Type==RADAR_BOARD) {
+    return radarHits.test(i) ? GRID_HIT : radarShots.test(i) ? GRID_MISS : GRID_EMPTY;
+  }
+  if(seaShips.test(i)) {
+    return seaShots.test(i) ? GRID_SHIP_HIT : GRID_SHIP;
+  }
+  return seaShots.test(i) ? GRID_MISS : GRID_EMPTY;
+}
+
+/*
+ * Chooses a random layout for all five ships, every legal layout equally likely. See
+ * bitBoard::randomLines. About two layouts in five are kept on a 10 x 10 grid, so a fleet takes
+ * a few dozen line() and intersects() calls.
+ *
+ * Fills in index[], vertical[] and ship[] for each of the five ships and every square holding one
+ * in "all". Returns how many layouts were tried.
+ */
+uint16_t randomFleet(cell_t* index, bool* vertical, mask_t* ship, mask_t& all) {
+  uint8_t lengths[5];
+  uint16_t start[5];
+  for(uint8_t i=0;i<5;i++) {
+    lengths[i]=Ships[i].length;
+  }
+  uint16_t tries=mask_t::randomLines(5, lengths, start, vertical, ship, all);
+  for(uint8_t i=0;i<5;i++) {
+    index[i]=start[i];
+  }
+  return tries;
+}
+
+//Hash of every shot fired and ship sunk by either player. Both devices must always agree on it.
+//Players are told apart by whether they make the odd or even numbered moves.
+zobristHash ShotHash;
+//The computer opponent keeps its own hash with the same features.
+void hashShot(uint16_t moveNum, cell_t i, bool hit, zobristHash& Hash=ShotHash) {
+  Hash.toggle((moveNum & 1)*2*GRID_CELLS + i*2 + hit);
+}
+void hashSunk(uint16_t moveNum, uint8_t ship, zobristHash& Hash=ShotHash) {
+  Hash.toggle(4*GRID_CELLS + (moveNum & 1)*5 + ship);
+}
 
 //"Center" of the board in pixels. Slightly higher than the actual center of the 
 // screen to make room for the bottom message area. Initialized in BShip_Game::setup()
 uint16_t centerX;     
 uint16_t centerY;
 
-#define SIZE_OF_SQR 12
+//Button a prompt waits for. Prompts don't wait when the computer plays.
+#define WAIT_FOR(button) (COMPUTER_PLAYS ? 0 : (button))
+
+//Pixels across a square. 12 for a 10 x 10 grid.
+#define SIZE_OF_SQR (120/((GRID_WIDTH>GRID_HEIGHT) ? GRID_WIDTH : GRID_HEIGHT))
+//Top left corner of the grid in pixels
+#define GRID_LEFT (centerX - SIZE_OF_SQR*GRID_WIDTH/2)
+#define GRID_TOP  (centerY - SIZE_OF_SQR*GRID_HEIGHT/2)
 /************************************************************************************
  * Various global functions not really part of the game engine object. Need to be able to
  * access these from a variety of locations so we made them global.
@@ -115,9 +224,9 @@ void bottomMessage(const char*text,const char*text2) {
 /*
  * Draws a circle showing hit or miss at a particular grid location
  */
-void drawGridLoc(grid_t Type, uint8_t i, uint16_t color) {
-  uint16_t sx=centerX + ((i % 10) -4.5)*SIZE_OF_SQR;
-  uint16_t sy=centerY + ((i / 10) -4.5)*SIZE_OF_SQR;
+void drawGridLoc(grid_t Type, cell_t i, uint16_t color) {
+  uint16_t sx=GRID_LEFT + mask_t::column(i)*SIZE_OF_SQR + SIZE_OF_SQR/2;
+  uint16_t sy=GRID_TOP + mask_t::row(i)*SIZE_OF_SQR + SIZE_OF_SQR/2;
   uint16_t c;
   switch(Type) {
     case GRID_EMPTY:  c=color; break;
@@ -125,7 +234,7 @@ void drawGridLoc(grid_t Type, uint8_t i, uint16_t color) {
     case GRID_SHIP_HIT:
     case GRID_HIT:    c=hitColor; break;
     case GRID_CURSOR: c=color; break;
-    default: //GRID_SHIP_0 through GRID_SHIP_4:
+    default: //GRID_SHIP
       c=shipColor; break;
   }
   Device.display->fillCircle(sx,sy,2,c);
@@ -136,14 +245,12 @@ void drawGridLoc(grid_t Type, uint8_t i, uint16_t color) {
  */
 void drawBoard(board_t Type) {
   uint16_t color;
-  grid_t* board;
   if(Type==SEA_BOARD) {
-    board=sea;
     color=seaColor;
     Device.display->fillScreen(color);
     for(uint8_t i=0;i<5;i++) {//draw ship
       uint16_t w,h;
-      if(Ships[i].index<0) {  //ship hasn't been placed yet
+      if(Ships[i].index==NOT_PLACED) {  //ship hasn't been placed yet
         continue;
       }
       if(Ships[i].vertical) {
@@ -152,49 +259,52 @@ void drawBoard(board_t Type) {
         h=SIZE_OF_SQR-3; w=Ships[i].length*SIZE_OF_SQR-3;
       }
       Device.display->fillRoundRect(
-          centerX + ((Ships[i].index % 10) -4.5)*SIZE_OF_SQR-SIZE_OF_SQR/2+2,
-          centerY + ((Ships[i].index / 10) -4.5)*SIZE_OF_SQR-SIZE_OF_SQR/2+2, 
+          GRID_LEFT + mask_t::column(Ships[i].index)*SIZE_OF_SQR+2,
+          GRID_TOP + mask_t::row(Ships[i].index)*SIZE_OF_SQR+2, 
           w,h,3,(Ships[i].sunk)?hitColor:shipColor);
     }
   } else {
-    board=radar;
     color=radarColor;
     Device.display->fillScreen(color);
   }
-  for (uint8_t i=1;i<10;i++) {
-    Device.display->drawFastVLine(centerX-SIZE_OF_SQR*5+i*SIZE_OF_SQR, centerY-SIZE_OF_SQR*5,
-                                  SIZE_OF_SQR*10, ARCADA_WHITE);
-    Device.display->drawFastHLine(centerX-SIZE_OF_SQR*5, centerY-SIZE_OF_SQR*5+i*SIZE_OF_SQR,
-                                  SIZE_OF_SQR*10, ARCADA_WHITE);
+  for (uint8_t i=1;i<GRID_WIDTH;i++) {
+    Device.display->drawFastVLine(GRID_LEFT+i*SIZE_OF_SQR, GRID_TOP, SIZE_OF_SQR*GRID_HEIGHT, ARCADA_WHITE);
   }
-  Device.display->drawRect(centerX-SIZE_OF_SQR*5,centerY-SIZE_OF_SQR*5,SIZE_OF_SQR*10+1,SIZE_OF_SQR*10+1, ARCADA_WHITE);
+  for (uint8_t i=1;i<GRID_HEIGHT;i++) {
+    Device.display->drawFastHLine(GRID_LEFT, GRID_TOP+i*SIZE_OF_SQR, SIZE_OF_SQR*GRID_WIDTH, ARCADA_WHITE);
+  }
+  Device.display->drawRect(GRID_LEFT,GRID_TOP,SIZE_OF_SQR*GRID_WIDTH+1,SIZE_OF_SQR*GRID_HEIGHT+1, ARCADA_WHITE);
   //if we see this message, it means we should have written a different message somewhere
   bottomMessage("testing 123 this is a test");
   
-  for(uint8_t i=0;i<100;i++) {
-    drawGridLoc(board[i],i,color);
+  for(cell_t i=0;i<GRID_CELLS;i++) {
+    drawGridLoc(gridAt(Type,i),i,color);
   }
 }
 
+//Code that lets the computer choose where to fire
+#include "computer_player.h"
+shipHunter Hunter;  //chooses our shots when COMPUTER_PLAYS is true
+
 /****************************************************************
  *    BShip_Move class and methods
  ****************************************************************/
 /*
  * This is our derived move object. 
  * 
- *    uint8_t shot;
+ *    cell_t shot;
  *      The board index where we fired the shot
  * 
- *    size_t my_size();
- *      This method returns the size of BShip_Move object. 
+ *    void fields(packetCodec& c);
+ *      This method lists the data we transmit. In this case it's just the shot.
  *      
  *    void decideMyMove(void);
  *      Prompts us to make our move. See details below.
  */
 class BShip_Move : public baseMove {
   public:
-    uint8_t shot;
-    size_t my_size() override { return sizeof( *this ); };
+    cell_t shot;
+    void fields(packetCodec& c) override {baseMove::fields(c); c.field(shot);};
     void decideMyMove(void)override;
 };
 
@@ -219,11 +329,19 @@ void BShip_Move::decideMyMove(void) {
   subType=NORMAL_MOVE;
   //put the cursor at the first empty grid location. Assumes there is one.
   shot=0;
-  while( (shot<100) && (radar[shot] != GRID_EMPTY) ) {
+  while( (shot<GRID_CELLS) && radarShots.test(shot) ) {
     shot++;
   }
   drawBoard(RADAR_BOARD);
-  drawGridLoc(GRID_CURSOR, shot, (radar[shot])?ARCADA_BLACK: ARCADA_YELLOW);//the cursor
+  #if(COMPUTER_PLAYS)
+    shot=Hunter.choose(radarShots, radarHits, EnemyShips);
+    radarShots.set(shot);//assume we missed until we know different
+    drawBoard(RADAR_BOARD);
+    bottomMessage("Firing!");
+    playWave("fire.wav");
+    return;
+  #endif
+  drawGridLoc(GRID_CURSOR, shot, radarShots.test(shot)?ARCADA_BLACK: ARCADA_YELLOW);//the cursor
   bottomMessage("Make your move #%d",moveNum);
   uint32_t Buttons;
   while(true) {
@@ -234,16 +352,16 @@ void BShip_Move::decideMyMove(void) {
     if (Buttons=Device.readButtons()) {//not an error
   #endif
       Device.readButtons();//flush out or de-bounce
-      drawGridLoc(radar[shot], shot, radarColor);//erase cursor from the current position
+      drawGridLoc(gridAt(RADAR_BOARD,shot), shot, radarColor);//erase cursor from the current position
       switch(Buttons){
-        case ARCADA_BUTTONMASK_UP:    shot = (shot+(100-10)) % 100; break;    
-        case ARCADA_BUTTONMASK_DOWN:  shot = (shot+10) % 100; break;    
-        case ARCADA_BUTTONMASK_LEFT:  shot = (shot+(100-1)) % 100; break;    
-        case ARCADA_BUTTONMASK_RIGHT: shot = (shot+1) % 100; break;    
+        case ARCADA_BUTTONMASK_UP:    shot = (shot+(GRID_CELLS-GRID_WIDTH)) % GRID_CELLS; break;    
+        case ARCADA_BUTTONMASK_DOWN:  shot = (shot+GRID_WIDTH) % GRID_CELLS; break;    
+        case ARCADA_BUTTONMASK_LEFT:  shot = (shot+(GRID_CELLS-1)) % GRID_CELLS; break;    
+        case ARCADA_BUTTONMASK_RIGHT: shot = (shot+1) % GRID_CELLS; break;    
         case ARCADA_BUTTONMASK_SELECT: 
           //We made our selection. 
-          if(radar[shot]== GRID_EMPTY) {
-            radar[shot]=GRID_MISS;//assume we missed until we know different
+          if(!radarShots.test(shot)) {
+            radarShots.set(shot);//assume we missed until we know different
             drawBoard(RADAR_BOARD);
             bottomMessage("Firing!");
             playWave("fire.wav");
@@ -272,7 +390,7 @@ void BShip_Move::decideMyMove(void) {
           break;
       }
       drawBoard(RADAR_BOARD);
-      drawGridLoc(GRID_CURSOR, shot, (radar[shot])?ARCADA_BLACK: ARCADA_YELLOW);//the cursor
+      drawGridLoc(GRID_CURSOR, shot, radarShots.test(shot)?ARCADA_BLACK: ARCADA_YELLOW);//the cursor
       bottomMessage("Make your move #%d",moveNum);
       myDelay(500); //Slow down the cursor
     }
@@ -289,11 +407,11 @@ void BShip_Move::decideMyMove(void) {
  *      Normally set to -1 but if we destroy a ship it tells us which ship we destroyed.
  *      Normally with a hit you don't know which ship it was until you actually destroy it.
  *      
- *    uint8_t shot;
+ *    cell_t shot;
  *      Repeating back to you the shot you just made. It makes the processResults code easier.
  *      
- *    size_t my_size();
- *      This method returns the size of the BShip_Results object.
+ *    void fields(packetCodec& c);
+ *      This method lists the data we transmit which is shipDestroyed and shot.
  *    
  *    bool processResults(void)
  *      Processes the results packet we received in response to our move. See below for details.
@@ -305,8 +423,8 @@ void BShip_Move::decideMyMove(void) {
 class BShip_Results : public baseResults {
   public:
     int8_t shipDestroyed;
-    uint8_t shot;
-    size_t my_size() override { return sizeof( *this ); };
+    cell_t shot;
+    void fields(packetCodec& c) override {baseResults::fields(c); c.field(shipDestroyed); c.field(shot);};
     bool processResults(void)override;
     bool generateResults(baseMove* Move)override;
 };
@@ -317,18 +435,23 @@ class BShip_Results : public baseResults {
 bool BShip_Results::processResults(void) {
   switch(subType) {
     case MISS_RESULTS:  
-      radar[shot]=GRID_MISS;
+      radarShots.set(shot);
+      hashShot(resultsNum, shot, false);
       drawBoard(RADAR_BOARD);
       bottomMessage("I missed");
       myDelay(4000);
       return false;
     case WIN_RESULTS:
     case HIT_RESULTS:   
-      radar[shot]=GRID_HIT;  
+      radarShots.set(shot);
+      radarHits.set(shot);
+      hashShot(resultsNum, shot, true);
       drawBoard(RADAR_BOARD);
       bottomMessage("I hit the enemy!");
       if(shipDestroyed>=0) {
         EnemyShips[shipDestroyed]= true;
+        hashSunk(resultsNum, shipDestroyed);
+        Hunter.sank(shot, shipDestroyed, radarHits);
         bottomMessage("I sank enemy %s!",Ships[shipDestroyed].name);
         Device.pixels.setPixelColor(shipDestroyed, 50,0,0);
         Device.pixels.show();
@@ -362,15 +485,19 @@ bool BShip_Results::generateResults(baseMove* M) {
   uint8_t shipHit;    //which ship they hit
   switch(Move->subType) {
     case NORMAL_MOVE:
-      if(sea[shot]>=GRID_SHIP_0) {//They hit a ship
+      if(seaShips.test(shot) && !seaShots.test(shot)) {//They hit a ship
         playWave("hit.wav");
         subType=HIT_RESULTS;
-        shipHit=sea[shot]-GRID_SHIP_0;
-        sea[shot]=GRID_HIT;
-        Ships[shipHit].hits++;
-        if(Ships[shipHit].length == Ships[shipHit].hits) {//ship sunk
+        seaShots.set(shot);
+        shipHit=0;
+        while(!Ships[shipHit].mask.test(shot)) {
+          shipHit++;
+        }
+        hashShot(resultsNum, shot, true);
+        if(seaShots.contains(Ships[shipHit].mask)) {//ship sunk
           Ships[shipHit].sunk=true;
           shipDestroyed=shipHit;    //tell opponent which one
+          hashSunk(resultsNum, shipHit);
           drawBoard(SEA_BOARD);
           bottomMessage("Enemy sank my %s", Ships[shipHit].name);
           playWave(Ships[shipHit].wav);
@@ -378,7 +505,7 @@ bool BShip_Results::generateResults(baseMove* M) {
           drawBoard(SEA_BOARD);
           bottomMessage("Enemy hit my %s", Ships[shipHit].name);
         }
-        if ((++EnemyHits)==17) {  //They win
+        if (seaShots.contains(seaShips)) {  //They win
           playWave("game_over.wav");
           subType=WIN_RESULTS;
           myDelay(3000);
@@ -387,7 +514,8 @@ bool BShip_Results::generateResults(baseMove* M) {
         }
       } else {    //They missed
         subType=MISS_RESULTS;
-        sea[shot]=GRID_MISS;
+        seaShots.set(shot);
+        hashShot(resultsNum, shot, false);
         drawBoard(SEA_BOARD);
         bottomMessage("Ha Ha They missed");
         playWave("miss.wav");
@@ -402,6 +530,11 @@ bool BShip_Results::generateResults(baseMove* M) {
   };
 }
 
+#if(SINGLE_PLAYER)
+  //The computer opponent and the radio that connects us to it
+  #include "computer_opponent.h"
+#endif
+
 /****************************************************************
  *    BShip_Game class and methods
  ****************************************************************/
@@ -411,9 +544,11 @@ bool BShip_Results::generateResults(baseMove* M) {
  * easier to make them global because some needed to be referenced inside Move and Results.
  * We have therefore added no additional data or methods beyond those we extend from baseGame.
  * 
- *    BShip_Game(BShip_Move* move_ptr, BShip_Results* results_ptr, RF69Radio* radio_ptr, bool isPlayer_1)
- *      : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) {};
- *          Standard constructor passes typecast pointers to the base constructor.
+ *    BShip_Game(BShip_Move* move_ptr, BShip_Results* results_ptr, baseRadio* radio_ptr)
+ *      : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {};
+ *          Standard constructor passes typecast pointers to the base constructor. Player numbers
+ *          are decided when the two devices find each other. The radio is an RF69Radio or, 
+ *          when SINGLE_PLAYER is true, a computerRadio.
  *          
  *    void setup(void)
  *      Runs ONCE during the setup() function of the main program. Initializes Arcada Device and
@@ -423,9 +558,9 @@ bool BShip_Results::generateResults(baseMove* M) {
  *      This method is called by the game engine at the start of each new game.
  *      
  *    bool coinFlip(void)
- *      This method called by the offering player to determine who goes first using a random number.  
- *      Prompts the user to press "A" to initiate the flip. If it returns true then the offering 
- *      player goes first. If it returns false, the accepting player goes first. The game engine
+ *      This method called by player 1 to determine who goes first using a random number.  
+ *      Prompts the user to press "A" to initiate the flip. If it returns true then player 1
+ *      goes first. If it returns false, player 2 goes first. The game engine
  *      handles everything else. We just produce a true or false outcome of the flip.
  *      
  *    void processGameOver(void);
@@ -443,12 +578,45 @@ bool BShip_Results::generateResults(baseMove* M) {
  *      This method is called to inform the outcome of the coin flip. Prints a message.
  *      
  *    void foundGame(void);
- *      This method is called on the seeking player when he finds a game. Prints a message.
+ *      This method is called on player 2 when it finds a game. Prints a message.
+ *      
+ *    void playerElected(void);
+ *      Called on both devices once they have decided which one is player 1.
+ *      
+ *    void dimDisplay(bool dim);
+ *    bool userActive(void);
+ *      Used by the game engine when LOW_POWER is on. The first turns the backlight down or back up. 
+ *      The second tells it that a button is pressed.
+ *      
+ *    void snapshot(packetCodec& c);
+ *    bool restore(packetCodec& c);
+ *      Used by the game engine to get back in step with our opponent if the two devices ever disagree
+ *      about the move number or the state of the game. See below.
+ *      
+ *    uint32_t stateHash(void);
+ *      Returns ShotHash so the game engine can check that both devices agree about every shot so far.
+ *      
+ *    void persist(packetCodec& c);
+ *    bool resume(packetCodec& c);
+ *      Used by the game engine to save the game in SaveFile after every turn and pick it up again 
+ *      after a reset without placing the ships again.
+ *      
+ *    void rebuild(uint8_t* atUs, uint8_t* byUs, uint8_t enemySunk);
+ *      Used by restore and resume to set up both boards from the shots each side has fired.
  */
 class BShip_Game : public baseGame {
   public:
-    BShip_Game(BShip_Move* move_ptr, BShip_Results* results_ptr, RF69Radio* radio_ptr, bool isPlayer_1)
-        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) {};
+    BShip_Game(BShip_Move* move_ptr, BShip_Results* results_ptr, baseRadio* radio_ptr)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {
+          piggybackResults=PIGGYBACK_RESULTS;
+          lowPower=LOW_POWER;
+          resync=SNAPSHOT_FITS && !SINGLE_PLAYER;
+          hashCheck=true;
+          Store=&SaveFile;
+          #if(KEEP_JOURNAL)
+            Journal=&GameLog;
+          #endif
+        };
     void setup(void) override;
     void initialize(void) override;
     bool coinFlip(void) override;
@@ -457,6 +625,16 @@ class BShip_Game : public baseGame {
     void loopContents(void) override;
     void processFlip(bool coin) override;
     void foundGame(void) override;
+    void playerElected(void) override;
+    void dimDisplay(bool dim) override;
+    bool userActive(void) override;
+    void snapshot(packetCodec& c) override;
+    bool restore(packetCodec& c) override;
+    void persist(packetCodec& c) override;
+    bool resume(packetCodec& c) override;
+    uint32_t stateHash(void) override {return ShotHash.value;};
+  private:
+    void rebuild(uint8_t* atUs, uint8_t* byUs, uint8_t enemySunk);
 };
 
 /*
@@ -466,8 +644,7 @@ void BShip_Game::setup(void) {
   #if(ACCESSIBLE_INPUT)
     //we use the serial monitor for alternate input
     Serial.begin(115200); while (!Serial) {myDelay(1);};
-    Serial.print("\n\n\n\nTwo Player Game Setup. You are player #");
-    Serial.println(myPlayerNum);
+    Serial.println("\n\n\n\nTwo Player Game Setup.");
   #endif
   Device.arcadaBegin();
   Device.displayBegin();
@@ -502,32 +679,27 @@ void BShip_Game::initialize(void) {
   CenterTextH("Battleship",90);
   myDelay(2000);
   Device.display->setFont();
-  uint8_t i,j;
-  for(i=0;i<100;i++){
-    sea[i]=GRID_EMPTY;
-    radar[i]=GRID_EMPTY;
-  }
+  seaShips.clear();
+  seaShots.clear();
+  radarShots.clear();
+  radarHits.clear();
+  Hunter.reset();
   Device.display->fillScreen(ARCADA_GREEN);
+  #if (SELF_TEST)
+    Serial.println("no hits and no sink on ship 4");
+    Ships[4].sunk=false;
+  #endif
   placeShips(); //See board_setup.h
-  for(i=0;i<5;i++) {
+  for(uint8_t i=0;i<5;i++) {
     Device.pixels.setPixelColor (i,0,50,0);
     EnemyShips[i]= false;
-    //loops through the length of the ship and posts it on the board
-    for(j=0;j<Ships[i].length;j++) {  
-      sea[Ships[i].index + j*((Ships[i].vertical)?10:1)] =
-          (Ships[i].sunk) ? GRID_HIT :(grid_t)((uint8_t)GRID_SHIP_0+i);
+    placeShip(i);
+    if(Ships[i].sunk) {   //only in the fixed debug pattern
+      seaShots |= Ships[i].mask;
     }
   }
   Device.pixels.show();
-
-  #if (SELF_TEST)
-    Serial.println("kits = 15, no hits and no sink on ship 4");
-    EnemyHits=15; 
-    Ships[4].hits=0;
-    Ships[4].sunk=false;
-  #else
-    EnemyHits=0;
-  #endif
+  ShotHash.reset();
 };
 
 /*
@@ -536,7 +708,7 @@ void BShip_Game::initialize(void) {
 bool BShip_Game::coinFlip(void) {
   drawBoard(SEA_BOARD);
   bottomMessage("Flipping coin.");
-  Device.infoBox ("Offer accepted!\nFlip the coin to see who goes first.");
+  Device.infoBox ("Found a game!\nFlip the coin to see who goes first.", WAIT_FOR(ARCADA_BUTTONMASK_A));
   playWave("lets_play.wav");
   Device.display->fillScreen(ARCADA_GREEN);
   #if (SELF_TEST)
@@ -558,7 +730,7 @@ bool BShip_Game::coinFlip(void) {
  */
 void BShip_Game::processGameOver(void) {
   myDelay(5000);
-  Device.infoBox("Press 'Start' to restart.", ARCADA_BUTTONMASK_START);
+  Device.infoBox("Press 'Start' to restart.", WAIT_FOR(ARCADA_BUTTONMASK_START));
   initialize();
 };
 /*
@@ -580,8 +752,8 @@ void BShip_Game::loopContents(void) {
   switch(gameState) {
     case OFFERING_GAME: 
       drawBoard(SEA_BOARD);
-      bottomMessage("Offering a game.");
-      Device.alertBox ("Offering a game.", ARCADA_WHITE, ARCADA_BLACK,0);
+      bottomMessage("Looking for a game.");
+      Device.alertBox ("Looking for a game.", ARCADA_WHITE, ARCADA_BLACK,0);
       playWave("shall_we.wav");
       break;
     case SEEKING_GAME:
@@ -632,3 +804,184 @@ void BShip_Game::foundGame(void) {
   drawBoard(SEA_BOARD);
   Device.infoBox("Found a game. Waiting on the coin toss.",0);
 }
+void BShip_Game::playerElected(void) {
+  #if(ACCESSIBLE_INPUT)
+    Serial.print("Found a game. You are player #");
+    Serial.println(myPlayerNum);
+  #endif
+}
+
+void BShip_Game::dimDisplay(bool dim) {
+  Device.setBacklight(dim ? DIM_BACKLIGHT : 255);
+}
+
+bool BShip_Game::userActive(void) {
+  return Device.readButtons() != 0;
+}
+
+/*
+ * Shots are packed four to a byte in a snapshot, two bits each: SHOT_NONE, SHOT_MISS, or SHOT_HIT.
+ * That fits both boards of a 10 x 10 grid in 50 bytes.
+ */
+enum shot_t {SHOT_NONE, SHOT_MISS, SHOT_HIT};
+shot_t boardShot(mask_t& shots, mask_t& hits, cell_t i) {
+  return hits.test(i) ? SHOT_HIT : shots.test(i) ? SHOT_MISS : SHOT_NONE;
+}
+shot_t getShot(uint8_t* shots, cell_t i) {
+  return (shot_t)((shots[i/4] >> (2*(i%4))) & 3);
+}
+
+/*
+ * Packs the shots we have fired from the radar board into "fired" and the shots fired at us on 
+ * the sea board into "received". Radar square "leaveOut" is left out unless it is NOT_PLACED.
+ */
+void packShots(uint8_t* fired, uint8_t* received, cell_t leaveOut) {
+  mask_t seaHits=seaShots;
+  seaHits &= seaShips;
+  memset(fired,0,SHOT_BYTES);
+  memset(received,0,SHOT_BYTES);
+  for(cell_t i=0;i<GRID_CELLS;i++) {
+    if(i!=leaveOut) {
+      fired[i/4] |= boardShot(radarShots,radarHits,i) << (2*(i%4));
+    }
+    received[i/4] |= boardShot(seaShots,seaHits,i) << (2*(i%4));
+  }
+}
+
+/*
+ * Our snapshot is every shot we have fired from the radar board, every shot fired at us from 
+ * the sea board, and which of our ships are sunk. If we are waiting on the results of a shot it 
+ * is left out because the game engine will fire it again.
+ */
+void BShip_Game::snapshot(packetCodec& c) {
+  uint8_t fired[SHOT_BYTES], received[SHOT_BYTES], sunk=0;
+  bool waiting= movePending() && (Move->subType==NORMAL_MOVE);
+  packShots(fired, received, waiting ? ((BShip_Move*)Move)->shot : NOT_PLACED);
+  for(uint8_t i=0;i<5;i++) {
+    if(Ships[i].sunk) {
+      sunk |= 1<<i;
+    }
+  }
+  c.field(fired); c.field(received); c.field(sunk);
+}
+
+/*
+ * Our opponent's snapshot is the game seen from their side. The shots they fired landed on our sea 
+ * and the shots they received are ours, so their sea becomes our radar. Their sunk ships are the 
+ * enemy ships we sank.
+ */
+bool BShip_Game::restore(packetCodec& c) {
+  uint8_t fired[SHOT_BYTES], received[SHOT_BYTES], sunk=0;
+  c.field(fired); c.field(received); c.field(sunk);
+  if(!c.ok) {
+    return false;
+  }
+  rebuild(fired, received, sunk);
+  bottomMessage("Back in step with opponent.");
+  return true;
+}
+
+/*
+ * What we save after every turn is where our ships are, the shots on both boards, and which enemy
+ * ships we have sunk. It is 61 bytes for a 10 x 10 grid.
+ */
+void BShip_Game::persist(packetCodec& c) {
+  uint8_t fired[SHOT_BYTES], received[SHOT_BYTES], sunk=0;
+  packShots(fired, received, NOT_PLACED);
+  for(uint8_t i=0;i<5;i++) {
+    c.field(Ships[i].index); c.field(Ships[i].vertical);
+    if(EnemyShips[i]) {
+      sunk |= 1<<i;
+    }
+  }
+  c.field(fired); c.field(received); c.field(sunk);
+}
+
+/*
+ * Picks the game up after a reset. The ships must fit on the board or we would draw them
+ * all over memory.
+ */
+bool BShip_Game::resume(packetCodec& c) {
+  cell_t index[5];
+  bool vertical[5];
+  uint8_t fired[SHOT_BYTES], received[SHOT_BYTES], sunk=0;
+  uint8_t i;
+  for(i=0;i<5;i++) {
+    c.field(index[i]); c.field(vertical[i]);
+  }
+  c.field(fired); c.field(received); c.field(sunk);
+  if(!c.ok) {
+    return false;
+  }
+  mask_t fits;
+  for(i=0;i<5;i++) {
+    if(!fits.line(index[i], Ships[i].length, vertical[i])) {
+      return false;
+    }
+  }
+  for(i=0;i<5;i++) {
+    Ships[i].index=index[i];
+    Ships[i].vertical=vertical[i];
+  }
+  rebuild(received, fired, sunk);
+  bottomMessage("Resumed the saved game.");
+  return true;
+}
+
+/*
+ * Sets both boards from packed shots. We put our ships back and fire every shot in "atUs" at them
+ * again to rebuild our hits. The shots in "byUs" go on our radar and "enemySunk" has a bit for each 
+ * enemy ship we have sunk. Then we work out ShotHash from scratch. By now the game engine has set 
+ * whose turn it is.
+ */
+void BShip_Game::rebuild(uint8_t* atUs, uint8_t* byUs, uint8_t enemySunk) {
+  uint8_t i;
+  cell_t j;
+  seaShips.clear();
+  seaShots.clear();
+  radarShots.clear();
+  radarHits.clear();
+  Hunter.reset();
+  for(i=0;i<5;i++) {
+    placeShip(i);
+  }
+  for(j=0;j<GRID_CELLS;j++) {
+    if(getShot(atUs,j)!=SHOT_NONE) {
+      seaShots.set(j);
+    }
+    switch(getShot(byUs,j)) {
+      case SHOT_HIT:  radarHits.set(j);   //and fall through
+      case SHOT_MISS: radarShots.set(j);  break;
+      default: break;
+    }
+  }
+  for(i=0;i<5;i++) {
+    Ships[i].sunk= seaShots.contains(Ships[i].mask);
+    EnemyShips[i]= (enemySunk >> i) & 1;
+    if(EnemyShips[i]) {
+      Device.pixels.setPixelColor(i, 50,0,0);
+    } else {
+      Device.pixels.setPixelColor(i, 0,50,0);
+    }
+  }
+  Device.pixels.show();
+  uint16_t mine= (gameState==MY_TURN) ? currentMoveNum : currentMoveNum+1;  //a move number of ours
+  ShotHash.reset();
+  for(j=0;j<GRID_CELLS;j++) {
+    if(radarShots.test(j)) {
+      hashShot(mine, j, radarHits.test(j));
+    }
+    if(seaShots.test(j)) {
+      hashShot(mine+1, j, seaShips.test(j));
+    }
+  }
+  for(i=0;i<5;i++) {
+    if(EnemyShips[i]) {
+      hashSunk(mine, i);
+    }
+    if(Ships[i].sunk) {
+      hashSunk(mine+1, i);
+    }
+  }
+  drawBoard(SEA_BOARD);
+}
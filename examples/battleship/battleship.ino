@@ -9,15 +9,13 @@
  * for more information about this project.
  **********************************************************/
 /*
- * Compile and upload to one device using IS_PLAYER_1 true and compile and upload
- * to the other device using IS_PLAYER_1 false. This is the only difference between 
- * the code on the two different machines.
+ * Compile and upload exactly the same code to both devices. When they find each
+ * other they decide between themselves which one is player 1.
  */
 /*
  * Two player Battleship game with audio sound effects. Load the wav files onto
  * an SD card on each machine in a folder called "/wav"
  */
-#define IS_PLAYER_1 true
 //Basic game engine code
 #include <TwoPlayerGame.h>
 
@@ -30,11 +28,16 @@
 /*
    The Game object requires pointers to Move, Results, and Radio objects. Create
    an instance of each of these and pass their address to the game constructor.
+   When playing against the computer the radio is the connection to the computer instead.
 */
-RF69Radio Radio;
+#if(SINGLE_PLAYER)
+  computerRadio Radio;
+#else
+  RF69Radio Radio;
+#endif
 BShip_Move Move;
 BShip_Results Results;
-BShip_Game Game(&Move, &Results, &Radio, IS_PLAYER_1);
+BShip_Game Game(&Move, &Results, &Radio);
 
 
 void setup() {
@@ -15,40 +15,22 @@
 
 /*
  * Tests to see if Ships[i] is in a legal position not off the edge or bottom of the board
- * and not overlapping another ship. Returns true if there is a conflict.
+ * and not overlapping another ship. Returns true if there is a conflict. Only the ships
+ * already placed are in seaShips so that is all we need to compare with.
  */
 bool testLoc(uint8_t i) {
-  uint8_t j,k;
-  if(Ships[i].vertical) { 
-    if( (Ships[i].index + 10*(Ships[i].length-1)) > 100) {//off the bottom of the board
-      return true;
-    }
-  } else {  //see if horizontal ship goes off the right edge
-    //Test if the row number of the index is different from the row number of index + length
-    if( (Ships[i].index/10) < ((Ships[i].index+Ships[i].length-1)/10) ){
-      return true;    //there was a conflict so we keep looking
-    }
-  }
-  for(j=0;j<i;j++) {  //See if it conflicts with another ship.
-    if(i!=j) {    //Don't compare with yourself
-      for(k=0;k<Ships[i].length;k++) { //Iterate the length of Ships[i]
-        uint8_t Testing = Ships[i].index + ((Ships[i].vertical)?k*10:k);
-        if(sea[Testing] != GRID_EMPTY) { //Conflict with another ship
-          return true;  //there was a conflict so we keep looking
-        }
-      }
-    }
+  mask_t m;
+  if(!m.line(Ships[i].index, Ships[i].length, Ships[i].vertical)) {
+    return true;    //off the edge of the board
   }
-  return false; //no conflict found
+  return m.intersects(seaShips);
 }
 /*
  * Once we have determined a ship is in a legal position, we place it on the board.
  */
 void placeShip(uint8_t i) {
-  //our chosen location was okay so we fill in the grid.
-  for(uint8_t j=0;j<Ships[i].length;j++) { //Iterate the length of Ships[i]
-    sea[ Ships[i].index + ((Ships[i].vertical)?j*10:j) ]= (grid_t) (((int) GRID_SHIP_0)+i);
-  }
+  Ships[i].mask.line(Ships[i].index, Ships[i].length, Ships[i].vertical);
+  seaShips |= Ships[i].mask;
 }
 
 //menu for choosing the type of ship placement
@@ -64,28 +46,35 @@ void placeShips(void) {
   #if(SELF_TEST)
 //    return;
   #endif
-  choice=Device.menu(selection,3,ARCADA_WHITE, ARCADA_BLACK);
+  #if(COMPUTER_PLAYS)
+    choice=0;
+  #else
+    choice=Device.menu(selection,3,ARCADA_WHITE, ARCADA_BLACK);
+  #endif
   Device.display->fillScreen(ARCADA_GREEN);
   if(choice<2) {
     for(i=0;i<5;i++) {  //Erase the default debug locations
-      Ships[i].index=-1;  //indicates not placed
+      Ships[i].index=NOT_PLACED;
       Ships[i].vertical= Ships[i].sunk=false;
-      Ships[i].hits=0;
     }
   }
   switch(choice) {
     case 0:   //automatic random placement
-      for(i=0;i<5;i++) {
-        Looking=true;
-        while(Looking) {
-          Ships[i].vertical=random(2);  //random number less than two i.e. 0 or 1.
-          Ships[i].index=random(100); 
-          drawBoard(SEA_BOARD);
-          bottomMessage("Placing %s",Ships[i].name);
-          Looking=testLoc(i);
-          myDelay(1000);    //Makes for interesting animation
+      {
+        cell_t index[5];
+        bool vertical[5];
+        mask_t ship[5], all;
+        randomFleet(index, vertical, ship, all);
+        for(i=0;i<5;i++) {
+          Ships[i].index=index[i];
+          Ships[i].vertical=vertical[i];
+          placeShip(i);
+          #if(ANIMATE_PLACEMENT)
+            drawBoard(SEA_BOARD);   //Show them arriving one at a time
+            bottomMessage("Placing %s",Ships[i].name);
+            myDelay(1000);
+          #endif
         }
-        placeShip(i); //chosen location was okay
       }
       break;
     case 1:
@@ -93,7 +82,7 @@ void placeShips(void) {
       for(i=0;i<5;i++) { 
         //put the cursor at the first empty grid location. 
         Ships[i].index=0;
-        while( (Ships[i].index<100) && (sea[Ships[i].index] != GRID_EMPTY) ) {
+        while( (Ships[i].index<GRID_CELLS) && seaShips.test(Ships[i].index) ) {
           Ships[i].index++;
         }
         drawBoard(SEA_BOARD);
@@ -103,12 +92,12 @@ void placeShips(void) {
         while(Looking) {
           if (Buttons=Device.readButtons()) {//not an error
             Device.readButtons();//flush out or de-bounce
-            drawGridLoc(radar[Ships[i].index], Ships[i].index, shipColor);//erase cursor from the current position
+            drawGridLoc(gridAt(SEA_BOARD,Ships[i].index), Ships[i].index, seaColor);//erase cursor from the current position
             switch(Buttons) {
-              case ARCADA_BUTTONMASK_UP:    Ships[i].index = (Ships[i].index+(100-10)) % 100; break;    
-              case ARCADA_BUTTONMASK_DOWN:  Ships[i].index = (Ships[i].index+10) % 100; break;    
-              case ARCADA_BUTTONMASK_LEFT:  Ships[i].index = (Ships[i].index+(100-1)) % 100; break;    
-              case ARCADA_BUTTONMASK_RIGHT: Ships[i].index = (Ships[i].index+1) % 100; break;    
+              case ARCADA_BUTTONMASK_UP:    Ships[i].index = (Ships[i].index+(GRID_CELLS-GRID_WIDTH)) % GRID_CELLS; break;    
+              case ARCADA_BUTTONMASK_DOWN:  Ships[i].index = (Ships[i].index+GRID_WIDTH) % GRID_CELLS; break;    
+              case ARCADA_BUTTONMASK_LEFT:  Ships[i].index = (Ships[i].index+(GRID_CELLS-1)) % GRID_CELLS; break;    
+              case ARCADA_BUTTONMASK_RIGHT: Ships[i].index = (Ships[i].index+1) % GRID_CELLS; break;    
               case ARCADA_BUTTONMASK_SELECT: 
                 //We made our selection. 
                 if(Looking=testLoc(i)) { //not a mistake
@@ -137,12 +126,12 @@ void placeShips(void) {
       break;
     case 2:
       #if(SELF_TEST)  
-        Serial.println("resetting index 1 and 2");
-        sea[0]=GRID_SHIP_4;
-        sea[1]=GRID_SHIP_4;
-        for(uint8_t i=0;i<100;i++) {
-          Serial.printf(" %d", sea[i]);
-          if((i % 10)==9) Serial.println();
+        for(i=0;i<5;i++) {
+          placeShip(i);
+        }
+        for(cell_t k=0;k<GRID_CELLS;k++) {
+          Serial.printf(" %d", seaShips.test(k));
+          if((k % GRID_WIDTH)==GRID_WIDTH-1) Serial.println();
         }
       #endif
       return;
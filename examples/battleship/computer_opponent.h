@@ -0,0 +1,191 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This file contains a computer opponent for playing Battleship on a single device. It is used when
+ * SINGLE_PLAYER is true.
+ *
+ * The computer is a complete second game object, "Computer", with a move and results of its own.
+ * It talks to your game through a pair of LoopbackRadio objects sharing "ComputerLink" exactly as
+ * a second PyGamer would over the air, so the game engine can't tell the difference. Your game's
+ * radio is a computerRadio. Whenever your game engine checks it for something to receive, it gives
+ * the Computer one step first. The Computer never waits on anything so it answers straight away.
+ *
+ * The Computer has no display or sounds. It places its ships at random, fires where shipHunter
+ * tells it to, and keeps its own boards and hash. See "computer_player.h".
+ */
+#include <TwoPlayerGame_loopback.h>
+
+/*
+ * The computer's side of the game. The same things we keep for ourselves in global variables.
+ *
+ *    mask_t ships, shots, ship[5];
+ *      Its sea. Every square holding one of its ships, every square we have fired at, and the
+ *      squares of each ship.
+ *
+ *    mask_t radarShots, radarHits;
+ *      Its radar. Every square it has fired at and the ones that hit.
+ *
+ *    bool enemySunk[5];
+ *      Which of our ships it has sunk.
+ *
+ *    zobristHash hash;
+ *    shipHunter hunter;
+ *      Its version of ShotHash and what it uses to choose its shots.
+ *
+ *    void reset(void);
+ *      Clears everything and places the ships at random for a new game.
+ */
+class computerSide {
+  public:
+    mask_t ships, shots, ship[5];
+    mask_t radarShots, radarHits;
+    bool enemySunk[5];
+    zobristHash hash;
+    shipHunter hunter;
+    void reset(void);
+};
+
+void computerSide::reset(void) {
+  ships.clear(); shots.clear();
+  radarShots.clear(); radarHits.clear();
+  hash.reset();
+  hunter.reset();
+  cell_t index[5];
+  bool vertical[5];
+  randomFleet(index, vertical, ship, ships);
+  for(uint8_t i=0;i<5;i++) {
+    enemySunk[i]=false;
+  }
+}
+computerSide CPU;
+
+/*
+ * The computer's move. The packet is the same as ours so we just choose the shot differently.
+ */
+class computerMove : public BShip_Move {
+  public:
+    void decideMyMove(void) override {
+      subType=NORMAL_MOVE;
+      shot=CPU.hunter.choose(CPU.radarShots, CPU.radarHits, CPU.enemySunk);
+      CPU.radarShots.set(shot);
+    };
+};
+
+/*
+ * The computer's results. Same packet as ours but kept on the computer's boards. Nothing is drawn.
+ */
+class computerResults : public BShip_Results {
+  public:
+    bool processResults(void)override;
+    bool generateResults(baseMove* Move)override;
+};
+
+bool computerResults::processResults(void) {
+  switch(subType) {
+    case MISS_RESULTS:
+      hashShot(resultsNum, shot, false, CPU.hash);
+      return false;
+    case WIN_RESULTS:
+    case HIT_RESULTS:
+      CPU.radarHits.set(shot);
+      hashShot(resultsNum, shot, true, CPU.hash);
+      if(shipDestroyed>=0) {
+        CPU.enemySunk[shipDestroyed]=true;
+        hashSunk(resultsNum, shipDestroyed, CPU.hash);
+        CPU.hunter.sank(shot, shipDestroyed, CPU.radarHits);
+      }
+      return subType==WIN_RESULTS;
+    default:    //LOSE_RESULTS. The computer never quits.
+      return true;
+  }
+}
+
+bool computerResults::generateResults(baseMove* M) {
+  BShip_Move* Move = (BShip_Move*)M;
+  resultsNum = Move->moveNum;
+  shot=Move->shot;
+  shipDestroyed=-1;
+  if(Move->subType==QUIT_MOVE) {
+    subType=LOSE_RESULTS;
+    return true;
+  }
+  if(CPU.ships.test(shot) && !CPU.shots.test(shot)) {
+    subType=HIT_RESULTS;
+    CPU.shots.set(shot);
+    hashShot(resultsNum, shot, true, CPU.hash);
+    for(uint8_t i=0;i<5;i++) {
+      if(CPU.ship[i].test(shot) && CPU.shots.contains(CPU.ship[i])) {
+        shipDestroyed=i;
+        hashSunk(resultsNum, i, CPU.hash);
+      }
+    }
+    if(CPU.shots.contains(CPU.ships)) {
+      subType=WIN_RESULTS;
+      return true;
+    }
+  } else {
+    subType=MISS_RESULTS;
+    CPU.shots.set(shot);
+    hashShot(resultsNum, shot, false, CPU.hash);
+  }
+  return false;
+}
+
+/*
+ * The computer's game object. Players are decided by discovery just as between two devices and
+ * it starts a new game as soon as one is over. It has nothing to resync or save.
+ */
+class computerGame : public baseGame {
+  public:
+    computerGame(computerMove* move_ptr, computerResults* results_ptr, baseRadio* radio_ptr)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {
+          piggybackResults=PIGGYBACK_RESULTS;
+          hashCheck=true;
+        };
+    void initialize(void) override {baseGame::initialize(); CPU.reset();};
+    bool coinFlip(void) override {return random(2);};
+    void processGameOver(void) override {initialize();};
+    void fatalError(const char* s) override {
+      Serial.printf("Computer fatal error '%s'\n",s);
+      gameState= GAME_OVER;
+    };
+    uint32_t stateHash(void) override {return CPU.hash.value;};
+};
+
+loopbackLink ComputerLink;
+LoopbackRadio ComputerRadio(&ComputerLink);
+computerMove ComputerMove;
+computerResults ComputerResults;
+computerGame Computer(&ComputerMove, &ComputerResults, &ComputerRadio);
+
+/*
+ * Your game's radio when you play against the computer. Sets the Computer up along with itself
+ * and lets it take a step each time your game engine looks for something to receive.
+ */
+class computerRadio : public LoopbackRadio {
+  public:
+    computerRadio(void) : LoopbackRadio(&ComputerLink) {};
+    bool setup(uint8_t myD,uint8_t otherD) {
+      Computer.setup();
+      return LoopbackRadio::setup(myD,otherD);
+    };
+    bool available(void) {
+      Computer.step();
+      return LoopbackRadio::available();
+    };
+    bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout) {
+      uint32_t StartTime=millis();
+      while(!available() && ((millis()-StartTime) < timeout)) {
+        yield();
+      }
+      return LoopbackRadio::recvTimeout(packet_ptr,len_ptr,0);
+    };
+};
@@ -0,0 +1,137 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This file contains the code that lets the computer choose where to fire. It is used for your
+ * shots when COMPUTER_PLAYS is true and always by the computer opponent in "computer_opponent.h".
+ */
+
+//A ship placement covering a hit we can't yet explain counts this many times more for each
+//such hit it covers. Counting more than four of them could overflow the density map.
+#define TARGET_WEIGHT 16
+#define TARGET_MAX_HITS 4
+
+/*
+ * Chooses shots by probability density. Every way the ships we haven't sunk yet could lie on the
+ * opponent's board is tried: each ship, each square, both directions. A placement is possible if
+ * it is on the board and misses every square we missed and every square of a ship we already sank.
+ * Each possible placement adds one to every square it covers that we haven't fired at and we fire
+ * at the square with the most. Ties are broken at random. Near the middle of the board more
+ * placements fit so that is where we start looking.
+ *
+ * Once we have hits that no sunk ship explains we are in target mode. Placements through those hits
+ * are far more likely than any other so they are weighted by TARGET_WEIGHT for each one they cover
+ * and the density map ends up pointing at the squares around the hits, along the line of them once
+ * there are two.
+ *
+ * When a ship sinks we only learn which ship it was, not which of our hits were part of it. It must
+ * be a line of hits through the square that sank it and if only one such line fits we know its
+ * squares and can stop chasing them. Otherwise they stay unexplained, which costs a few extra shots.
+ *
+ * Each placement test is a line() and an intersects() on the masks so a decision on a 10 x 10 grid
+ * takes about a thousand of them, well under a millisecond on a SAMD51.
+ *
+ *    mask_t resolved;
+ *      Hits we know belong to a ship that has been sunk.
+ *
+ *    void reset(void);
+ *      Forgets "resolved". Call it at the start of each game or whenever the boards are rebuilt.
+ *
+ *    cell_t choose(mask_t& shots, mask_t& hits, bool* sunk);
+ *      Returns the square to fire at next. "shots" is every square we have fired at, "hits" the ones
+ *      that hit and "sunk" which of the opponent's five ships we have sunk. There MUST be a square
+ *      left that we haven't fired at.
+ *
+ *    void sank(cell_t shot, uint8_t ship, mask_t& hits);
+ *      Call when the shot at "shot" sinks Ships[ship]. Works out its squares if it can.
+ *
+ *    uint32_t density[GRID_CELLS];
+ *      Internal. How many placements cover each square, weighted as described above.
+ */
+class shipHunter {
+  public:
+    mask_t resolved;
+    void reset(void) {resolved.clear();};
+    cell_t choose(mask_t& shots, mask_t& hits, bool* sunk);
+    void sank(cell_t shot, uint8_t ship, mask_t& hits);
+  private:
+    uint32_t density[GRID_CELLS];
+};
+
+cell_t shipHunter::choose(mask_t& shots, mask_t& hits, bool* sunk) {
+  mask_t blocked=shots;    //misses and the squares of sunk ships
+  blocked.remove(hits);
+  blocked |= resolved;
+  mask_t open=hits;        //unexplained hits
+  open.remove(resolved);
+  bool target=open.any();
+  memset(density,0,sizeof(density));
+  for(uint8_t s=0;s<5;s++) {
+    if(sunk[s]) {
+      continue;
+    }
+    uint8_t length=Ships[s].length;
+    for(uint8_t v=0;v<2;v++) {
+      for(cell_t start=0;start<GRID_CELLS;start++) {
+        mask_t m;
+        if(!m.line(start,length,v) || m.intersects(blocked)) {
+          continue;
+        }
+        uint32_t weight=1;
+        if(target) {
+          m &= open;
+          uint8_t k=m.count();
+          if(k>TARGET_MAX_HITS) {
+            k=TARGET_MAX_HITS;
+          }
+          while(k--) {
+            weight*=TARGET_WEIGHT;
+          }
+        }
+        for(uint8_t k=0;k<length;k++) {
+          density[start + (v ? k*GRID_WIDTH : k)] += weight;
+        }
+      }
+    }
+  }
+  cell_t best=0;
+  uint32_t most=0;
+  uint16_t ties=0;
+  for(cell_t i=0;i<GRID_CELLS;i++) {
+    if(shots.test(i)) {
+      continue;
+    }
+    if((density[i]>most) || (ties==0)) {
+      best=i; most=density[i]; ties=1;
+    } else if((density[i]==most) && (random(++ties)==0)) {
+      best=i;
+    }
+  }
+  return best;
+}
+
+void shipHunter::sank(cell_t shot, uint8_t ship, mask_t& hits) {
+  uint8_t length=Ships[ship].length;
+  mask_t found, m;
+  uint8_t fits=0;
+  for(uint8_t v=0;v<2;v++) {
+    uint8_t step= v ? GRID_WIDTH : 1;
+    uint8_t along= v ? mask_t::row(shot) : mask_t::column(shot);
+    for(uint8_t back=0; (back<length) && (back<=along); back++) {
+      if(m.line(shot-back*step, length, v) && hits.contains(m) && !m.intersects(resolved)) {
+        found=m;
+        fits++;
+      }
+    }
+  }
+  if(fits==1) {
+    resolved |= found;
+  }
+}
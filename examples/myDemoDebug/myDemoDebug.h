@@ -36,9 +36,9 @@ void screenMessage(const char* s,uint32_t v) {
  * This is our derived move object. Just so that we have something to transmit, we've defined 
  * an array of four integers "int16_t Data[4] so we can pass some information with our move.
  * 
- *    size_t my_size();
- *      This method returns the size of our actual instantiated Move object. It MUST be 
- *      defined exactly as shown in order to work properly with the base classes.
+ *    void fields(packetCodec& c);
+ *      This method lists the data we want to transmit with our move. It MUST call
+ *      baseMove::fields(c) first so that the base class can transmit the move number.
  *      
  *    void decideMyMove(void);
  *      Normally a game would use joysticks, buttons, touchscreen or touchpad inputs
@@ -55,7 +55,7 @@ class myDemoMove : public baseMove {
     int16_t Data[4];
     //Note the use of the "override" identifier which ensures
     //that your method is properly defined to override the base method.
-    size_t my_size() override { return sizeof( *this ); };
+    void fields(packetCodec& c) override {baseMove::fields(c); c.field(Data);};
     void decideMyMove(void)override;
     #if(TPG_DEBUG)
       void print(void)override;
@@ -138,9 +138,9 @@ void myDemoMove::decideMyMove(void) {
  * For demonstration purposes we have defined a single integer "Data" that is our result along with
  * the result type.
  * 
- *    size_t my_size();
- *      This method returns the size of our actual instantiated Results object. It MUST be 
- *      defined exactly as shown in order to work properly with the base classes.
+ *    void fields(packetCodec& c);
+ *      This method lists the data we want to transmit with our results. It MUST call
+ *      baseResults::fields(c) first so that the base class can transmit the results number.
  *    
  *    bool processResults(void)
  *      This method is called so that we can look at and deal with the Results packet received after
@@ -168,7 +168,7 @@ void myDemoMove::decideMyMove(void) {
 class myDemoResults : public baseResults {
   public:
     int16_t Data;
-    size_t my_size() override { return sizeof( *this ); };
+    void fields(packetCodec& c) override {baseResults::fields(c); c.field(Data);};
     bool processResults(void)override;
     bool generateResults(baseMove* Move)override;
     #if(TPG_DEBUG)
@@ -255,11 +255,11 @@ bool myDemoResults::generateResults(baseMove* M) {
  * data and methods. We will create a single instance of this new class and pass it pointers to
  * a move object, a results object, and a radio object. See "TwoPlayerGame_base_game.h" for details.
  * 
- *    myDemoGame(myDemoMove* move_ptr, myDemoResults* results_ptr, RF69Radio* radio_ptr, bool isPlayer_1)
- *      : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) {};
+ *    myDemoGame(myDemoMove* move_ptr, myDemoResults* results_ptr, RF69Radio* radio_ptr)
+ *      : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr) {};
  *          Constructor. Basically just does a typecast from our Move, Results, and Radio objects
  *          into their base versions and passes them on to the base constructor. See baseGame for
- *          details about these parameters as well as the "isPlayer_1" flag.
+ *          details about these parameters and about the optional "isPlayer_1" flag.
  *          
  *    void setup(void)
  *      This method is called by the game engine ONCE during the setup() function of your main program.
@@ -269,9 +269,9 @@ bool myDemoResults::generateResults(baseMove* M) {
  *      This method is called by the game engine at the start of each new game.
  *      
  *    bool coinFlip(void)
- *      This method is called by the offering player to determine who goes first.  If it returns true
- *      then the offering player goes first. If it returns false then the accepting player
- *      goes first. The outcome of the flip is sent to the accepting player via a COIN_FLIP_PACKET.
+ *      This method is called by player 1 to determine who goes first.  If it returns true
+ *      then player 1 goes first. If it returns false then player 2 goes first.
+ *      The outcome of the flip is sent to player 2 via a COIN_FLIP_PACKET.
  *      We implemented it as a random coin toss. You could implement some other method.
  *      
  *    void processGameOver(void);
@@ -287,13 +287,16 @@ bool myDemoResults::generateResults(baseMove* M) {
  *      which is the heart of the game state engine.
  *      
  *    void processFlip(bool coin){};
- *      Used by the accepting player to process an incoming COIN_FLIP_PACKET. Base method does nothing.
+ *      Used by player 2 to process an incoming COIN_FLIP_PACKET. Base method does nothing.
  *      We use it to print a message giving the outcome of the flip.
+ *      
+ *    void playerElected(void);
+ *      Called on both devices once they have decided which one is player 1. We print the number.
  */
 class myDemoGame : public baseGame {
   public:
-    myDemoGame(myDemoMove* move_ptr, myDemoResults* results_ptr, RF69Radio* radio_ptr, bool isPlayer_1)
-        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) {};
+    myDemoGame(myDemoMove* move_ptr, myDemoResults* results_ptr, RF69Radio* radio_ptr)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr) {};
     void setup(void) override;
     void initialize(void) override {randomSeed(millis());};
     bool coinFlip(void) override;
@@ -302,6 +305,7 @@ class myDemoGame : public baseGame {
     void loopContents(void) override;
     void processFlip(bool coin) override;
     void foundGame(void) override;
+    void playerElected(void) override;
 };
 
 /*
@@ -312,8 +316,7 @@ void myDemoGame::setup(void) {
   #if (!TPG_DEBUG)
     Serial.begin(115200); while(!Serial) {delay(1);};
   #endif
-  Serial.print("\n\n\n\nTwo Player Game Setup. You are player #");
-  Serial.println(myPlayerNum);
+  Serial.println("\n\n\n\nTwo Player Game Setup.");
   baseGame::setup();  //MUST call this 
 }
 
@@ -321,7 +324,7 @@ void myDemoGame::setup(void) {
  * Random coin flip
  */
 bool myDemoGame::coinFlip(void) {
-  screenMessage("Offer accepted. Flipping a coin.");
+  screenMessage("Found a game. Flipping a coin.");
   bool coin=random(2);//a random integer less than 2 i.e. zero or one
   if(coin) {
     screenMessage("I won the toss!");
@@ -351,7 +354,7 @@ void myDemoGame::fatalError(const char* s) {
 
 void myDemoGame::loopContents(void) {
   switch(gameState) {
-    case OFFERING_GAME:  screenMessage("Offering a game.");           break;
+    case OFFERING_GAME:  screenMessage("Looking for a game.");        break;
     case SEEKING_GAME:   screenMessage("No reply. Seeking a game.");  break;
     case MY_TURN:        screenMessage("It's my turn.");              break;
     case OPPONENTS_TURN: screenMessage("Waiting on opponent's move.");break;
@@ -369,3 +372,7 @@ void myDemoGame::processFlip(bool coin) {
 void myDemoGame::foundGame(void) {
   screenMessage("Found a game. Waiting on coin flip.");
 }
+void myDemoGame::playerElected(void) {
+  Serial.print("You are player #");
+  Serial.println(myPlayerNum);
+}
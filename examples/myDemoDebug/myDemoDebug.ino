@@ -1,11 +1,8 @@
 /*
  * Two Player Game Main Program
- * Compile and upload to one device using IS_PLAYER_1 true and compile and upload
- * to the other device using IS_PLAYER_1 false. This is the only difference between 
- * the code on the two different machines.
+ * Compile and upload exactly the same code to both devices. When they find each
+ * other they decide between themselves which one is player 1.
  */
-#define IS_PLAYER_1 0
-
 //Basic game engine code
 #include <TwoPlayerGame.h>
 
@@ -22,7 +19,7 @@
 RF69Radio Radio;
 myDemoMove Move;
 myDemoResults Results;
-myDemoGame Game(&Move, &Results, &Radio, IS_PLAYER_1);
+myDemoGame Game(&Move, &Results, &Radio);
 
 void setup() {
   Game.setup();           //Initializes everything
@@ -0,0 +1,130 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This file contains a computer opponent for playing tic-tac-toe on a single device. It is used
+ * when SINGLE_PLAYER is true.
+ *
+ * The computer is a complete second game object, "Computer", with a move and results of its own.
+ * It talks to your game through a pair of LoopbackRadio objects sharing "ComputerLink" exactly as
+ * a second PyGamer would over the air, so the game engine can't tell the difference. Your game's
+ * radio is a computerRadio. Whenever your game engine checks it for something to receive, it gives
+ * the Computer one step first. Each of its moves is one lookup in Perfect so it answers straight
+ * away, and it never loses.
+ *
+ * The Computer has no display. It keeps its own board and hash in "CPUBoard".
+ */
+#include <TwoPlayerGame_loopback.h>
+
+tttBoard CPUBoard;
+squares_t cpuSymbol;          //the computer's mark
+squares_t cpuOpponentsSymbol; //ours
+
+/*
+ * The computer's move. The packet is the same as ours so we just choose the square differently.
+ */
+class computerMove : public TTT_Move {
+  public:
+    void decideMyMove(void) override {
+      subType=NORMAL_MOVE;
+      square=CPUBoard.perfectMove(cpuSymbol);
+      CPUBoard.mark(square, cpuSymbol);
+    };
+};
+
+/*
+ * The computer's results. Same packet as ours but kept on the computer's board. Nothing is drawn.
+ */
+class computerResults : public TTT_Results {
+  public:
+    bool processResults(void) override {return subType!=NORMAL_RESULTS;};
+    bool generateResults(baseMove* Move)override;
+    bool predictResults(baseMove* Move)override;
+};
+
+bool computerResults::generateResults(baseMove* M) {
+  TTT_Move* Move = (TTT_Move*)M;
+  resultsNum = Move->moveNum;
+  if(Move->subType==QUIT_MOVE) {
+    subType=LOSE_RESULTS;
+    return true;
+  }
+  CPUBoard.mark(Move->square, cpuOpponentsSymbol);
+  switch(Win=CPUBoard.checkForWin(cpuOpponentsSymbol)) {
+    case TIE:     subType=TIE_RESULTS;    return true;
+    case NO_WIN:  subType=NORMAL_RESULTS; return false;
+    default:      subType=WIN_RESULTS;    return true;
+  }
+}
+
+bool computerResults::predictResults(baseMove* M) {
+  TTT_Move* Move = (TTT_Move*)M;
+  resultsNum = Move->moveNum;
+  switch(Win=CPUBoard.checkForWin(cpuSymbol)) {
+    case TIE:     subType=TIE_RESULTS;    return true;
+    case NO_WIN:  subType=NORMAL_RESULTS; return false;
+    default:      subType=WIN_RESULTS;    return true;
+  }
+}
+
+/*
+ * The computer's game object. Players are decided by discovery just as between two devices and
+ * it starts a new game as soon as one is over. It has nothing to resync or save.
+ */
+class computerGame : public baseGame {
+  public:
+    computerGame(computerMove* move_ptr, computerResults* results_ptr, baseRadio* radio_ptr)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {
+          perfectInformation=true;
+          hashCheck=true;
+        };
+    void initialize(void) override {baseGame::initialize(); CPUBoard.clear();};
+    bool coinFlip(void) override {return random(2);};
+    void processGameOver(void) override {initialize();};
+    void playerElected(void) override {
+      cpuSymbol=(squares_t)myPlayerNum;
+      cpuOpponentsSymbol=(squares_t)otherPlayerNum;
+    };
+    void fatalError(const char* s) override {
+      Serial.printf("Computer fatal error '%s'\n",s);
+      gameState= GAME_OVER;
+    };
+    uint32_t stateHash(void) override {return CPUBoard.hash.value;};
+};
+
+loopbackLink ComputerLink;
+LoopbackRadio ComputerRadio(&ComputerLink);
+computerMove ComputerMove;
+computerResults ComputerResults;
+computerGame Computer(&ComputerMove, &ComputerResults, &ComputerRadio);
+
+/*
+ * Your game's radio when you play against the computer. Sets the Computer up along with itself
+ * and lets it take a step each time your game engine looks for something to receive.
+ */
+class computerRadio : public LoopbackRadio {
+  public:
+    computerRadio(void) : LoopbackRadio(&ComputerLink) {};
+    bool setup(uint8_t myD,uint8_t otherD) {
+      Computer.setup();
+      return LoopbackRadio::setup(myD,otherD);
+    };
+    bool available(void) {
+      Computer.step();
+      return LoopbackRadio::available();
+    };
+    bool recvTimeout(uint8_t* packet_ptr,uint8_t* len_ptr,uint16_t timeout) {
+      uint32_t StartTime=millis();
+      while(!available() && ((millis()-StartTime) < timeout)) {
+        yield();
+      }
+      return LoopbackRadio::recvTimeout(packet_ptr,len_ptr,0);
+    };
+};
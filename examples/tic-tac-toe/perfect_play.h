@@ -0,0 +1,190 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This file contains two tables that the compiler works out for us and stores in flash, so the
+ * game never has to search for anything while it is running.
+ *
+ * A player's marks are kept as a 9-bit mask, bit "i" for square "i". WinLine[] has an entry for
+ * every one of the 512 masks saying which line, if any, it completes. That is the whole of
+ * checkForWin.
+ *
+ * A whole board is kept as a number from 0 to 3^9-1 with square "i" as base 3 digit "i": 0 for
+ * empty, 1 for a mark of the player about to move and 2 for their opponent's. Either player may
+ * go first so it is the same table for X and O. Perfect.entry[] has an entry for every one of
+ * those 19683 numbers giving every square where the player to move can make the best possible
+ * move, and whether they will then win, lose or draw. The best move wins as quickly as possible,
+ * or if it can't win, draws, or if it can't draw, loses as slowly as possible. The tables take
+ * 512 bytes and about 39K of flash.
+ *
+ * Both are made by constexpr functions. They are written the C++11 way, one return statement each
+ * with recursion instead of loops, so they build with the compiler in the Arduino board packages.
+ * Searching the game tree from every board would take the compiler far too long, so the boards
+ * are scored a level at a time starting from the full ones, each level looking up the one after.
+ * Even so it adds a few seconds to compiling the sketch.
+ */
+
+//Masks of the squares in each line, in the order checkForWin has always tried them.
+constexpr uint16_t TTT_LINE_MASK[8]= {0x007, 0x049, 0x038, 0x092, 0x1C0, 0x124, 0x111, 0x054};
+constexpr uint8_t TTT_LINE_WIN[8]= {TOP_ROW, LEFT_COLUMN, MIDDLE_ROW, MIDDLE_COLUMN, BOTTOM_ROW,
+            RIGHT_COLUMN, DESCENDING_DIAGONAL, ASCENDING_DIAGONAL};
+//Value of a mark in each square of the board number
+constexpr uint16_t TTT_DIGIT[9]= {1, 3, 9, 27, 81, 243, 729, 2187, 6561};
+
+//Number of possible boards, 3^9
+#define TTT_BOARDS 19683
+
+//All nine squares
+#define TTT_SQUARES 0x1FF
+
+//Perfect.entry[] bits above the nine squares telling what the player to move can expect.
+//If neither is set it's a draw. If there are no squares the game is already over.
+#define TTT_WINS  0x1000
+#define TTT_LOSES 0x2000
+
+/*
+ * A list of the numbers 0 to N-1 as a type, built by joining halves so the compiler doesn't
+ * have to nest thousands deep. We use it to call a constexpr function once per table entry.
+ */
+template<uint16_t... I> struct tttSeq {};
+template<class A, class B> struct tttJoin;
+template<uint16_t... A, uint16_t... B> struct tttJoin<tttSeq<A...>, tttSeq<B...> > {
+  typedef tttSeq<A..., (uint16_t)(sizeof...(A)+B)...> type;
+};
+template<uint16_t N> struct tttMakeSeq {
+  typedef typename tttJoin<typename tttMakeSeq<N/2>::type,
+                           typename tttMakeSeq<N-N/2>::type>::type type;
+};
+template<> struct tttMakeSeq<0> {typedef tttSeq<> type;};
+template<> struct tttMakeSeq<1> {typedef tttSeq<0> type;};
+
+/*
+ * Small pieces. The line completed by the marks "m" or NO_WIN, the number of marks in "m", the
+ * base 3 digit for square "s" of board number "code", and the marks of "symbol" on it.
+ */
+constexpr uint8_t tttLine(uint16_t m, uint8_t k=0) {
+  return (k==8) ? NO_WIN
+    : ((m & TTT_LINE_MASK[k])==TTT_LINE_MASK[k]) ? TTT_LINE_WIN[k] : tttLine(m, k+1);
+}
+constexpr uint8_t tttCount(uint16_t m) {
+  return m ? (m & 1) + tttCount(m >> 1) : 0;
+}
+constexpr uint8_t tttDigit(uint16_t code, uint8_t s) {
+  return (code / TTT_DIGIT[s]) % 3;
+}
+constexpr uint16_t tttMarks(uint16_t code, uint8_t symbol, uint8_t s=0) {
+  return (s==9) ? 0 : (((code % 3)==symbol) ? (1 << s) : 0) | tttMarks(code/3, symbol, s+1);
+}
+constexpr int8_t tttMax(int8_t a, int8_t b) {return (a>b) ? a : b;}
+//The same board seen by the other player
+constexpr uint16_t tttSwap(uint16_t code) {
+  return code ? ((code % 3) ? 3-(code % 3) : 0) + 3*tttSwap(code/3) : 0;
+}
+
+/*
+ * What we need to know about each board, worked out once. The low four bits are how many squares
+ * are filled. A line can only have been made by the opponent, who just moved. The player to move
+ * has made either as many marks as the opponent or one fewer. Any other board can't happen.
+ * "swap" is the board seen by the other player.
+ */
+#define TTT_LINE_MADE  0x10
+#define TTT_IMPOSSIBLE 0x20
+constexpr uint8_t tttInfoOf(uint8_t mine, uint8_t theirs, bool myLine, bool theirLine) {
+  return (mine+theirs) | (theirLine ? TTT_LINE_MADE : 0)
+    | ((myLine || ((uint8_t)(theirs-mine)>1)) ? TTT_IMPOSSIBLE : 0);
+}
+constexpr uint8_t tttInfoFor(uint16_t mine, uint16_t theirs) {
+  return tttInfoOf(tttCount(mine), tttCount(theirs), tttLine(mine)!=NO_WIN, tttLine(theirs)!=NO_WIN);
+}
+struct tttInfoTable {uint8_t entry[TTT_BOARDS]; uint16_t swap[TTT_BOARDS];};
+template<uint16_t... I> constexpr tttInfoTable tttMakeInfo(tttSeq<I...>) {
+  return tttInfoTable{{tttInfoFor(tttMarks(I, 1), tttMarks(I, 2))...}, {tttSwap(I)...}};
+}
+constexpr tttInfoTable tttInfo= tttMakeInfo(tttMakeSeq<TTT_BOARDS>::type());
+
+/*
+ * Scores are for the player about to move. Winning scores more the sooner it happens and losing
+ * scores less. A draw is zero. The scores of the boards with K marks come from those with K+1
+ * so tttLevel<K>::table holds the score of every board with K marks, worked out from
+ * tttLevel<K+1>, down to the empty board at K=0. Boards with some other number of marks score
+ * zero in it.
+ */
+struct tttScores {int8_t score[TTT_BOARDS];};
+template<uint8_t K> struct tttLevel;
+
+//Score of moving in square "s", or -100 if it's taken. Afterwards it's the opponent's move.
+template<uint8_t K> constexpr int8_t tttTry(uint16_t code, uint8_t s) {
+  return (tttDigit(code, s)!=0) ? -100
+    : -tttLevel<K+1>::table.score[tttInfo.swap[code + TTT_DIGIT[s]]];
+}
+template<> constexpr int8_t tttTry<9>(uint16_t code, uint8_t s) {return -100;}
+template<uint8_t K> constexpr int8_t tttBest(uint16_t code, uint8_t s=0) {
+  return (s==9) ? -100 : tttMax(tttTry<K>(code, s), tttBest<K>(code, s+1));
+}
+template<uint8_t K> constexpr int8_t tttScore(uint16_t code) {
+  return ((tttInfo.entry[code] & 0x0F)!=K) ? 0
+    : (tttInfo.entry[code] & TTT_LINE_MADE) ? -(10-K)
+    : (K==9) ? 0 : tttBest<K>(code);
+}
+template<uint8_t K, uint16_t... I> constexpr tttScores tttMakeLevel(tttSeq<I...>) {
+  return tttScores{{tttScore<K>(I)...}};
+}
+template<uint8_t K> struct tttLevel {
+  static constexpr tttScores table= tttMakeLevel<K>(tttMakeSeq<TTT_BOARDS>::type());
+};
+
+/*
+ * An entry of Perfect: every square that scores "best" and what that score means.
+ */
+template<uint8_t K> constexpr uint16_t tttBestSquares(uint16_t code, int8_t best, uint8_t s=0) {
+  return (s==9) ? 0
+    : ((tttTry<K>(code, s)==best) ? (1 << s) : 0) | tttBestSquares<K>(code, best, s+1);
+}
+template<uint8_t K> constexpr uint16_t tttEntryFor(uint16_t code, int8_t best) {
+  return tttBestSquares<K>(code, best) | ((best>0) ? TTT_WINS : (best<0) ? TTT_LOSES : 0);
+}
+template<uint8_t K> constexpr uint16_t tttEntry(uint16_t code) {
+  return tttEntryFor<K>(code, tttBest<K>(code));
+}
+//Boards where the game is over, or that can't happen in a game, get no squares
+constexpr uint16_t tttBoardEntry(uint16_t code, uint8_t k) {
+  return (tttInfo.entry[code] & (TTT_LINE_MADE | TTT_IMPOSSIBLE)) || (k==9) ? 0
+    : (k==0) ? tttEntry<0>(code) : (k==1) ? tttEntry<1>(code) : (k==2) ? tttEntry<2>(code)
+    : (k==3) ? tttEntry<3>(code) : (k==4) ? tttEntry<4>(code) : (k==5) ? tttEntry<5>(code)
+    : (k==6) ? tttEntry<6>(code) : (k==7) ? tttEntry<7>(code) : tttEntry<8>(code);
+}
+
+/*
+ * The tables themselves.
+ */
+struct tttWinTable {uint8_t entry[512];};
+struct tttPerfectTable {uint16_t entry[TTT_BOARDS];};
+template<uint16_t... I> constexpr tttWinTable tttMakeWins(tttSeq<I...>) {
+  return tttWinTable{{tttLine(I)...}};
+}
+template<uint16_t... I> constexpr tttPerfectTable tttMakePerfect(tttSeq<I...>) {
+  return tttPerfectTable{{tttBoardEntry(I, tttInfo.entry[I] & 0x0F)...}};
+}
+constexpr tttWinTable WinLine= tttMakeWins(tttMakeSeq<512>::type());
+constexpr tttPerfectTable Perfect= tttMakePerfect(tttMakeSeq<TTT_BOARDS>::type());
+
+/*
+ * Returns one of the best squares on board number "code", as seen by the player to move, chosen
+ * at random so the computer doesn't play the same game every time. The game MUST not be over.
+ */
+uint8_t pickPerfect(uint16_t code) {
+  uint16_t squares=Perfect.entry[code] & TTT_SQUARES;
+  uint8_t pick=random(tttCount(squares));
+  uint8_t i=0;
+  while(!((squares >> i) & 1) || pick--) {
+    i++;
+  }
+  return i;
+}
@@ -17,12 +17,31 @@
 //imput in addition to the joystick and buttons.
 #define ACCESSIBLE_INPUT false
 
+//Set this to true to record every game in "/journal.tpj" so that it can be played back later
+//with the journal_replay utility. The file grows by a kilobyte or two a game until you delete it.
+#define KEEP_JOURNAL true
+
+//Set this to true to let the computer choose your moves. It plays perfectly. See perfect_play.h
+//Nothing waits on a button so the game plays itself. Handy for demonstrations and soak tests.
+#define COMPUTER_PLAYS false
+
+//Set this to true to play against the computer on this one device. No radio is needed. The computer
+//is a second game object talking to yours through computerRadio. See computer_opponent.h
+//A game against the computer is not saved.
+#define SINGLE_PLAYER false
+
 #if(ACCESSIBLE_INPUT)
   #include <AccessibleArcada.h>   //alternate input system for assistive technology
   AccessibleArcada Device;
 #else
   Adafruit_Arcada Device;
 #endif
+#include <TwoPlayerGame_file_store.h> //Saves the game so it survives a reset
+fileStore SaveFile(&Device);
+#if(KEEP_JOURNAL)
+  #include <TwoPlayerGame_file_journal.h> //Records every game
+  fileJournal GameLog(&Device);
+#endif
 
 //Font used in opening splash screen
 #include <Fonts/FreeSans12pt7b.h>
@@ -34,13 +53,74 @@ enum squares_t {SQUARE_EMPTY, SQUARE_X, SQUARE_O};
 enum win_t {NO_WIN, TOP_ROW, MIDDLE_ROW, BOTTOM_ROW, LEFT_COLUMN, MIDDLE_COLUMN, RIGHT_COLUMN,
             DESCENDING_DIAGONAL, ASCENDING_DIAGONAL, TIE};
 
+//Tables of wins and perfect moves worked out when you compile
+#include "perfect_play.h"
+
+/*
+ * A tic-tac-toe board. Besides the squares it keeps each player's marks as a mask and the board
+ * number so that a win is one WinLine lookup and the best move one Perfect lookup.
+ *
+ *    squares_t square[9];
+ *      The squares of the board.
+ *
+ *    uint16_t marks[3];
+ *      The squares of X and of O, bit "i" for square "i". Indexed by squares_t. marks[SQUARE_EMPTY]
+ *      isn't used.
+ *
+ *    uint16_t code[3];
+ *      The board number as X and as O see it. See perfect_play.h. Indexed by squares_t.
+ *      code[SQUARE_EMPTY] isn't used.
+ *
+ *    zobristHash hash;
+ *      Hash of the board. Both devices must always agree on it.
+ *
+ *    void clear(void);
+ *      Empties the board.
+ *
+ *    void mark(uint8_t i, squares_t symbol);
+ *      Puts "symbol" in square "i", which MUST be empty.
+ *
+ *    win_t checkForWin(squares_t symbol);
+ *      Returns the line "symbol" has made, TIE if the board is full without one, or NO_WIN.
+ *
+ *    uint8_t perfectMove(squares_t symbol);
+ *      Returns one of the best squares for "symbol", whose turn it is. The game MUST not be over.
+ */
+class tttBoard {
+  public:
+    squares_t square[9];
+    uint16_t marks[3];
+    uint16_t code[3];
+    zobristHash hash;
+    void clear(void) {
+      for(uint8_t i=0;i<9;i++) {
+        square[i]=SQUARE_EMPTY;
+      }
+      marks[SQUARE_X]=marks[SQUARE_O]=0;
+      code[SQUARE_X]=code[SQUARE_O]=0;
+      hash.reset();
+    };
+    void mark(uint8_t i, squares_t symbol) {
+      square[i]=symbol;
+      marks[symbol] |= 1 << i;
+      code[symbol] += TTT_DIGIT[i];             //one of mine
+      code[3-symbol] += 2*TTT_DIGIT[i];         //one of my opponent's
+      hash.toggle(i*2 + (symbol==SQUARE_O));
+    };
+    win_t checkForWin(squares_t symbol) {
+      win_t w= (win_t)WinLine.entry[marks[symbol]];
+      return ((w==NO_WIN) && ((marks[SQUARE_X] | marks[SQUARE_O])==TTT_SQUARES)) ? TIE : w;
+    };
+    uint8_t perfectMove(squares_t symbol) {return pickPerfect(code[symbol]);};
+};
+
 /************************************************************************************
  * Various global variables not really part of the game engine object. Need to be able to
  * access these from a variety of locations so we made them global.
  *************************************************************************************/
 char message[40];     //buffer to be used with sprintf
 
-squares_t board[9];   //The squares of the board
+tttBoard Board;       //The board
 
 //"Center" of the tic-tac-toe board in pixels. Slightly higher than the actual center
 //  of the screen to make room for the bottom message area. Initialized in TTT_Game::setup()
@@ -54,6 +134,9 @@ squares_t opponentsSymbol;
 
 #define SIZE_OF_SQR 40
 #define X_SIZE (SIZE_OF_SQR/2-8)
+
+//Button a prompt waits for. Prompts don't wait when the computer plays.
+#define WAIT_FOR(button) (COMPUTER_PLAYS ? 0 : (button))
 /************************************************************************************
  * Various global functions not really part of the game engine object. Need to be able to
  * access these from a variety of locations so we made them global.
@@ -104,7 +187,7 @@ void drawBoard(void) {
   //if we see this message, it means we should have written a different message somewhere
   bottomMessage("testing 123 this is a test");
   for(uint8_t i=0;i<9;i++) {
-    drawSquare(board[i],i, ARCADA_WHITE);
+    drawSquare(Board.square[i],i, ARCADA_WHITE);
   }
 }
 /*
@@ -147,8 +230,8 @@ void drawWin(win_t w) {
  *    uint8_t square;
  *      The board index of the location where we placed our X or O.
  * 
- *    size_t my_size();
- *      This method returns the size of TTT_Move object. 
+ *    void fields(packetCodec& c);
+ *      This method lists the data we transmit. In this case it's just the square.
  *      
  *    void decideMyMove(void);
  *      Prompts us to make our move. See details below.
@@ -156,7 +239,7 @@ void drawWin(win_t w) {
 class TTT_Move : public baseMove {
   public:
     uint8_t square;
-    size_t my_size() override { return sizeof( *this ); };
+    void fields(packetCodec& c) override {baseMove::fields(c); c.field(square);};
     void decideMyMove(void)override;
 };
 
@@ -169,24 +252,32 @@ class TTT_Move : public baseMove {
  * When you press "SELECT" it turns WHITE and sets Move->square to the index of the selected square. 
  * 
  * If you press "START" it restarts the game. The "A" and "B" buttons do nothing. 
+ * 
+ * When COMPUTER_PLAYS is true the computer makes a perfect move for us instead.
  */
 void TTT_Move::decideMyMove(void) {
   subType=NORMAL_MOVE;
+  #if(COMPUTER_PLAYS)
+    square=Board.perfectMove(mySymbol);
+    Board.mark(square, mySymbol);
+    drawBoard();
+    return;
+  #endif
   //put the cursor at the first nonempty square. Assumes there is one.
   square=0;
-  while( (square<9) && (board[square] != SQUARE_EMPTY) ) {
+  while( (square<9) && (Board.square[square] != SQUARE_EMPTY) ) {
     square++;
   }
   uint32_t Buttons;
   drawBoard();
-  drawSquare(mySymbol, square, (board[square])?ARCADA_RED: ARCADA_GREEN);//the cursor
+  drawSquare(mySymbol, square, (Board.square[square])?ARCADA_RED: ARCADA_GREEN);//the cursor
   sprintf(message, "Your move #%d",moveNum);
   bottomMessage(message);
   while(true) {
     if (Buttons=Device.readButtons()) {//not an error
       Device.readButtons();//flush out or de-bounce
       drawSquare(SQUARE_EMPTY, square, ARCADA_WHITE);//erase cursor from the current position
-      drawSquare(board[square], square, ARCADA_WHITE);//redraw its previous contents
+      drawSquare(Board.square[square], square, ARCADA_WHITE);//redraw its previous contents
       switch(Buttons){
         case ARCADA_BUTTONMASK_UP:    square = (square+(9-3)) % 9; break;    
         case ARCADA_BUTTONMASK_DOWN:  square = (square+3) % 9; break;    
@@ -194,8 +285,8 @@ void TTT_Move::decideMyMove(void) {
         case ARCADA_BUTTONMASK_RIGHT: square = (square+1) % 9; break;    
         case ARCADA_BUTTONMASK_SELECT: 
           //We made our selection. 
-          if(board[square]== SQUARE_EMPTY) {
-            board[square]=mySymbol;
+          if(Board.square[square]== SQUARE_EMPTY) {
+            Board.mark(square, mySymbol);
             drawBoard();
             return;
           } else {
@@ -209,7 +300,7 @@ void TTT_Move::decideMyMove(void) {
           subType=QUIT_MOVE;
           return; 
       }
-      drawSquare(mySymbol, square, (board[square])?ARCADA_RED: ARCADA_GREEN);//cursor at new location
+      drawSquare(mySymbol, square, (Board.square[square])?ARCADA_RED: ARCADA_GREEN);//cursor at new location
     }
   }
 };
@@ -225,8 +316,8 @@ void TTT_Move::decideMyMove(void) {
  *      It can be one of the following values: NO_WIN, TOP_ROW, MIDDLE_ROW, BOTTOM_ROW, 
  *      LEFT_COLUMN, MIDDLE_COLUMN, RIGHT_COLUMN, DESCENDING_DIAGONAL, ASCENDING_DIAGONAL, or TIE.  
  *      
- *    size_t my_size();
- *      This method returns the size of the TTT_Results object.
+ *    void fields(packetCodec& c);
+ *      This method lists the data we transmit. In this case it's just the type of win.
  *    
  *    bool processResults(void)
  *      Processes the results packet we received in response to our move. See below for details.
@@ -234,13 +325,18 @@ void TTT_Move::decideMyMove(void) {
  *    bool generateResults(baseMove* Move);
  *      Generate results package in response to our opponent's move. It's up to us to decide if it was
  *      a tie or a winning move and what kind. See below for details.
+ *      
+ *    bool predictResults(baseMove* Move);
+ *      Tic-tac-toe is a perfect information game so we work out the results of our own move using
+ *      the same rules as generateResults. Our opponent only sends results if the game is over.
  */
 class TTT_Results : public baseResults {
   public:
     win_t Win;
-    size_t my_size() override { return sizeof( *this ); };
+    void fields(packetCodec& c) override {baseResults::fields(c); c.field(Win);};
     bool processResults(void)override;
     bool generateResults(baseMove* Move)override;
+    bool predictResults(baseMove* Move)override;
 };
 
 /*
@@ -255,55 +351,18 @@ bool TTT_Results::processResults(void) {
     //We don't use HIT_RESULTS or MISS_RESULTS in this game.
   }
 }
-/*
- * Extra non-method function determines if we got a tic-tac-toe or a tie.
- */
-win_t checkForWin(void) {
-  uint8_t i;
-  uint8_t countEmpty=0;
-  //if there are no empty squares it's a tie
-  for(i=0;i<9;i++) {
-    if(board[i]== SQUARE_EMPTY){
-      countEmpty++;
-    }
-  }
-  if(countEmpty==0) {
-    return TIE;
-  }
-  //If there is a "tic-tac-toe" generate WIN_RESULTS
-  for(i=0;i<3;i++) {
-    //check the rows
-    if( (board[i*3]==opponentsSymbol) && (board[i*3]==board[i*3+1]) && (board[i*3]==board[i*3+2]) ) { 
-      return (win_t)(((uint8_t)TOP_ROW)+i);
-    }
-    //check the columns
-    if( (board[i]==opponentsSymbol) && (board[i]==board[i+3]) && (board[i]==board[i+6]) ) {
-      return (win_t)(((uint8_t)LEFT_COLUMN)+i);
-    }
-  }
-  //check the diagonals
-  //upper left to lower right
-  if( (board[0]==opponentsSymbol) && (board[0]==board[4]) && (board[0]==board[8]) ) {  
-    return DESCENDING_DIAGONAL;
-  }
-  //upper right to lower left
-  if( (board[2]==opponentsSymbol) && (board[2]==board[4]) && (board[2]==board[6]) ) { 
-    return ASCENDING_DIAGONAL;
-  }
-  return NO_WIN;
-}
 /*
  * Looks at your opponent's move to see if it was a winning move. Sets Results->Win and Results->subType
  * appropriately. Returns true if game is over.
  */
 bool TTT_Results::generateResults(baseMove* M) {
   TTT_Move* Move = (TTT_Move*)M;//saves us a bunch of type casts
-  board[Move->square]=opponentsSymbol;
+  Board.mark(Move->square, opponentsSymbol);
   drawBoard();
   resultsNum = Move->moveNum;
   switch(Move->subType) {
     case NORMAL_MOVE:
-      switch(Win=checkForWin()) {
+      switch(Win=Board.checkForWin(opponentsSymbol)) {
         case TIE:
           subType=TIE_RESULTS; 
           bottomMessage("Its a tie.");
@@ -326,7 +385,32 @@ bool TTT_Results::generateResults(baseMove* M) {
     //case PASS_MOVE: not used in this game
   };
 }
+/*
+ * Works out the results of our own move exactly the way our opponent's generateResults will
+ * but without drawing anything. Returns true if we expect the game to be over.
+ */
+bool TTT_Results::predictResults(baseMove* M) {
+  TTT_Move* Move = (TTT_Move*)M;
+  resultsNum = Move->moveNum;
+  switch(Move->subType) {
+    case NORMAL_MOVE:
+      switch(Win=Board.checkForWin(mySymbol)) {
+        case TIE:     subType=TIE_RESULTS;    return true;
+        case NO_WIN:  subType=NORMAL_RESULTS; return false;
+        default:      subType=WIN_RESULTS;    return true;
+      }
+    case QUIT_MOVE:
+      subType=LOSE_RESULTS;
+      return true;
+  };
+  subType=NORMAL_RESULTS;
+  return false;
+}
 
+#if(SINGLE_PLAYER)
+  //The computer opponent and the radio that connects us to it
+  #include "computer_opponent.h"
+#endif
 
 /****************************************************************
  *    TTT_Game class and methods
@@ -337,9 +421,11 @@ bool TTT_Results::generateResults(baseMove* M) {
  * easier to make them global because some needed to be referenced inside Move and Results.
  * We have therefore added no additional data or methods beyond those we extend from baseGame.
  * 
- *    TTT_Game(TTT_Move* move_ptr, TTT_Results* results_ptr, RF69Radio* radio_ptr, bool isPlayer_1)
- *      : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) {};
- *          Standard constructor passes typecast pointers to the base constructor.
+ *    TTT_Game(TTT_Move* move_ptr, TTT_Results* results_ptr, baseRadio* radio_ptr)
+ *      : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {};
+ *          Standard constructor passes typecast pointers to the base constructor. It also turns on
+ *          perfectInformation because both players can see the whole board. The radio is an
+ *          RF69Radio or, when SINGLE_PLAYER is true, a computerRadio.
  *          
  *    void setup(void)
  *      Runs ONCE during the setup() function of the main program. Initializes Arcada Device and
@@ -349,9 +435,9 @@ bool TTT_Results::generateResults(baseMove* M) {
  *      This method is called by the game engine at the start of each new game.
  *      
  *    bool coinFlip(void)
- *      This method called by the offering player to determine who goes first using a random number.  
- *      Prompts the user to press "A" to initiate the flip. If it returns true then the offering 
- *      player goes first. If it returns false, the accepting player goes first. The game engine
+ *      This method called by player 1 to determine who goes first using a random number.  
+ *      Prompts the user to press "A" to initiate the flip. If it returns true then player 1
+ *      goes first. If it returns false, player 2 goes first. The game engine
  *      handles everything else. We just produce a true or false outcome of the flip.
  *      
  *    void processGameOver(void);
@@ -369,12 +455,35 @@ bool TTT_Results::generateResults(baseMove* M) {
  *      This method is called to inform the outcome of the coin flip. Prints a message.
  *      
  *    void foundGame(void);
- *      This method is called on the seeking player when he finds a game. Prints a message.
+ *      This method is called on player 2 when it finds a game. Prints a message.
+ *      
+ *    void playerElected(void);
+ *      Called on both devices once they have decided which one is player 1. Player 1 is X.
+ *      
+ *    void snapshot(packetCodec& c);
+ *    bool restore(packetCodec& c);
+ *    uint32_t stateHash(void);
+ *      Used by the game engine to check that both devices agree about the board and to copy it from 
+ *      the other device if they don't. X and O mean the same thing on both devices so the board 
+ *      can simply be copied.
+ *      
+ *    void persist(packetCodec& c);
+ *    bool resume(packetCodec& c);
+ *      Used by the game engine to save the board in SaveFile after every turn and pick it up again 
+ *      after a reset. The board is all there is so they are the same as snapshot and restore.
  */
 class TTT_Game : public baseGame {
   public:
-    TTT_Game(TTT_Move* move_ptr, TTT_Results* results_ptr, RF69Radio* radio_ptr, bool isPlayer_1)
-        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, (baseRadio*)radio_ptr, isPlayer_1) {};
+    TTT_Game(TTT_Move* move_ptr, TTT_Results* results_ptr, baseRadio* radio_ptr)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {
+          perfectInformation=true;
+          resync=!SINGLE_PLAYER;
+          hashCheck=true;
+          Store=&SaveFile;
+          #if(KEEP_JOURNAL)
+            Journal=&GameLog;
+          #endif
+        };
     void setup(void) override;
     void initialize(void) override;
     bool coinFlip(void) override;
@@ -383,6 +492,12 @@ class TTT_Game : public baseGame {
     void loopContents(void) override;
     void processFlip(bool coin) override;
     void foundGame(void) override;
+    void playerElected(void) override;
+    void snapshot(packetCodec& c) override;
+    bool restore(packetCodec& c) override;
+    void persist(packetCodec& c) override {snapshot(c);};
+    bool resume(packetCodec& c) override;
+    uint32_t stateHash(void) override {return Board.hash.value;};
 };
 
 /*
@@ -392,14 +507,11 @@ void TTT_Game::setup(void) {
   #if(ACCESSIBLE_INPUT)
     //we use the serial monitor for alternate input
     Serial.begin(115200); while (!Serial) { delay(1);};
-    Serial.print("\n\n\n\nTwo Player Game Setup. You are player #");
-    Serial.println(myPlayerNum);
+    Serial.println("\n\n\n\nTwo Player Game Setup.");
   #endif
   Device.arcadaBegin();
   Device.displayBegin();
-  mySymbol=(squares_t)myPlayerNum;
   Device.setBacklight(90);
-  opponentsSymbol=(squares_t)otherPlayerNum;
   centerX=Device.display->width()/2;
   centerY=Device.display->height()/2-5;
   baseGame::setup();  //MUST call this
@@ -425,14 +537,7 @@ void TTT_Game::initialize(void) {
   CenterTextH("Welcome", 30);
   CenterTextH("to",55);
   CenterTextH("Tic-Tac-Toe",80);
-  if(mySymbol== SQUARE_X) {
-    CenterTextH("You are X",105);
-  } else {
-    CenterTextH("You are O",105);
-  }
-  for(uint8_t i=0;i<9;i++){
-    board[i]=SQUARE_EMPTY;
-  }
+  Board.clear();
   delay(5000);
 };
 /*
@@ -440,7 +545,7 @@ void TTT_Game::initialize(void) {
  */
 bool TTT_Game::coinFlip(void) {
   Device.display->fillScreen(ARCADA_GREEN);
-  Device.infoBox ("Offer accepted!\nFlip the coin to see who goes first.");
+  Device.infoBox ("Found a game!\nFlip the coin to see who goes first.", WAIT_FOR(ARCADA_BUTTONMASK_A));
   Device.display->fillScreen(ARCADA_GREEN);
   bool coin=random(2);//a random integer less than 2 i.e. zero or one
   if(coin) {
@@ -458,7 +563,7 @@ bool TTT_Game::coinFlip(void) {
  */
 void TTT_Game::processGameOver(void) {
   delay(5000);
-  Device.infoBox("Press 'Start' to restart.", ARCADA_BUTTONMASK_START);
+  Device.infoBox("Press 'Start' to restart.", WAIT_FOR(ARCADA_BUTTONMASK_START));
   initialize();
 };
 /*
@@ -476,7 +581,7 @@ void TTT_Game::loopContents(void) {
   switch(gameState) {
     case OFFERING_GAME: 
       Device.display->fillScreen(ARCADA_GREEN);
-      Device.alertBox ("Offering a game.", ARCADA_WHITE, ARCADA_BLACK,0);
+      Device.alertBox ("Looking for a game.", ARCADA_WHITE, ARCADA_BLACK,0);
       break;
     case SEEKING_GAME:
       Device.display->fillScreen(ARCADA_GREEN);
@@ -506,3 +611,70 @@ void TTT_Game::foundGame(void) {
   bottomMessage("Waiting on coin toss");
   Device.infoBox("Found a game. Waiting on the coin toss.",0);
 }
+/*
+ * Player numbers are not known until we find a game. Player 1 is always X.
+ */
+void TTT_Game::playerElected(void) {
+  mySymbol=(squares_t)myPlayerNum;
+  opponentsSymbol=(squares_t)otherPlayerNum;
+  #if(ACCESSIBLE_INPUT)
+    Serial.print("Found a game. You are player #");
+    Serial.println(myPlayerNum);
+  #endif
+  Device.display->fillScreen(ARCADA_GREEN);
+  Device.infoBox((mySymbol==SQUARE_X) ? "You are X" : "You are O",0);
+  delay(2000);
+}
+
+/*
+ * Our snapshot is the board. If we are waiting on official results for our move it is left off
+ * because the game engine will send it again.
+ */
+void TTT_Game::snapshot(packetCodec& c) {
+  uint8_t copy[9];
+  for(uint8_t i=0;i<9;i++) {
+    copy[i]=Board.square[i];
+  }
+  if(movePending() && (Move->subType==NORMAL_MOVE)) {
+    copy[((TTT_Move*)Move)->square]=SQUARE_EMPTY;
+  }
+  c.field(copy);
+}
+
+/*
+ * Copies our opponent's board and works out its hash, masks and number from scratch.
+ */
+bool TTT_Game::restore(packetCodec& c) {
+  uint8_t copy[9];
+  c.field(copy);
+  if(!c.ok) {
+    return false;
+  }
+  for(uint8_t i=0;i<9;i++) {
+    if(copy[i]>SQUARE_O) {
+      return false;
+    }
+  }
+  Board.clear();
+  for(uint8_t i=0;i<9;i++) {
+    if(copy[i]!=SQUARE_EMPTY) {
+      Board.mark(i, (squares_t)copy[i]);
+    }
+  }
+  drawBoard();
+  bottomMessage("Back in step with opponent.");
+  return true;
+}
+
+/*
+ * Picks the game up after a reset. playerElected isn't called so we work out our symbols here.
+ */
+bool TTT_Game::resume(packetCodec& c) {
+  mySymbol=(squares_t)myPlayerNum;
+  opponentsSymbol=(squares_t)otherPlayerNum;
+  if(!restore(c)) {
+    return false;
+  }
+  bottomMessage("Resumed the saved game.");
+  return true;
+}
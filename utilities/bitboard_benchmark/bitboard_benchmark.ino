@@ -0,0 +1,263 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility compares two ways of keeping a Battleship board. The old way is an array with one
+ * grid_t value for each square, the way the Battleship example used to do it. The new way is a few
+ * bitBoard masks, one for the squares holding ships and one for the squares fired at, the way it
+ * does now. See "TwoPlayerGame_bitboard.h". Both are timed doing the same three jobs on grids of
+ * 10 x 10, 16 x 16 and 20 x 20:
+ *
+ *    placement   Is a ship at a random place and direction on the board and clear of the ships
+ *                already placed? About half the tries fail, as they do in random placement.
+ *    hit         Does a shot at a random square hit a ship?
+ *    sunk        Has every square of a ship been hit? Also the test for a win, that every square
+ *                of every ship has been hit.
+ *    fleet       Place a whole fleet at random. The old way tries random squares and directions for
+ *                each ship until one fits. The new way is bitBoard::randomLines, the same call
+ *                randomFleet in the Battleship example makes. It picks from the places each ship
+ *                fits and starts again on any overlap so that every layout is equally likely. Also printed is how many layouts it tried and how
+ *                often the carrier covers the middle square each way. The old way places the
+ *                carrier first on an empty board so it lands there a little more often.
+ *
+ * Every result from the two ways is compared and any disagreement is reported. Results are printed
+ * on the serial monitor. It runs on any board. No radio wing is needed.
+ */
+#include <TwoPlayerGame.h>
+
+//Number of times each job is done for each grid size
+#define TRIALS 20000
+
+//Ship lengths of the standard fleet
+const uint8_t Lengths[5]= {5,4,3,3,2};
+
+/*
+ * The old way. One value per square.
+ */
+enum grid_t {GRID_EMPTY, GRID_MISS, GRID_HIT, GRID_SHIP_HIT, GRID_CURSOR,
+            GRID_SHIP_0, GRID_SHIP_1, GRID_SHIP_2, GRID_SHIP_3, GRID_SHIP_4};
+
+template<uint8_t W, uint8_t H> class arrayBoard {
+  public:
+    grid_t sea[W*H];
+    void clear(void) {
+      for(uint16_t i=0;i<W*H;i++) {
+        sea[i]=GRID_EMPTY;
+      }
+    };
+    bool fits(uint16_t index, uint8_t length, bool vertical) {
+      if(vertical) {
+        if(index + W*(length-1) >= W*H) {
+          return false;
+        }
+      } else if((index/W) != ((index+length-1)/W)) {
+        return false;
+      }
+      for(uint8_t k=0;k<length;k++) {
+        if(sea[index + (vertical ? k*W : k)] != GRID_EMPTY) {
+          return false;
+        }
+      }
+      return true;
+    };
+    void place(uint8_t ship, uint16_t index, uint8_t length, bool vertical) {
+      for(uint8_t k=0;k<length;k++) {
+        sea[index + (vertical ? k*W : k)]= (grid_t)(GRID_SHIP_0+ship);
+      }
+    };
+    bool hit(uint16_t shot) {return sea[shot]>=GRID_SHIP_0;};
+    bool sunk(uint16_t index, uint8_t length, bool vertical) {
+      for(uint8_t k=0;k<length;k++) {
+        if(sea[index + (vertical ? k*W : k)] != GRID_SHIP_HIT) {
+          return false;
+        }
+      }
+      return true;
+    };
+    bool won(void) {
+      for(uint16_t i=0;i<W*H;i++) {
+        if(sea[i]>=GRID_SHIP_0) {
+          return false;
+        }
+      }
+      return true;
+    };
+};
+
+/*
+ * The new way. A mask for each ship, one for every ship and one for every shot.
+ */
+template<uint8_t W, uint8_t H> class maskBoard {
+  public:
+    typedef bitBoard<W,H> mask_t;
+    mask_t ships, shots, ship[5];
+    void clear(void) {ships.clear(); shots.clear();};
+    bool fits(uint16_t index, uint8_t length, bool vertical) {
+      mask_t m;
+      return m.line(index,length,vertical) && !m.intersects(ships);
+    };
+    void place(uint8_t s, uint16_t index, uint8_t length, bool vertical) {
+      ship[s].line(index,length,vertical);
+      ships |= ship[s];
+    };
+    bool hit(uint16_t shot) {return ships.test(shot);};
+    bool sunk(uint8_t s) {return shots.contains(ship[s]);};
+    bool won(void) {return shots.contains(ships);};
+};
+
+//Number of fleets placed each way for each grid size
+#define FLEETS 20000
+
+uint32_t Disagree;
+volatile uint32_t Sink;   //keeps the compiler from throwing the work away
+
+/*
+ * Prints one line of results
+ */
+void report(const char* job, uint32_t arrayTime, uint32_t maskTime) {
+  Serial.print("  "); Serial.print(job);
+  Serial.print("  array nsec="); Serial.print(arrayTime*1000.0/TRIALS);
+  Serial.print("  mask nsec="); Serial.print(maskTime*1000.0/TRIALS);
+  Serial.print("  speedup="); Serial.println(maskTime ? (float)arrayTime/maskTime : 0.0);
+}
+
+/*
+ * Sets up the same random fleet on both boards and fires the same random shots at both. Then
+ * times each job on each board.
+ */
+template<uint8_t W, uint8_t H> void benchmark(void) {
+  static arrayBoard<W,H> A;
+  static maskBoard<W,H> M;
+  static uint16_t Index[TRIALS];
+  static uint8_t Length[TRIALS];
+  static bool Vertical[TRIALS];
+  const uint16_t cells=W*H;
+  uint16_t at[5];
+  bool down[5];
+  uint32_t i, StartTime, arrayTime, maskTime, n;
+  Serial.print(W); Serial.print(" x "); Serial.print(H);
+  Serial.print(" grid. Bytes per board array="); Serial.print(sizeof(A.sea));
+  Serial.print("  mask="); Serial.println(sizeof(M.ships));
+  A.clear(); M.clear();
+  for(uint8_t s=0;s<5;s++) {
+    do {
+      at[s]=random(cells);
+      down[s]=random(2);
+    } while(!A.fits(at[s],Lengths[s],down[s]));
+    A.place(s,at[s],Lengths[s],down[s]);
+    M.place(s,at[s],Lengths[s],down[s]);
+  }
+  for(i=0;i<TRIALS;i++) {
+    Index[i]=random(cells);
+    Length[i]=Lengths[random(5)];
+    Vertical[i]=random(2);
+  }
+
+  StartTime=micros();
+  for(n=0,i=0;i<TRIALS;i++) {
+    n+=A.fits(Index[i],Length[i],Vertical[i]);
+  }
+  arrayTime=micros()-StartTime;
+  Sink=n;
+  StartTime=micros();
+  for(n=0,i=0;i<TRIALS;i++) {
+    n+=M.fits(Index[i],Length[i],Vertical[i]);
+  }
+  maskTime=micros()-StartTime;
+  Disagree+= (n!=Sink);
+  for(i=0;i<TRIALS;i++) {
+    Disagree+= (A.fits(Index[i],Length[i],Vertical[i]) != M.fits(Index[i],Length[i],Vertical[i]));
+  }
+  report("placement",arrayTime,maskTime);
+
+  StartTime=micros();
+  for(n=0,i=0;i<TRIALS;i++) {
+    n+=A.hit(Index[i]);
+  }
+  arrayTime=micros()-StartTime;
+  Sink=n;
+  StartTime=micros();
+  for(n=0,i=0;i<TRIALS;i++) {
+    n+=M.hit(Index[i]);
+  }
+  maskTime=micros()-StartTime;
+  Disagree+= (n!=Sink);
+  report("hit      ",arrayTime,maskTime);
+
+  //Fire at every ship square but the last one of the patrol boat so nothing is won yet
+  for(uint8_t s=0;s<5;s++) {
+    for(uint8_t k=0;k<Lengths[s]-(s==4);k++) {
+      uint16_t shot=at[s] + (down[s] ? k*W : k);
+      A.sea[shot]=GRID_SHIP_HIT;
+      M.shots.set(shot);
+    }
+  }
+  StartTime=micros();
+  for(n=0,i=0;i<TRIALS;i++) {
+    uint8_t s=i%5;
+    n+=A.sunk(at[s],Lengths[s],down[s]) + A.won();
+  }
+  arrayTime=micros()-StartTime;
+  Sink=n;
+  StartTime=micros();
+  for(n=0,i=0;i<TRIALS;i++) {
+    uint8_t s=i%5;
+    n+=M.sunk(s) + M.won();
+  }
+  maskTime=micros()-StartTime;
+  Disagree+= (n!=Sink);
+  report("sunk     ",arrayTime,maskTime);
+
+  //Whole fleets. Neither way can go wrong so there is nothing to compare but the middle square.
+  const uint16_t middle=(H/2)*W + W/2;
+  uint32_t arrayMiddle=0, maskMiddle=0, tries=0;
+  StartTime=micros();
+  for(i=0;i<FLEETS;i++) {
+    A.clear();
+    for(uint8_t s=0;s<5;s++) {
+      do {
+        at[s]=random(cells);
+        down[s]=random(2);
+      } while(!A.fits(at[s],Lengths[s],down[s]));
+      A.place(s,at[s],Lengths[s],down[s]);
+    }
+    arrayMiddle+= (A.sea[middle]==GRID_SHIP_0);
+  }
+  arrayTime=micros()-StartTime;
+  StartTime=micros();
+  for(i=0;i<FLEETS;i++) {
+    tries+=bitBoard<W,H>::randomLines(5, Lengths, at, down, M.ship, M.ships);
+    maskMiddle+= M.ship[0].test(middle);
+  }
+  maskTime=micros()-StartTime;
+  Serial.print("  fleet      array usec="); Serial.print((float)arrayTime/FLEETS);
+  Serial.print("  mask usec="); Serial.print((float)maskTime/FLEETS);
+  Serial.print("  layouts tried="); Serial.println((float)tries/FLEETS);
+  Serial.print("             carrier in the middle array="); Serial.print(arrayMiddle*100.0/FLEETS);
+  Serial.print("%  mask="); Serial.print(maskMiddle*100.0/FLEETS); Serial.println("%");
+}
+
+void setup() {
+  Serial.begin(115200); while (!Serial) {delay(1);};
+  Serial.println("Bitboard benchmark");
+  randomSeed(analogRead(0));
+  Disagree=0;
+  benchmark<10,10>();
+  benchmark<16,16>();
+  benchmark<20,20>();
+  if(Disagree) {
+    Serial.print("The two ways disagreed "); Serial.print(Disagree); Serial.println(" times!");
+  } else {
+    Serial.println("The two ways always agreed.");
+  }
+}
+
+void loop() {
+}
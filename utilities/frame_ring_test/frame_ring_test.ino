@@ -0,0 +1,193 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility tests frameRing from "TwoPlayerGame_frame_ring.h", the ring the RF69HCW receive
+ * interrupt fills and the main loop empties. It does two jobs:
+ *
+ *    basic       On any board. Fills the ring, overfills it, sends a frame that is too large,
+ *                truncates one into a small buffer, and pushes and pops enough frames of every
+ *                length to wrap the indices around many times. Every frame must come out whole
+ *                and in order and every drop must be counted.
+ *    threads     Built for a desktop Arduino emulation only, where it is a Linux command line tool.
+ *                A producer thread pushes THREAD_FRAMES frames of varying length while the main
+ *                thread pops them, the way the interrupt and the main loop share the ring on a
+ *                board. Each frame holds its own sequence number and a pattern made from it, so a
+ *                frame that is seen before it has been completely copied in shows up as damaged.
+ *                It runs once with the ring the radio uses and once with a ring of only two slots
+ *                so that the two threads are fighting over the same slot nearly all the time.
+ *
+ * Results are printed on the serial monitor. No radio wing is needed.
+ */
+#include <TwoPlayerGame.h>
+#include <TwoPlayerGame_frame_ring.h>
+#if defined(__linux__)
+  #include <thread>
+  #define HAVE_THREADS true
+#else
+  #define HAVE_THREADS false
+#endif
+
+//Frames pushed by the producer thread in each threads test
+#define THREAD_FRAMES 300000UL
+
+//Largest frame the tests use, the same as the radio
+#define RING_FRAME 60
+
+uint32_t Failures;
+
+/*
+ * Prints a check that failed and counts it
+ */
+void check(const char* name, bool ok) {
+  if(!ok) {
+    Serial.print("  FAILED: "); Serial.println(name);
+    Failures++;
+  }
+}
+
+/*
+ * Frame number "n". Its length runs through every size from 4 to RING_FRAME. The first four bytes
+ * are "n" itself and the rest a pattern made from it.
+ */
+uint8_t makeFrame(uint32_t n, uint8_t* buf) {
+  uint8_t len=4 + n % (RING_FRAME-3);
+  memcpy(buf,&n,4);
+  for(uint8_t k=4;k<len;k++) {
+    buf[k]=(uint8_t)(n*7+k);
+  }
+  return len;
+}
+
+/*
+ * Returns true if "buf" is frame number "n" and all of it.
+ */
+bool checkFrame(uint32_t n, const uint8_t* buf, uint8_t len) {
+  uint8_t expected[RING_FRAME];
+  uint8_t expectedLen=makeFrame(n,expected);
+  return (len==expectedLen) && (memcmp(buf,expected,len)==0);
+}
+
+void basic(void) {
+  static frameRing<8,RING_FRAME> R;
+  uint8_t buf[RING_FRAME];
+  uint8_t len;
+  uint32_t n;
+  Serial.println("Basic");
+  check("starts empty", R.empty() && (R.dropped==0));
+  len=sizeof(buf);
+  check("nothing to pop", !R.pop(buf,&len));
+  for(n=0;n<8;n++) {
+    len=makeFrame(n,buf);
+    check("push until full", R.push(buf,len));
+  }
+  len=makeFrame(n,buf);
+  check("push when full is dropped", !R.push(buf,len) && (R.dropped==1));
+  len=sizeof(buf);
+  check("pop the first", R.pop(buf,&len) && checkFrame(0,buf,len));
+  uint8_t big[RING_FRAME+1];
+  memset(big,0,sizeof(big));
+  check("too large is dropped", !R.push(big,sizeof(big)) && (R.dropped==2));
+  len=makeFrame(8,buf);
+  check("room again after a pop", R.push(buf,len));
+  len=2;
+  check("pop truncates", R.pop(buf,&len) && (len==2) && (memcmp(buf,"\x01\x00",2)==0));
+  for(n=2;n<=8;n++) {
+    len=sizeof(buf);
+    check("the rest in order", R.pop(buf,&len) && checkFrame(n,buf,len));
+  }
+  check("empty again", R.empty());
+  //Many times around the 8-bit indices, sometimes with several frames waiting
+  bool ok=true;
+  uint32_t pushed=0, popped=0;
+  for(uint32_t i=0;i<10000;i++) {
+    uint8_t k=i % 7;
+    while(k-- && (pushed-popped<8)) {
+      len=makeFrame(pushed,buf);
+      ok= ok && R.push(buf,len);
+      pushed++;
+    }
+    len=sizeof(buf);
+    if(R.pop(buf,&len)) {
+      ok= ok && checkFrame(popped,buf,len);
+      popped++;
+    }
+  }
+  while(popped<pushed) {
+    len=sizeof(buf);
+    ok= ok && R.pop(buf,&len) && checkFrame(popped,buf,len);
+    popped++;
+  }
+  check("wrapping the indices", ok && R.empty() && (R.dropped==2));
+  Serial.print("  frames through the wrapping test="); Serial.println(pushed);
+}
+
+#if(HAVE_THREADS)
+/*
+ * The producer pushes every frame, trying again whenever the ring is full. The consumer pops
+ * them and checks each one. Prints the number that were damaged or out of order, how often
+ * the producer found the ring full, and how many frames per second got through.
+ */
+template<uint8_t SLOTS> void threads(const char* name) {
+  static frameRing<SLOTS,RING_FRAME> R;
+  uint32_t StartTime=micros();
+  std::thread Producer([]() {
+    uint8_t buf[RING_FRAME];
+    for(uint32_t n=0;n<THREAD_FRAMES;n++) {
+      uint8_t len=makeFrame(n,buf);
+      while(!R.push(buf,len)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint8_t buf[RING_FRAME];
+  uint32_t bad=0;
+  for(uint32_t n=0;n<THREAD_FRAMES;) {
+    uint8_t len=sizeof(buf);
+    if(!R.pop(buf,&len)) {
+      std::this_thread::yield();
+      continue;
+    }
+    bad+= !checkFrame(n,buf,len);
+    n++;
+  }
+  Producer.join();
+  uint32_t Elapsed=micros()-StartTime;
+  Serial.print("  "); Serial.print(name);
+  Serial.print(" frames="); Serial.print(THREAD_FRAMES);
+  Serial.print("  damaged="); Serial.print(bad);
+  Serial.print("  ring full="); Serial.print(R.dropped);
+  Serial.print("  frames/sec="); Serial.println((uint32_t)(THREAD_FRAMES*1000000.0/Elapsed));
+  check("every frame whole and in order", bad==0);
+  check("nothing left over", R.empty());
+}
+#endif
+
+void setup() {
+  Serial.begin(115200); while (!Serial) {delay(1);};
+  Serial.println("Frame ring test");
+  Failures=0;
+  basic();
+  #if(HAVE_THREADS)
+    Serial.println("Producer thread");
+    threads<8>("8 slots");
+    threads<2>("2 slots");
+  #else
+    Serial.println("No threads on this board. Build for a desktop emulation to test them.");
+  #endif
+  if(Failures) {
+    Serial.print(Failures); Serial.println(" checks FAILED!");
+  } else {
+    Serial.println("All checks passed.");
+  }
+}
+
+void loop() {
+}
@@ -0,0 +1,520 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility plays back games recorded by a journal. See "baseGame::Journal" and
+ * "TwoPlayerGame_base_journal.h". Send it the journal file over the serial port within REPLAY_WAIT
+ * milliseconds of starting. Built for a desktop Arduino emulation it is a Linux command line tool
+ * that reads the journal from standard input:
+ *
+ *    journal_replay < journal.tpj
+ *
+ * If no journal arrives it records a few demonstration games of its own and plays those back.
+ *
+ * Every game in the journal is played again between two "puppet" players connected by a pair of
+ * LoopbackRadio objects. One of them takes the place of the device that kept the journal and the
+ * other takes the place of its opponent. The puppets know nothing about the rules of your game.
+ * Whenever one of them has to decide a move or generate results it looks up what was actually sent
+ * in the journal and sends that. Everything else, the handshake, the turns, piggybacked and predicted
+ * results and acknowledgments, is done by the real game engine with the settings the game was played
+ * with. The puppet standing in for the journal's device keeps a journal of its own. At the end of
+ * each game it is compared packet by packet with the original, so you can tell whether the engine
+ * does exactly what it did in the field, and if not, where it first went a different way.
+ *
+ * Each game is played twice. First as fast as possible, which measures how long the game engine
+ * takes per move without any radio or game logic. Then at the speed it was recorded, with each move
+ * made at the same moment after the start of the game as it was originally. Set RECORDED_SPEED to 0
+ * to skip that.
+ *
+ * The puppets don't check hashes or resync. A hash is sent along as if it were part of your game's
+ * data. A game that was resynced plays back only as far as the point where the devices disagreed.
+ * Results are printed on the serial monitor. No radio wing is needed.
+ */
+#include <TwoPlayerGame.h>
+#include <TwoPlayerGame_loopback.h>
+
+//Largest journal we can hold in RAM
+#define REPLAY_SIZE 16384
+//Most records in a single game
+#define REPLAY_RECORDS 1024
+//Milliseconds to wait for a journal to start arriving and of silence that means all of it has
+#define REPLAY_WAIT 5000
+#define REPLAY_QUIET 500
+//Milliseconds a replay may run beyond the length of the recorded game before we give up
+#define REPLAY_TIMEOUT 5000
+//Set to 0 to replay only as fast as possible
+#define RECORDED_SPEED 1
+
+//Moves in each demonstration game
+#define DEMO_MOVES 40
+//Longest time in milliseconds a demonstration player takes to decide on its move
+#define DEMO_THINK 20
+
+/*
+ * A journal kept in RAM. It holds the journal we were sent and the one the puppets make.
+ */
+class memoryJournal : public baseJournal {
+  public:
+    uint8_t Data[REPLAY_SIZE];
+    uint16_t length;
+    memoryJournal(void) {length=0;};
+    bool begin(void) override {return true;};
+    bool append(const uint8_t* buf, uint16_t len) override {
+      if(length+len > REPLAY_SIZE) {
+        return false;
+      }
+      memcpy(Data+length,buf,len);
+      length+=len;
+      return true;
+    };
+};
+
+memoryJournal Original, Replayed;
+
+/*
+ * The records of the game being played back and what we know about it from its JOURNAL_START.
+ * Times are in milliseconds after the start of the game. The puppets find what to send with
+ * "find" which returns the first packet of the given type and number or -1 if there isn't one.
+ * "extra" returns how many bytes of a recorded packet come after the "used" bytes the engine's
+ * own fields take. Those are your game's data, which the puppets pass along without looking at.
+ */
+class replayScript {
+  public:
+    uint16_t count;
+    uint16_t offset[REPLAY_RECORDS];  //where each record starts in Original.Data
+    uint32_t time[REPLAY_RECORDS];
+    uint8_t player;                   //player number of the device that kept the journal
+    uint8_t flags;
+    uint16_t firstMove;
+    uint16_t moves;
+    bool realTime;                    //make each move at its recorded time
+    bool ranOut;                      //a puppet needed something the journal doesn't have
+    uint32_t startTime;               //millis() when the puppets started playing
+    uint16_t load(uint16_t pos);
+    bool startsAt(uint16_t pos) {
+      uint8_t* d=Original.Data+pos;
+      return (pos+JOURNAL_HEADER+4 <= Original.length) && (d[0]==JOURNAL_START) && (d[3]==4) &&
+             ((d[4]==1) || (d[4]==2)) && (d[5] < (JOURNAL_RESUMED << 1));
+    };
+    uint8_t kind(uint16_t i) {return Original.Data[offset[i]];};
+    uint8_t len(uint16_t i) {return Original.Data[offset[i]+3];};
+    uint8_t* data(uint16_t i) {return Original.Data+offset[i]+JOURNAL_HEADER;};
+    int16_t find(packetType_t type, uint16_t number) {
+      for(uint16_t i=0;i<count;i++) {
+        if((basePacket::frameType(data(i))==type) && (basePacket::frameNumber(data(i),len(i))==number)) {
+          return i;
+        }
+      }
+      return -1;
+    };
+    uint8_t extra(packetType_t type, uint16_t number, uint8_t used) {
+      int16_t i=find(type,number);
+      return ((i<0) || (len(i)<used)) ? 0 : len(i)-used;
+    };
+    bool fill(basePacket* p, packetType_t type, uint16_t number) {
+      int16_t i=find(type,number);
+      if(i<0) {
+        ranOut=true;
+        return false;
+      }
+      if(realTime && (type==MOVE_PACKET)) {
+        while((millis()-startTime) < time[i]) {
+          delay(1);
+        }
+      }
+      return p->decode(data(i),len(i));
+    };
+};
+replayScript Replay;
+
+/*
+ * Reads the game starting with the JOURNAL_START record at "pos". Returns where the next game
+ * starts. If the journal is damaged, perhaps because the power failed while it was being written,
+ * the game ends with the last record that looks right and we return where the caller should start 
+ * looking for the next game.
+ */
+uint16_t replayScript::load(uint16_t pos) {
+  uint8_t* d=Original.Data;
+  count=moves=0;
+  uint32_t t=0;
+  player=d[pos+4];
+  flags=d[pos+5];
+  firstMove=d[pos+6] | (d[pos+7] << 8);
+  pos+=JOURNAL_HEADER+d[pos+3];
+  while(pos+JOURNAL_HEADER <= Original.length) {
+    uint8_t k=d[pos];
+    uint8_t n=d[pos+3];
+    if(k==JOURNAL_START) {
+      return pos;
+    }
+    if(((k!=JOURNAL_SENT) && (k!=JOURNAL_RECEIVED)) || (n<3) || (pos+JOURNAL_HEADER+n > Original.length) ||
+        (count==REPLAY_RECORDS)) {
+      Serial.print("Journal damaged or game too long at byte "); Serial.println(pos);
+      if(pos+JOURNAL_HEADER+n > Original.length) {
+        return Original.length;   //the last record was cut short
+      }
+      if(count==0) {
+        return pos+1;
+      }
+      //Usually the record before was cut short and its length took in the start of the next game
+      count--;
+      if(basePacket::frameType(data(count))==MOVE_PACKET) {
+        moves--;
+      }
+      return offset[count]+1;
+    }
+    t+= d[pos+1] | (d[pos+2] << 8);
+    offset[count]=pos;
+    time[count]=t;
+    if(basePacket::frameType(d+pos+JOURNAL_HEADER)==MOVE_PACKET) {
+      moves++;
+    }
+    count++;
+    pos+=JOURNAL_HEADER+n;
+  }
+  return Original.length;
+}
+
+/*
+ * A move that is whatever the journal says it was.
+ */
+class replayMove : public baseMove {
+  public:
+    uint8_t Data[MAX_FRAME_SIZE];
+    uint8_t dataLen;
+    void fields(packetCodec& c) override {
+      baseMove::fields(c);
+      if(!c.writing) {
+        dataLen=Replay.extra(MOVE_PACKET,moveNum,c.len);
+      }
+      for(uint8_t i=0;i<dataLen;i++) {
+        c.field(Data[i]);
+      }
+    };
+    void decideMyMove(void) override {
+      if(!Replay.fill(this,MOVE_PACKET,moveNum)) {
+        subType=QUIT_MOVE;
+        dataLen=0;
+      }
+    };
+};
+
+/*
+ * Results that are whatever the journal says they were. Results that were never sent because they
+ * were predicted correctly must have been what the mover predicted.
+ */
+class replayResults : public baseResults {
+  public:
+    uint8_t Data[MAX_FRAME_SIZE];
+    uint8_t dataLen;
+    void fields(packetCodec& c) override {
+      baseResults::fields(c);
+      if(!c.writing) {
+        dataLen=Replay.extra(RESULTS_PACKET,resultsNum,c.len);
+      }
+      for(uint8_t i=0;i<dataLen;i++) {
+        c.field(Data[i]);
+      }
+    };
+    bool over(void) {return (subType==WIN_RESULTS) || (subType==LOSE_RESULTS) || (subType==TIE_RESULTS);};
+    bool processResults(void) override {return over();};
+    bool generateResults(baseMove* Move) override {
+      if(Move->withPrediction && (Replay.find(RESULTS_PACKET,Move->moveNum)<0)) {
+        return predictResults(Move);
+      }
+      if(!Replay.fill(this,RESULTS_PACKET,Move->moveNum)) {
+        return predictResults(Move);
+      }
+      return over();
+    };
+    bool predictResults(baseMove* Move) override {
+      resultsNum=Move->moveNum;
+      subType= Move->withPrediction ? Move->predicted : NORMAL_RESULTS;
+      dataLen=0;
+      return over();
+    };
+};
+
+/*
+ * Player 1 always offers and player 2 always seeks. Player 1 makes the coin come out the way
+ * it did originally.
+ */
+class replayGame : public baseGame {
+  public:
+    bool Finished;
+    bool first;     //player 1 moves first
+    replayGame(replayMove* move_ptr, replayResults* results_ptr, baseRadio* radio_ptr, bool isPlayer_1)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr, isPlayer_1) {first=true;};
+    bool playing(void) {return (gameState==MY_TURN) || (gameState==OPPONENTS_TURN);};
+    void initialize(void) override {
+      baseGame::initialize();
+      if(myPlayerNum==2) {
+        gameState=SEEKING_GAME;
+      }
+      Finished=false;
+    };
+    bool coinFlip(void) override {return first;};
+    void processGameOver(void) override {Finished=true;};
+    void fatalError(const char* s) override {
+      Serial.print("Fatal error: "); Serial.println(s);
+      gameState=GAME_OVER;
+    };
+};
+
+/*
+ * The demonstration game. Each move is a random square and the results say whether it was a hit.
+ * The game is over after DEMO_MOVES moves.
+ */
+class demoMove : public baseMove {
+  public:
+    uint8_t square;
+    void fields(packetCodec& c) override {baseMove::fields(c); c.field(square);};
+    void decideMyMove(void) override {delay(random(DEMO_THINK)); subType=NORMAL_MOVE; square=random(100);};
+};
+
+class demoResults : public baseResults {
+  public:
+    uint8_t square;
+    void fields(packetCodec& c) override {baseResults::fields(c); c.field(square);};
+    bool processResults(void) override {return subType==WIN_RESULTS;};
+    bool generateResults(baseMove* Move) override {return predictResults(Move);};
+    bool predictResults(baseMove* Move) override {
+      resultsNum=Move->moveNum;
+      square=((demoMove*)Move)->square;
+      if(Move->moveNum>=DEMO_MOVES) {
+        subType=WIN_RESULTS;
+      } else {
+        subType= (square % 3) ? MISS_RESULTS : HIT_RESULTS;
+      }
+      return subType==WIN_RESULTS;
+    };
+};
+
+class demoGame : public baseGame {
+  public:
+    bool Finished;
+    demoGame(demoMove* move_ptr, demoResults* results_ptr, baseRadio* radio_ptr, bool isPlayer_1)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr, isPlayer_1) {};
+    void initialize(void) override {
+      baseGame::initialize();
+      if(myPlayerNum==2) {
+        gameState=SEEKING_GAME;
+      }
+      Finished=false;
+    };
+    bool coinFlip(void) override {return random(2);};
+    void processGameOver(void) override {Finished=true;};
+    void fatalError(const char* s) override {
+      Serial.print("Fatal error: "); Serial.println(s);
+      gameState=GAME_OVER;
+    };
+};
+
+loopbackLink Link;
+LoopbackRadio Radio1(&Link);
+LoopbackRadio Radio2(&Link);
+replayMove Move1, Move2;
+replayResults Results1, Results2;
+replayGame Puppet1(&Move1, &Results1, &Radio1, true);
+replayGame Puppet2(&Move2, &Results2, &Radio2, false);
+demoMove DemoMove1, DemoMove2;
+demoResults DemoResults1, DemoResults2;
+demoGame Demo1(&DemoMove1, &DemoResults1, &Radio1, true);
+demoGame Demo2(&DemoMove2, &DemoResults2, &Radio2, false);
+
+/*
+ * Reads a journal from the serial port into Original. Returns false if nothing arrived.
+ */
+bool receiveJournal(void) {
+  uint32_t t=millis();
+  while(!Serial.available()) {
+    if((millis()-t) >= REPLAY_WAIT) {
+      return false;
+    }
+  }
+  t=millis();
+  while((millis()-t) < REPLAY_QUIET) {
+    while(Serial.available() && (Original.length < REPLAY_SIZE)) {
+      Original.Data[Original.length++]=Serial.read();
+      t=millis();
+    }
+  }
+  if(Original.length==REPLAY_SIZE) {
+    Serial.println("Journal too large. Only the beginning will be played back.");
+  }
+  return true;
+}
+
+/*
+ * Plays one demonstration game with player 1 keeping a journal in Original.
+ */
+void recordDemo(bool piggyback, bool perfect, bool hash) {
+  Demo1.piggybackResults=Demo2.piggybackResults=piggyback;
+  Demo1.perfectInformation=Demo2.perfectInformation=perfect;
+  Demo1.hashCheck=Demo2.hashCheck=hash;
+  Demo1.Journal=&Original;
+  Demo1.setup();
+  Demo2.setup();
+  while(!(Demo1.Finished && Demo2.Finished)) {
+    if(!Demo1.Finished) {
+      Demo1.step();
+      Demo1.idle();
+    }
+    if(!Demo2.Finished) {
+      Demo2.step();
+    }
+  }
+}
+
+/*
+ * Plays back the game in Replay. Returns the number of microseconds it took. If the journal ends 
+ * in the middle of the game, so does the replay.
+ */
+uint32_t playBack(bool realTime) {
+  replayGame& Keeper= (Replay.player==1) ? Puppet1 : Puppet2;
+  Puppet1.first= ((Replay.player==1) == ((Replay.flags & JOURNAL_MY_TURN) != 0));
+  Puppet1.piggybackResults=Puppet2.piggybackResults= (Replay.flags & JOURNAL_PIGGYBACK) != 0;
+  Puppet1.perfectInformation=Puppet2.perfectInformation= (Replay.flags & JOURNAL_PERFECT) != 0;
+  Puppet1.appAcks=Puppet2.appAcks= (Replay.flags & JOURNAL_APP_ACKS) != 0;
+  Puppet1.Journal=Puppet2.Journal=NULL;
+  Keeper.Journal=&Replayed;
+  Replayed.length=0;
+  Replay.realTime=realTime;
+  Replay.ranOut=false;
+  uint8_t buf[LOOPBACK_MAX_MESSAGE_LEN];
+  uint8_t n=sizeof(buf);
+  while(Radio1.recv(buf,&n) || Radio2.recv(buf,&n)) {
+    n=sizeof(buf);    //anything left over from a game that was cut short
+  }
+  Puppet1.setup();
+  Puppet2.setup();
+  while(!(Puppet1.playing() && Puppet2.playing())) {
+    if(!Puppet1.playing()) Puppet1.step();
+    if(!Puppet2.playing()) Puppet2.step();
+  }
+  Puppet1.currentMoveNum=Puppet2.currentMoveNum=Replay.firstMove;
+  Replay.startTime=millis();
+  uint32_t Limit= (Replay.count ? Replay.time[Replay.count-1] : 0) + REPLAY_TIMEOUT;
+  uint32_t StartTime=micros();
+  while(!(Puppet1.Finished && Puppet2.Finished) && !Replay.ranOut) {
+    if(!Puppet1.Finished) {
+      Puppet1.step();
+      Puppet1.idle();
+    }
+    if(!Puppet2.Finished) {
+      Puppet2.step();
+      Puppet2.idle();
+    }
+    if((millis()-Replay.startTime) > Limit) {
+      Serial.println("Replay took too long. Giving up.");
+      break;
+    }
+  }
+  uint32_t Elapsed=micros()-StartTime;
+  Replayed.flush();
+  return Elapsed;
+}
+
+/*
+ * Returns true if record "r" made by the puppet is the same as record "i" of the original.
+ */
+bool sameRecord(uint8_t* r, uint16_t i) {
+  return (r[0]==Replay.kind(i)) && (r[3]==Replay.len(i)) && !memcmp(r+JOURNAL_HEADER,Replay.data(i),r[3]);
+}
+
+/*
+ * Compares the packets the puppet recorded with the ones in the original journal and prints
+ * where they first differ. When packets were lost in the field, a repeat can arrive after 
+ * something that would normally have come later. The puppets never lose anything so that
+ * doesn't count as a difference as long as the packet itself is somewhere in the original.
+ */
+void compareGame(void) {
+  uint16_t pos=0, i=0, Reordered=0, First=0;
+  while((i < Replay.count) && (pos+JOURNAL_HEADER <= Replayed.length)) {
+    uint8_t* r=Replayed.Data+pos;
+    pos+=JOURNAL_HEADER+r[3];
+    if(r[0]==JOURNAL_START) {
+      continue;
+    }
+    if(!sameRecord(r,i)) {
+      bool found=false;
+      for(uint16_t j=0; (j<Replay.count) && !found; j++) {
+        found=sameRecord(r,j);
+      }
+      if(!found) {
+        Serial.print("  replay differs at packet "); Serial.print(i+1); Serial.print(" of ");
+        Serial.println(Replay.count);
+        return;
+      }
+      if(Reordered++ == 0) {
+        First=i;
+      }
+    }
+    i++;
+  }
+  if(i < Replay.count) {
+    Serial.print("  replay stopped at packet "); Serial.print(i+1); Serial.print(" of ");
+    Serial.println(Replay.count);
+    return;
+  }
+  Serial.print("  replay matches");
+  if(Reordered) {
+    Serial.print(" but "); Serial.print(Reordered); Serial.print(" packets were in a different order from packet ");
+    Serial.print(First+1); Serial.print(" on");
+  }
+  Serial.println(Replay.ranOut ? " and the journal ends before the game did" : "");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) { delay(1); }
+  Radio1.setup(1,2);
+  Radio2.setup(2,1);
+  Serial.println("Journal replay");
+  if(!receiveJournal()) {
+    Serial.println("No journal received. Recording demonstration games.");
+    recordDemo(false, false, false);
+    recordDemo(true, false, false);
+    recordDemo(false, true, false);
+    recordDemo(true, false, true);
+  }
+  Serial.print("Journal bytes="); Serial.println(Original.length);
+  uint16_t pos=0;
+  uint16_t Games=0;
+  while(pos+JOURNAL_HEADER+4 <= Original.length) {
+    if(!Replay.startsAt(pos)) {
+      pos++;    //skip anything that isn't the start of a game such as the rest of a damaged one
+      continue;
+    }
+    pos=Replay.load(pos);
+    Games++;
+    Serial.print("Game "); Serial.print(Games); Serial.print(" player="); Serial.print(Replay.player);
+    Serial.print(" moves="); Serial.print(Replay.moves); Serial.print(" packets="); Serial.print(Replay.count);
+    if(Replay.flags & JOURNAL_PIGGYBACK) Serial.print(" piggyback");
+    if(Replay.flags & JOURNAL_PERFECT)   Serial.print(" perfect information");
+    if(Replay.flags & JOURNAL_HASH)      Serial.print(" hash check");
+    if(Replay.flags & JOURNAL_APP_ACKS)  Serial.print(" app acks");
+    if(Replay.flags & JOURNAL_RESUMED)   Serial.print(" resumed");
+    Serial.println();
+    uint32_t Elapsed=playBack(false);
+    Serial.print("  fastest usec="); Serial.print(Elapsed);
+    Serial.print("  usec/move="); Serial.println(Replay.moves ? (float)Elapsed/Replay.moves : 0);
+    compareGame();
+    #if(RECORDED_SPEED)
+      Elapsed=playBack(true);
+      Serial.print("  recorded speed msec="); Serial.print(Elapsed/1000);
+      Serial.print("  originally msec="); Serial.println(Replay.count ? Replay.time[Replay.count-1] : 0);
+      compareGame();
+    #endif
+  }
+}
+
+void loop() {
+}
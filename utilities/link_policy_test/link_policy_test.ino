@@ -0,0 +1,283 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility tests linkPolicy from "TwoPlayerGame_link_policy.h" and baseGame's adaptiveLink
+ * without any radio hardware. The loopbackLink pretends to offer 3 modulations and 4 power
+ * levels, a ladder of 6 profiles with profile 2 as home. There are three parts:
+ *
+ *    policy      Feeds made up numbers to decide, and made up radioStats to evaluate, and checks
+ *                each answer. It must climb only after LINK_UP_WINDOWS good windows in a row,
+ *                step down at once on a failed ack, too many retries or a weak signal, stay put
+ *                in between, and never go off either end of the ladder.
+ *    handshake   Plays a game between two game objects with adaptiveLink on. The signal starts
+ *                strong so player 1 should climb to the highest profile still strong enough, and
+ *                player 2 must follow each LINK_PROFILE_PACKET. Halfway through, the signal gets
+ *                weak so they must step all the way down, changing modulation on the way. If the
+ *                two ever disagreed on a modulation they would stop hearing each other.
+ *    recovery    Plays another game and, in the middle of it, moves player 2 to another
+ *                modulation as if it had switched but player 1 never got the acknowledgment.
+ *                Player 1 goes home and keeps resending its move one step at a time while
+ *                player 2's silence timeout brings it home too. Takes about 15 seconds.
+ *
+ * Every game must still finish with both players agreeing on the game. Results are printed on the
+ * serial monitor. It runs on any board. No radio wing is needed.
+ */
+#include <TwoPlayerGame.h>
+#include <TwoPlayerGame_loopback.h>
+
+//Number of moves after which each test game is declared over
+#define GAME_MOVES 200
+
+//Signal strengths in dBm used by the handshake test
+#define RSSI_STRONG -50
+#define RSSI_WEAK   -88
+
+uint32_t Failures;
+
+/*
+ * Prints a check that failed and counts it
+ */
+void check(const char* name, bool ok) {
+  if(!ok) {
+    Serial.print("  FAILED: "); Serial.println(name);
+    Failures++;
+  }
+}
+
+/*
+ * A move that makes itself and results that add up every move so that both players must have
+ * the same total at the end. Same as "utilities/loopback_benchmark".
+ */
+class testMove : public baseMove {
+  public:
+    uint8_t value;
+    void fields(packetCodec& c) override {baseMove::fields(c); c.field(value);};
+    void decideMyMove(void) override {subType=NORMAL_MOVE; value=moveNum;};
+};
+
+class testResults : public baseResults {
+  public:
+    uint32_t Sum;
+    bool processResults(void) override {Sum+=resultsNum; return subType==WIN_RESULTS;};
+    bool generateResults(baseMove* Move) override {Sum+=Move->moveNum; return predictResults(Move);};
+    bool predictResults(baseMove* Move) override {
+      resultsNum=Move->moveNum;
+      subType=(Move->moveNum>=GAME_MOVES) ? WIN_RESULTS : NORMAL_RESULTS;
+      return subType==WIN_RESULTS;
+    };
+};
+
+/*
+ * Player 1 always offers and player 2 always seeks. The offering player wins the coin toss.
+ */
+class testGame : public baseGame {
+  public:
+    bool Finished;
+    bool myTurn(void) {return gameState == MY_TURN;};
+    testGame(testMove* move_ptr, testResults* results_ptr, baseRadio* radio_ptr, bool isPlayer_1)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr, isPlayer_1) {
+          adaptiveLink=true;
+        };
+    void initialize(void) override {
+      baseGame::initialize();
+      if(myPlayerNum==2) {
+        gameState=SEEKING_GAME;
+      }
+      Finished=false;
+      ((testResults*)Results)->Sum=0;
+    };
+    bool coinFlip(void) override {return true;};
+    void processGameOver(void) override {Finished=true;};
+    void fatalError(const char* s) override {
+      Serial.print("  Fatal error: "); Serial.println(s);
+      Failures++;
+      gameState=GAME_OVER;
+    };
+};
+
+loopbackLink Link;
+LoopbackRadio Radio1(&Link);
+LoopbackRadio Radio2(&Link);
+testMove Move1, Move2;
+testResults Results1, Results2;
+testGame Game1(&Move1, &Results1, &Radio1, true);
+testGame Game2(&Move2, &Results2, &Radio2, false);
+
+/*
+ * Checks the decisions of a policy of our own on Radio1 given made up numbers.
+ */
+void testPolicy(void) {
+  linkPolicy P;
+  Radio1.setup(1,2);
+  P.begin(&Radio1);
+  Serial.println("Policy decisions");
+  check("6 profiles", P.profiles==6);
+  check("home is profile 2", (P.home==2) && (P.current==2));
+  check("no packets, no change", P.decide(-50,0,0,0)==2);
+  check("good window 1 waits", P.decide(-50,20,0,0)==2);
+  check("good window 2 waits", P.decide(-50,20,0,0)==2);
+  check("good window 3 climbs", P.decide(-50,20,0,0)==3);
+  check("apply profile 3", P.apply(3) && (P.current==3));
+  check("profile 3 is fastest modulation", Link.Modulation[0]==0);
+  check("profile 3 is power level 1", Link.Power[0]==1);
+  P.decide(-50,20,0,0);
+  P.decide(-50,20,0,0);
+  check("middling signal stays", P.decide(-70,20,0,0)==3);
+  P.decide(-50,20,0,0);
+  check("good windows start over", P.decide(-50,20,0,0)==3);
+  check("then climb", P.decide(-50,20,0,0)==4);
+  P.decide(-50,20,0,0);
+  check("middling retries stay", P.decide(-50,20,2,0)==3);
+  check("good windows start over again", P.decide(-50,20,0,0)==3);
+  check("failed ack steps down", P.decide(-50,20,0,1)==2);
+  check("many retries step down", P.decide(-50,20,5,0)==2);
+  check("weak signal steps down", P.decide(-85,20,0,0)==2);
+  P.decide(0,20,0,0);
+  P.decide(0,20,0,0);
+  check("no signal strength climbs on retries alone", P.decide(0,20,0,0)==4);
+  check("apply top profile", P.apply(5));
+  P.decide(-50,20,0,0);
+  P.decide(-50,20,0,0);
+  check("never above the top", P.decide(-50,20,0,0)==5);
+  check("apply bottom profile", P.apply(0));
+  check("profile 0 is slowest modulation", (Link.Modulation[0]==2) && (Link.Power[0]==0));
+  check("never below the bottom", P.decide(-95,20,0,1)==0);
+  check("no such profile", !P.apply(6) && (P.current==0));
+  P.reset();
+  check("reset goes home", (P.current==2) && (Link.Modulation[0]==0) && (Link.Power[0]==0));
+
+  //The same through evaluate. Each call must only look at what was counted since the last one.
+  radioStats& S=Radio1.Stats;
+  for(uint8_t w=0;w<3;w++) {
+    for(uint8_t i=0;i<20;i++) {
+      S.countSend(10,1000,true);
+      S.countRssi(-50);
+    }
+    check("evaluate good windows", P.evaluate(S)==((w==2) ? 3 : 2));
+  }
+  P.apply(3);
+  check("evaluate empty window", P.evaluate(S)==3);
+  for(uint8_t i=0;i<20;i++) {
+    S.countSend(10,1000,true);
+    S.countRssi(-90);
+  }
+  check("evaluate weak window after strong ones", P.evaluate(S)==2);
+  P.apply(2);
+  for(uint8_t i=0;i<20;i++) {
+    S.countSend(10,1000,i!=7);
+    S.countRssi(-50);
+  }
+  check("evaluate failed ack", P.evaluate(S)==1);
+  for(uint8_t i=0;i<20;i++) {
+    S.countSend(10,1000,true);
+    S.countRssi(-50);
+  }
+  S.countRetries(10);
+  check("evaluate retries", P.evaluate(S)==1);
+  P.reset();
+}
+
+/*
+ * Starts a new game between Game1 and Game2 with nothing left over from the last one.
+ */
+void startGame(void) {
+  uint8_t buf[LOOPBACK_MAX_MESSAGE_LEN];
+  uint8_t n=sizeof(buf);
+  while(Radio1.recv(buf,&n) || Radio2.recv(buf,&n)) {
+    n=sizeof(buf);
+  }
+  Game1.setup();
+  Game2.setup();
+  Radio1.Stats.reset();
+  Radio2.Stats.reset();
+  Game1.currentMoveNum=Game2.currentMoveNum=0;
+}
+
+/*
+ * Checks that a game ended properly with both players on the same settings.
+ */
+void checkGame(void) {
+  uint32_t Expected=(uint32_t)GAME_MOVES*(GAME_MOVES+1)/2;
+  check("both players agree on the game", (Results1.Sum==Expected) && (Results2.Sum==Expected));
+  check("both players on the same profile", Game1.Policy.current==Game2.Policy.current);
+  check("both radios on the same settings",
+        (Link.Modulation[0]==Link.Modulation[1]) && (Link.Power[0]==Link.Power[1]));
+}
+
+void testHandshake(void) {
+  Serial.println("Profile handshake");
+  Link.rssi=RSSI_STRONG;
+  startGame();
+  uint8_t Changes=0, Highest=0, Last=Game1.Policy.current;
+  bool Weakened=false;
+  while(!(Game1.Finished && Game2.Finished)) {
+    if(!Game1.Finished) Game1.step();
+    if(!Game2.Finished) Game2.step();
+    if(Game1.Policy.current!=Last) {
+      Last=Game1.Policy.current;
+      Changes++;
+    }
+    if(!Weakened && (Game1.currentMoveNum>=GAME_MOVES/2)) {
+      Weakened=true;
+      Highest=Game2.Policy.current;
+      Link.rssi=RSSI_WEAK;
+    }
+  }
+  Serial.print("  profile changes="); Serial.print(Changes);
+  Serial.print("  highest reached="); Serial.print(Highest);
+  Serial.print("  final="); Serial.println(Game1.Policy.current);
+  //Power level 1 is still strong, level 2 isn't. At full power the weak signal is too weak.
+  check("player 2 followed player 1 up to profile 4", Highest==4);
+  check("stepped all the way down", Game1.Policy.current==0);
+  checkGame();
+  Link.rssi=0;
+}
+
+void testRecovery(void) {
+  Serial.println("Recovery from different profiles");
+  startGame();
+  uint32_t StartTime=0, Elapsed=0;
+  uint16_t StuckAt=0;
+  while(!(Game1.Finished && Game2.Finished)) {
+    if(!Game1.Finished) Game1.step();
+    if(!Game2.Finished) Game2.step();
+    if((StuckAt==0) && (Game1.currentMoveNum>=GAME_MOVES/2) && Game1.myTurn()) {
+      StuckAt=Game1.currentMoveNum;
+      Game2.Policy.apply(0);    //a switch player 1 never heard about
+      StartTime=millis();
+    }
+    if(StuckAt && !Elapsed && (Game2.currentMoveNum>StuckAt+1)) {
+      Elapsed=millis()-StartTime;
+    }
+  }
+  Serial.print("  moves resumed after msec="); Serial.println(Elapsed);
+  check("game resumed", Elapsed>0);
+  checkGame();
+}
+
+void setup() {
+  Serial.begin(115200); while (!Serial) {delay(1);};
+  Serial.println("Link policy test");
+  Failures=0;
+  Link.modulations=3;
+  Link.powerLevels=4;
+  testPolicy();
+  testHandshake();
+  testRecovery();
+  if(Failures) {
+    Serial.print(Failures); Serial.println(" checks FAILED!");
+  } else {
+    Serial.println("All checks passed.");
+  }
+}
+
+void loop() {
+}
@@ -0,0 +1,488 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility measures the speed of the game engine itself when there is no actual radio
+ * involved. Two LoopbackRadio objects share a single loopbackLink. First we bounce a packet
+ * back and forth through the baseRadio interface as fast as possible. Then we create two
+ * complete game objects, one for each player, and play an entire game between them in a
+ * single program using Game.step() so that neither player ever waits on the other. The game
+ * is played several ways: normally, with piggybackResults turned on, with perfectInformation
+ * turned on, and with appAcks turned on both with and without lost packets.
+ * Finally we create a second pair of game objects that decide who is player 1 at runtime and
+ * measure how long they take to find each other when both start at exactly the same moment.
+ * Last we turn on heartbeats, stop one player in the middle of a game as if its battery died,
+ * and measure how long the other one takes to notice. Then we turn on resync and hashCheck and 
+ * make one player forget some of the game over and over, measuring how long the two take to get 
+ * back in step. That is done once with a wrong move number and once with only a wrong game state.
+ * Finally we give each player a store in memory, reset them in the middle of a game as if the power 
+ * had failed, and measure how long they take to pick the game back up.
+ * Results are printed on the serial monitor. No radio wing is needed.
+ */
+#include <TwoPlayerGame.h>
+#include <TwoPlayerGame_loopback.h>
+
+//Number of round trips in each raw packet test
+#define ROUND_TRIPS 10000
+
+//Number of moves after which the benchmark game is declared over
+#define GAME_MOVES 1000
+
+//Number of simultaneous starts in each discovery test
+#define MATCHES 200
+
+//Heartbeat settings in milliseconds and number of trials for the lost opponent test
+#define LOST_INTERVAL 100
+#define LOST_DEADLINE 500
+#define LOST_TRIALS   10
+
+//Moves between each time we make a player forget part of the game in the resync test
+#define DESYNC_EVERY 50
+
+//Moves between each time we reset a player in the resume test
+#define RESET_EVERY 50
+
+/*
+ * A move that makes itself. There is nothing to decide.
+ */
+class benchMove : public baseMove {
+  public:
+    uint8_t value;
+    void fields(packetCodec& c) override {baseMove::fields(c); c.field(value);};
+    void decideMyMove(void) override {subType=NORMAL_MOVE; value=moveNum;};
+};
+
+/*
+ * Every move is a normal move until we reach GAME_MOVES and then the mover wins. Every move either 
+ * player handles is added to Sum so that at the end of the game both must have the same total.
+ * The move numbers themselves are the features of the Hash.
+ */
+class benchResults : public baseResults {
+  public:
+    uint32_t Sum;
+    zobristHash Hash;
+    bool processResults(void) override {
+      Sum+=resultsNum; Hash.toggle(resultsNum); return subType==WIN_RESULTS;
+    };
+    bool generateResults(baseMove* Move) override {
+      Sum+=Move->moveNum; Hash.toggle(Move->moveNum); return predictResults(Move);
+    };
+    bool predictResults(baseMove* Move) override {
+      resultsNum=Move->moveNum;
+      subType=(Move->moveNum>=GAME_MOVES) ? WIN_RESULTS : NORMAL_RESULTS;
+      return subType==WIN_RESULTS;
+    };
+};
+
+/*
+ * With fixed player numbers, player 1 always offers and player 2 always seeks so that we never 
+ * have to wait on an offering timeout. The offering player always wins the coin toss.
+ * The whole state of the game is the Sum and Hash in our results so they are our snapshot.
+ */
+class benchGame : public baseGame {
+  public:
+    bool Finished;
+    bool Lost;
+    uint16_t Restores;
+    uint32_t RestoredAt;  //micros() of the last restore
+    uint16_t Resumes;
+    benchGame(benchMove* move_ptr, benchResults* results_ptr, baseRadio* radio_ptr)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr) {};
+    benchGame(benchMove* move_ptr, benchResults* results_ptr, baseRadio* radio_ptr, bool isPlayer_1)
+        : baseGame((baseMove*)move_ptr, (baseResults*)results_ptr, radio_ptr, isPlayer_1) {};
+    bool matched(void) {return gameState != OFFERING_GAME;};
+    bool waiting(void) {return gameState == OPPONENTS_TURN;};
+    void initialize(void) override {
+      baseGame::initialize();
+      if(myPlayerNum==2) {
+        gameState=SEEKING_GAME;
+      }
+      Finished=false;
+      Lost=false;
+      Restores=0;
+      Resumes=0;
+      ((benchResults*)Results)->Sum=0;
+      ((benchResults*)Results)->Hash.reset();
+    };
+    uint32_t stateHash(void) override {return ((benchResults*)Results)->Hash.value;};
+    void snapshot(packetCodec& c) override {
+      c.field(((benchResults*)Results)->Sum); c.field(((benchResults*)Results)->Hash.value);
+    };
+    bool restore(packetCodec& c) override {
+      uint32_t s=0, h=0;
+      c.field(s); c.field(h);
+      if(!c.ok) {
+        return false;
+      }
+      ((benchResults*)Results)->Sum=s;
+      ((benchResults*)Results)->Hash.value=h;
+      Restores++;
+      RestoredAt=micros();
+      return true;
+    };
+    void persist(packetCodec& c) override {snapshot(c);};
+    bool resume(packetCodec& c) override {
+      Resumes++;
+      return restore(c);
+    };
+    bool coinFlip(void) override {return true;};
+    void processGameOver(void) override {Finished=true;};
+    void processOpponentLost(void) override {Lost=true;};
+    void fatalError(const char* s) override {
+      Serial.print("Fatal error: "); Serial.println(s);
+      gameState=GAME_OVER;
+    };
+};
+
+/*
+ * A store that keeps its slots in RAM. It survives our pretend resets because they don't really 
+ * restart the program.
+ */
+class memoryStore : public baseStore {
+  public:
+    uint8_t Slots[STORE_SLOTS][STORE_SLOT_SIZE];
+    memoryStore(void) {memset(Slots,0,sizeof(Slots));};
+    bool begin(void) override {return true;};
+    bool readSlot(uint8_t slot, uint8_t* buf) override {memcpy(buf,Slots[slot],STORE_SLOT_SIZE); return true;};
+    bool writeSlot(uint8_t slot, const uint8_t* buf) override {memcpy(Slots[slot],buf,STORE_SLOT_SIZE); return true;};
+};
+
+loopbackLink Link;
+LoopbackRadio Radio1(&Link);
+LoopbackRadio Radio2(&Link);
+benchMove Move1, Move2;
+benchResults Results1, Results2;
+benchGame Game1(&Move1, &Results1, &Radio1, true);
+benchGame Game2(&Move2, &Results2, &Radio2, false);
+//Same thing but the player numbers are decided at runtime
+benchGame Match1(&Move1, &Results1, &Radio1);
+benchGame Match2(&Move2, &Results2, &Radio2);
+memoryStore Store1, Store2;
+
+uint8_t buf[LOOPBACK_MAX_MESSAGE_LEN];
+
+/*
+ * Sends "len" bytes from one radio to the other and back again ROUND_TRIPS times.
+ * Prints packets per second and the average round trip time.
+ */
+void pingPong(uint8_t len) {
+  uint32_t StartTime=micros();
+  for(uint32_t i=0;i<ROUND_TRIPS;i++) {
+    uint8_t n=sizeof(buf);
+    buf[0]=i;
+    if(!Radio1.send(buf,len) || !Radio2.recv(buf,&n) ||
+       !Radio2.send(buf,n)   || !Radio1.recv(buf,&n)) {
+      Serial.println("Packet lost!");
+      return;
+    }
+  }
+  uint32_t Elapsed=micros()-StartTime;
+  Serial.print("Payload="); Serial.print(len);
+  Serial.print(" bytes  packets/sec="); Serial.print((uint32_t)(2.0*ROUND_TRIPS*1000000.0/Elapsed));
+  Serial.print("  round trip usec="); Serial.println((float)Elapsed/ROUND_TRIPS);
+}
+
+/*
+ * Plays one complete game between Game1 and Game2 by stepping each of them in turn.
+ * Prints the time per move and the packet rate of the engine. Packets sent with appAcks
+ * are lost "drop" percent of the time. Once the game is under way, "fail" percent of
+ * packets sent with link-level acknowledgments are never acknowledged. Half of them arrive.
+ */
+void playGame(const char* name, bool piggyback, bool perfect, bool acks=false, uint8_t drop=0, uint8_t fail=0) {
+  Game1.piggybackResults=Game2.piggybackResults=piggyback;
+  Game1.perfectInformation=Game2.perfectInformation=perfect;
+  Game1.appAcks=Game2.appAcks=acks;
+  Link.dropPercent=drop;
+  Game1.setup();
+  Game2.setup();
+  Radio1.Stats.reset();
+  Radio2.Stats.reset();
+  uint32_t StartTime=micros();
+  while(!(Game1.Finished && Game2.Finished)) {
+    if(!Game1.Finished) Game1.step();
+    if(!Game2.Finished) Game2.step();
+    if(Game1.currentMoveNum>1) {
+      Link.failPercent=fail;    //not during the handshake which can't recover
+    }
+  }
+  Link.failPercent=0;
+  uint32_t Elapsed=micros()-StartTime;
+  uint32_t Packets=Radio1.Stats.sent+Radio1.Stats.sentNoAck+Radio2.Stats.sent+Radio2.Stats.sentNoAck;
+  Serial.print(name); Serial.print(" game of "); Serial.print(Game1.currentMoveNum-1);
+  Serial.print(" moves took usec="); Serial.print(Elapsed);
+  Serial.print("  usec/move="); Serial.print((float)Elapsed/(Game1.currentMoveNum-1));
+  Serial.print("  packets="); Serial.print(Packets);
+  Serial.print("  packets/sec="); Serial.println((uint32_t)(Packets*1000000.0/Elapsed));
+}
+
+/*
+ * Starts Match1 and Match2 at the same moment MATCHES times and measures how long it takes until
+ * both have found each other and the coin toss has been delivered. Packets are lost "drop"
+ * percent of the time. Prints the average and worst case time and the average number of packets.
+ */
+void matchGames(uint8_t drop) {
+  uint32_t Total=0, Worst=0, Packets=0;
+  Link.dropPercent=drop;
+  for(uint16_t i=0;i<MATCHES;i++) {
+    uint8_t n=sizeof(buf);
+    while(Radio1.recv(buf,&n) || Radio2.recv(buf,&n)) {
+      n=sizeof(buf);    //throw away anything left over from last time
+    }
+    Radio1.Stats.reset();
+    Radio2.Stats.reset();
+    Match1.deviceId=Match2.deviceId=0;  //new IDs every time
+    uint32_t StartTime=micros();
+    Match1.setup();
+    Match2.setup();
+    while(!(Match1.matched() && Match2.matched())) {
+      if(!Match1.matched()) Match1.step();
+      if(!Match2.matched()) Match2.step();
+    }
+    uint32_t Elapsed=micros()-StartTime;
+    Total+=Elapsed;
+    if(Elapsed>Worst) Worst=Elapsed;
+    Packets+=Radio1.Stats.sent+Radio1.Stats.sentNoAck+Radio2.Stats.sent+Radio2.Stats.sentNoAck;
+  }
+  Serial.print("Discovery with "); Serial.print(drop);
+  Serial.print("% loss  average msec="); Serial.print(Total/1000.0/MATCHES);
+  Serial.print("  worst msec="); Serial.print(Worst/1000.0);
+  Serial.print("  packets="); Serial.println((float)Packets/MATCHES);
+}
+
+/*
+ * Plays Game1 against Game2 with heartbeats on for a few moves and then stops stepping Game2.
+ * Each trial stops one move later than the last so that Game1 is sometimes waiting for a move
+ * and sometimes waiting for results. Prints how long Game1 took to give up.
+ */
+void loseOpponent(void) {
+  uint32_t Total=0, Worst=0;
+  Game1.piggybackResults=Game2.piggybackResults=false;
+  Game1.perfectInformation=Game2.perfectInformation=false;
+  Game1.appAcks=Game2.appAcks=false;
+  Game1.heartbeats=Game2.heartbeats=true;
+  Game1.heartbeatInterval=Game2.heartbeatInterval=LOST_INTERVAL;
+  Game1.livenessDeadline=Game2.livenessDeadline=LOST_DEADLINE;
+  Link.dropPercent=0;
+  for(uint8_t i=0;i<LOST_TRIALS;i++) {
+    uint8_t n=sizeof(buf);
+    while(Radio1.recv(buf,&n) || Radio2.recv(buf,&n)) {
+      n=sizeof(buf);    //throw away anything left over from last time
+    }
+    Game1.setup();
+    Game2.setup();
+    Game1.currentMoveNum=0;   //left over from the last trial until the new game starts
+    while(Game1.currentMoveNum < 10+i) {
+      Game1.step();
+      Game2.step();
+      if(Game1.Lost || Game2.Lost) {
+        Serial.println("Opponent lost while still playing!");
+        return;
+      }
+    }
+    uint32_t StartTime=millis();
+    while(!Game1.Lost && !Game1.Finished) {
+      Game1.step();
+    }
+    uint32_t Elapsed=millis()-StartTime;
+    if(!Game1.Lost) {
+      Serial.println("Game ended without noticing the lost opponent!");
+      return;
+    }
+    Total+=Elapsed;
+    if(Elapsed>Worst) Worst=Elapsed;
+  }
+  Game1.heartbeats=Game2.heartbeats=false;
+  Serial.print("Deadline msec="); Serial.print(LOST_DEADLINE);
+  Serial.print("  detected after average msec="); Serial.print((float)Total/LOST_TRIALS);
+  Serial.print("  worst msec="); Serial.print(Worst);
+  Serial.print("  heartbeats sent="); Serial.println(Radio1.Stats.heartbeatsSent);
+}
+
+/*
+ * Plays Game1 against Game2 with resync and hashCheck on. Every DESYNC_EVERY moves, while one of 
+ * them waits for a move, its Sum and Hash are spoiled as if it had been restored from an old copy. 
+ * If "forget" is true it is Game1 and it also forgets the last three moves. Otherwise it is Game2
+ * and only the hash gives it away. When the move numbers agree player 1 is trusted, so it has to
+ * be player 2 that goes wrong. The two must resync and still finish with the correct Sum. Prints
+ * the number of resyncs and the average time from the desync until a snapshot had been restored.
+ */
+void desyncGame(const char* name, bool forget, bool piggyback, bool perfect, bool acks=false) {
+  uint32_t Total=0;
+  uint16_t Desyncs=0;
+  uint16_t Next=DESYNC_EVERY;
+  benchGame& Victim= forget ? Game1 : Game2;
+  benchResults& VictimResults= forget ? Results1 : Results2;
+  Game1.piggybackResults=Game2.piggybackResults=piggyback;
+  Game1.perfectInformation=Game2.perfectInformation=perfect;
+  Game1.appAcks=Game2.appAcks=acks;
+  Game1.resync=Game2.resync=true;
+  Game1.hashCheck=Game2.hashCheck=true;
+  Link.dropPercent=0;
+  Game1.setup();
+  Game2.setup();
+  Game1.currentMoveNum=Game2.currentMoveNum=0;   //left over from the last game until the new game starts
+  uint32_t StartTime=0;
+  while(!(Game1.Finished && Game2.Finished)) {
+    if(!Game1.Finished) Game1.step();
+    if(!Game2.Finished) Game2.step();
+    if(Victim.Restores>Desyncs) {
+      Desyncs=Victim.Restores;
+      Total+=Victim.RestoredAt-StartTime;
+    }
+    if((Victim.Restores==Desyncs) && (Victim.currentMoveNum>=Next) && (Next<GAME_MOVES) && Victim.waiting()) {
+      Next+=DESYNC_EVERY;
+      if(forget) {
+        Victim.currentMoveNum-=3;
+      }
+      VictimResults.Sum+=12345;
+      VictimResults.Hash.toggle(12345);
+      StartTime=micros();
+    }
+  }
+  Game1.resync=Game2.resync=false;
+  Game1.hashCheck=Game2.hashCheck=false;
+  uint32_t Expected=(uint32_t)GAME_MOVES*(GAME_MOVES+1)/2;
+  Serial.print(name); Serial.print(" resyncs="); Serial.print(Desyncs);
+  Serial.print("  average usec="); Serial.print(Desyncs ? (float)Total/Desyncs : 0);
+  if((Results1.Sum==Expected) && (Results2.Sum==Expected)) {
+    Serial.println("  game state agrees");
+  } else {
+    Serial.print("  game state DISAGREES "); Serial.print(Results1.Sum); 
+    Serial.print(" "); Serial.println(Results2.Sum);
+  }
+}
+
+/*
+ * Pretends that "Victim" lost power. Everything it was holding in memory is spoiled, anything its
+ * radio had received is lost, and it starts again with setup. Returns true if it resumed the game.
+ */
+bool resetPlayer(benchGame& Victim, benchMove& VictimMove, benchResults& VictimResults, LoopbackRadio& VictimRadio) {
+  uint8_t n=sizeof(buf);
+  while(VictimRadio.recv(buf,&n)) {
+    n=sizeof(buf);
+  }
+  VictimResults.Sum=12345;
+  VictimResults.Hash.toggle(12345);
+  VictimMove.moveNum=VictimResults.resultsNum=0;
+  Victim.currentMoveNum=0;
+  uint16_t Before=Victim.Resumes;
+  Victim.setup();
+  return Victim.Resumes != Before;
+}
+
+/*
+ * Plays Game1 against Game2 with a store for each. Every RESET_EVERY moves we reset Game1, then 
+ * Game2, then both at once, wherever they happen to be in their turn. They must pick the game up
+ * from their stores, resync, and still finish with the correct Sum. Prints the number of resets and
+ * the average and worst time from the reset until the reset player had handled one more move.
+ */
+void resetGame(const char* name, bool piggyback, bool perfect, bool acks=false) {
+  uint32_t Total=0, Worst=0, StartTime=0;
+  uint16_t Resets=0, Resumes=0, Next=RESET_EVERY, Goal=0;
+  uint8_t Who=0;
+  Game1.piggybackResults=Game2.piggybackResults=piggyback;
+  Game1.perfectInformation=Game2.perfectInformation=perfect;
+  Game1.appAcks=Game2.appAcks=acks;
+  Game1.resync=Game2.resync=true;
+  Game1.hashCheck=Game2.hashCheck=true;
+  Game1.Store=&Store1;
+  Game2.Store=&Store2;
+  Link.dropPercent=0;
+  Game1.setup();
+  Game2.setup();
+  Game1.currentMoveNum=Game2.currentMoveNum=0;   //left over from the last game until the new game starts
+  while(!(Game1.Finished && Game2.Finished)) {
+    if(!Game1.Finished) Game1.step();
+    if(!Game2.Finished) Game2.step();
+    if(Goal && (Game1.currentMoveNum>Goal) && (Game2.currentMoveNum>Goal)) {
+      uint32_t Elapsed=micros()-StartTime;
+      Total+=Elapsed;
+      if(Elapsed>Worst) Worst=Elapsed;
+      Goal=0;
+    }
+    if((Goal==0) && (Game1.currentMoveNum>=Next) && (Next<GAME_MOVES)) {
+      Next+=RESET_EVERY;
+      Goal=Game1.currentMoveNum;
+      StartTime=micros();
+      if(Who!=1) {
+        Resumes+=resetPlayer(Game1,Move1,Results1,Radio1);
+      }
+      if(Who!=0) {
+        Resumes+=resetPlayer(Game2,Move2,Results2,Radio2);
+      }
+      Resets++;
+      Who=(Who+1) % 3;
+    }
+  }
+  Game1.resync=Game2.resync=false;
+  Game1.hashCheck=Game2.hashCheck=false;
+  Game1.Store=Game2.Store=NULL;
+  uint32_t Expected=(uint32_t)GAME_MOVES*(GAME_MOVES+1)/2;
+  Serial.print(name); Serial.print(" resets="); Serial.print(Resets);
+  Serial.print(" resumed="); Serial.print(Resumes);
+  Serial.print("  average usec="); Serial.print(Resets ? (float)Total/Resets : 0);
+  Serial.print("  worst usec="); Serial.print(Worst);
+  if((Results1.Sum==Expected) && (Results2.Sum==Expected)) {
+    Serial.println("  game state agrees");
+  } else {
+    Serial.print("  game state DISAGREES "); Serial.print(Results1.Sum); 
+    Serial.print(" "); Serial.println(Results2.Sum);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) { delay(1); }
+  Radio1.setup(1,2);
+  Radio2.setup(2,1);
+  Serial.println("Loopback radio benchmark");
+  for(uint8_t len=4;len<=LOOPBACK_MAX_MESSAGE_LEN;len*=2) {
+    pingPong(len);
+  }
+  pingPong(LOOPBACK_MAX_MESSAGE_LEN);
+  Radio1.Stats.print();
+  Serial.println("Loopback game engine benchmark");
+  for(uint8_t i=0;i<3;i++) {
+    playGame("Normal", false, false);
+    playGame("Piggyback", true, false);
+    playGame("Perfect information", false, true);
+    playGame("App acks", false, false, true);
+  }
+  //Every lost packet costs at least one retransmission timeout so these are slow and only played once
+  playGame("App acks 1% loss", false, false, true, 1);
+  playGame("App acks piggyback 1% loss", true, false, true, 1);
+  playGame("App acks perfect information 1% loss", false, true, true, 1);
+  playGame("Normal 5% unacknowledged", false, false, false, 0, 5);
+  playGame("Piggyback 5% unacknowledged", true, false, false, 0, 5);
+  playGame("Perfect information 5% unacknowledged", false, true, false, 0, 5);
+  Serial.println("Time to match after a simultaneous start");
+  matchGames(0);
+  matchGames(10);
+  matchGames(30);
+  Serial.println("Time to notice a lost opponent");
+  loseOpponent();
+  Serial.println("Time to resync after a desync");
+  desyncGame("Wrong move number normal", true, false, false);
+  desyncGame("Wrong move number piggyback", true, true, false);
+  desyncGame("Wrong move number perfect information", true, false, true);
+  desyncGame("Wrong move number app acks", true, false, false, true);
+  desyncGame("Wrong hash normal", false, false, false);
+  desyncGame("Wrong hash piggyback", false, true, false);
+  desyncGame("Wrong hash perfect information", false, false, true);
+  desyncGame("Wrong hash app acks", false, false, false, true);
+  Serial.println("Time to resume after a reset");
+  resetGame("Normal", false, false);
+  resetGame("Piggyback", true, false);
+  resetGame("Perfect information", false, true);
+  resetGame("App acks", false, false, true);
+}
+
+void loop() {
+}
@@ -0,0 +1,209 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility measures the speed and reliability of a radio link through the baseRadio
+ * interface. Unlike Demo_TX and Demo_RX which talk to RadioHead directly, it tests exactly
+ * what the game engine uses.
+ *
+ * Upload it to two devices, one with IS_PLAYER_1 true and one with it false. Player 1 is the
+ * "initiator". It sends echo requests and player 2, the "reflector", sends them straight back.
+ * For every modulation setting the radio supports, both with and without link-level
+ * acknowledgments, and for payload sizes from 4 bytes up to MAX_LEGAL_PACKET_SIZE, the
+ * initiator sends TRIALS echo requests. It prints one line for each combination with the
+ * fraction of echoes that never came back, the 50th and 99th percentile round trip times
+ * in microseconds, the goodput in payload bytes per second counting both directions, and
+ * the number of link-level retries. Results are printed on the serial monitor of player 1.
+ *
+ * Before changing modulation, the initiator tells the reflector with an acknowledged packet
+ * and then both switch. If that packet is lost the two devices can no longer hear each other
+ * so the initiator just goes on to the next setting and you will see 100% loss.
+ *
+ * Set USE_LOOPBACK to 1 to run both ends in a single program using LoopbackRadio. No radio is
+ * needed so it runs on any board or in a desktop Arduino emulation. That is handy for checking
+ * this utility itself. LOOPBACK_DROP percent of unacknowledged packets are thrown away so that
+ * the loss columns have something to show.
+ */
+#include <TwoPlayerGame.h>
+
+#define USE_LOOPBACK 0
+
+#if(USE_LOOPBACK)
+  #include <TwoPlayerGame_loopback.h>
+  #define LOOPBACK_DROP 5
+  #define ECHO_TIMEOUT 20     //milliseconds to wait for each echo
+  loopbackLink Link;
+  LoopbackRadio Radio(&Link);
+  LoopbackRadio Reflector(&Link);
+  #define IS_PLAYER_1 true
+#else
+  #include <TwoPlayerGame_RF69HCW.h>
+  #define ECHO_TIMEOUT 500
+  RF69Radio Radio;
+  #define IS_PLAYER_1 true    //change to false on the reflecting device
+#endif
+
+//Number of echo requests for each combination of settings
+#define TRIALS 100
+
+//Commands in the first byte of every packet
+#define ECHO_ACK    'E'   //echo request, reply with send
+#define ECHO_NO_ACK 'e'   //echo request, reply with sendNoAck
+#define MODULATION  'M'   //switch to the modulation in the second byte
+
+uint8_t buf[MAX_LEGAL_PACKET_SIZE];
+uint32_t rtt[TRIALS];
+
+/*
+ * Reflector side. If a packet has arrived, echo it or change modulation as requested.
+ */
+void reflect(baseRadio& R) {
+  uint8_t data[MAX_LEGAL_PACKET_SIZE];
+  uint8_t len=sizeof(data);
+  if(!R.recv(data,&len) || (len<2)) {
+    return;
+  }
+  switch(data[0]) {
+    case ECHO_ACK:    R.send(data,len);      break;
+    case ECHO_NO_ACK: R.sendNoAck(data,len); break;
+    case MODULATION:
+      delay(10);    //give our acknowledgment time to get out using the old setting
+      R.setModulation(data[1]);
+      break;
+  }
+}
+
+/*
+ * In loopback mode nobody else is going to run the reflector so we do it ourselves
+ * every time the initiator waits.
+ */
+void serviceReflector(void) {
+  #if(USE_LOOPBACK)
+    reflect(Reflector);
+  #endif
+}
+
+/*
+ * Sends one echo request with sequence number "seq" and waits for it to come back.
+ * Returns the round trip time in microseconds or zero if it was lost.
+ */
+uint32_t echo(uint8_t len, bool ack, uint16_t seq) {
+  buf[0]= ack ? ECHO_ACK : ECHO_NO_ACK;
+  buf[1]=seq & 0xff; buf[2]=seq >> 8;
+  for(uint8_t i=3;i<len;i++) {
+    buf[i]=i;
+  }
+  uint32_t StartTime=micros();
+  if(!(ack ? Radio.send(buf,len) : Radio.sendNoAck(buf,len))) {
+    return 0;
+  }
+  uint32_t StartMillis=millis();
+  while((millis()-StartMillis) < ECHO_TIMEOUT) {
+    serviceReflector();
+    uint8_t n=sizeof(buf);
+    if(Radio.recv(buf,&n) && (n==len) && (buf[1]==(seq & 0xff)) && (buf[2]==(seq >> 8))) {
+      uint32_t t=micros()-StartTime;
+      return t ? t : 1;
+    }
+  }
+  return 0;   //anything that shows up later has the wrong sequence number and is ignored
+}
+
+/*
+ * Sorts the round trip times so that we can pick out percentiles.
+ */
+void sortRTT(uint16_t n) {
+  for(uint16_t i=1;i<n;i++) {
+    uint32_t t=rtt[i];
+    uint16_t j=i;
+    while(j && (rtt[j-1]>t)) {
+      rtt[j]=rtt[j-1]; j--;
+    }
+    rtt[j]=t;
+  }
+}
+
+/*
+ * Runs TRIALS echoes with one payload size and acknowledgment mode and prints a line of results.
+ */
+void trial(uint8_t len, bool ack) {
+  static uint16_t seq=0;
+  uint16_t good=0;
+  uint32_t retries=Radio.Stats.retries;
+  uint32_t StartTime=micros();
+  for(uint16_t i=0;i<TRIALS;i++) {
+    uint32_t t=echo(len,ack,++seq);
+    if(t) {
+      rtt[good++]=t;
+    }
+  }
+  uint32_t Elapsed=micros()-StartTime;
+  sortRTT(good);
+  Serial.print(ack ? "  ack    " : "  no ack ");
+  Serial.print(" payload="); Serial.print(len);
+  Serial.print("\tloss%="); Serial.print(100.0*(TRIALS-good)/TRIALS);
+  if(good) {
+    Serial.print("\tp50 usec="); Serial.print(rtt[(good-1)/2]);
+    Serial.print("\tp99 usec="); Serial.print(rtt[(good*99-1)/100]);
+  } else {
+    Serial.print("\tp50 usec=-\tp99 usec=-");
+  }
+  Serial.print("\tgoodput bytes/sec="); Serial.print((uint32_t)(2.0*good*len*1000000.0/Elapsed));
+  Serial.print("\tretries="); Serial.println(Radio.Stats.retries-retries);
+}
+
+/*
+ * Asks the reflector to change modulation and then changes our own.
+ */
+bool changeModulation(uint8_t m) {
+  buf[0]=MODULATION; buf[1]=m;
+  bool ok=Radio.send(buf,2);
+  serviceReflector();
+  delay(20);
+  return Radio.setModulation(m) && ok;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) { delay(1); }
+  #if(USE_LOOPBACK)
+    Link.dropPercent=LOOPBACK_DROP;
+    Reflector.setup(2,1);
+  #endif
+  if(!Radio.setup(IS_PLAYER_1 ? 1 : 2, IS_PLAYER_1 ? 2 : 1)) {
+    Serial.println("Radio setup failed");
+    while(1) {};
+  }
+  if(!IS_PLAYER_1) {
+    Serial.println("Radio benchmark reflector running");
+    return;
+  }
+  Serial.println("Radio benchmark");
+  for(uint8_t m=0;m<Radio.modulations();m++) {
+    if(m && !changeModulation(m)) {
+      Serial.println("Reflector did not acknowledge the modulation change");
+    }
+    Serial.print("Modulation "); Serial.println(Radio.modulationName(m));
+    for(uint8_t a=0;a<2;a++) {
+      for(uint8_t len=4;len<MAX_LEGAL_PACKET_SIZE;len*=2) {
+        trial(len,a==0);
+      }
+      trial(MAX_LEGAL_PACKET_SIZE,a==0);
+    }
+  }
+  changeModulation(0);
+  Radio.Stats.print();
+}
+
+void loop() {
+  if(!IS_PLAYER_1) {
+    reflect(Radio);
+  }
+}
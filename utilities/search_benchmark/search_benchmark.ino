@@ -0,0 +1,255 @@
+/*********************************************************
+ *    Two Player Game Engine
+ *      by Chris Young
+ * Allows you to create a two player game using Adafruit PyGamer, PyBadge and other similar
+ * boards connected by a packet radio or other communication systems.
+ * Open source under GPL 3.0. See LICENSE.TXT for details.
+ *
+ * See https://learn.adafruit.com/two-player-game-system-for-pygamer-and-rfm69hcw-radio-wing/
+ * for more information about this project.
+ **********************************************************/
+/*
+ * This utility measures gameSearch from "TwoPlayerGame_search.h" playing Connect Four, a game
+ * with enough positions to keep it busy. It does four jobs:
+ *
+ *    speed       From the empty board, search 9 moves ahead with a small transposition table and
+ *                a large one. Prints the positions visited, the time taken and positions per
+ *                second. The large table visits fewer positions to get there.
+ *    time        From the empty board, search for one second with each table and print how many
+ *                moves ahead it got.
+ *    ponder      Ponder the empty board for one second, 20 milliseconds at a time as idleWork
+ *                would, then think for 20 milliseconds. Prints how far ahead that think got.
+ *    endgame     Play random games until only a few squares are left, then search the rest of
+ *                the game to the end. The same position is also searched by plain alpha-beta
+ *                with no table and no deepening. The two scores and the value of the move chosen
+ *                must all agree. Any disagreement is reported.
+ *
+ * Results are printed on the serial monitor. It runs on any board. No radio wing is needed.
+ */
+#include <TwoPlayerGame.h>
+
+//Number of endgame positions checked and how many empty squares each has left
+#define ENDGAMES 50
+#define ENDGAME_EMPTY 12
+
+/*
+ * A Connect Four position. Each column is 7 bits of a 64-bit mask, the bottom row in the lowest
+ * bit. The seventh bit of each column is always empty so that lines can't wrap from one column
+ * into the next when a mask is shifted. "mine" holds the stones of the player to move and
+ * "filled" every stone.
+ */
+class connectFour {
+  public:
+    typedef uint8_t move_t;   //a column
+    uint64_t mine, filled;
+    uint8_t count;            //stones played
+    zobristHash hash_;
+    void clear(void) {mine=filled=0; count=0; hash_.reset();};
+    uint8_t moves(move_t* list) {
+      if(lost() || (count==42)) {
+        return 0;
+      }
+      static const uint8_t Order[7]= {3,2,4,1,5,0,6};    //middle columns first
+      uint8_t n=0;
+      for(uint8_t i=0;i<7;i++) {
+        if(!(filled & top(Order[i]))) {
+          list[n++]=Order[i];
+        }
+      }
+      return n;
+    };
+    void apply(move_t c) {
+      uint64_t stone= (filled + bottom(c)) & column(c);
+      hash_.toggle((count & 1)*64 + bitNumber(stone));
+      hash_.toggle(128);      //whose turn it is
+      mine ^= filled;         //now the other player's stones
+      filled |= stone;
+      count++;
+    };
+    void undo(move_t c) {
+      uint64_t stones= filled & column(c);
+      uint64_t stone= stones ^ ((stones >> 1) & column(c));   //the top one
+      count--;
+      filled ^= stone;
+      mine ^= filled;
+      hash_.toggle((count & 1)*64 + bitNumber(stone));
+      hash_.toggle(128);
+    };
+    //Middle stones take part in more lines so count for more
+    int16_t evaluate(void) {
+      if(lost()) {
+        return -SEARCH_WIN;
+      }
+      if(count==42) {
+        return 0;
+      }
+      static const int8_t Weight[7]= {1,2,3,4,3,2,1};
+      int16_t s=0;
+      for(uint8_t c=0;c<7;c++) {
+        s+= Weight[c] * (bitCount(mine & column(c)) - bitCount(filled & ~mine & column(c)));
+      }
+      return s;
+    };
+    uint32_t hash(void) {return hash_.value;};
+  private:
+    //Did the player who just moved make four in a row?
+    bool lost(void) {
+      uint64_t theirs= filled & ~mine;
+      static const uint8_t Step[4]= {1, 7, 6, 8};  //up, across and both diagonals
+      for(uint8_t i=0;i<4;i++) {
+        uint64_t pairs= theirs & (theirs >> Step[i]);
+        if(pairs & (pairs >> (2*Step[i]))) {
+          return true;
+        }
+      }
+      return false;
+    };
+    static uint64_t column(uint8_t c) {return 0x3FULL << (7*c);};
+    static uint64_t bottom(uint8_t c) {return 1ULL << (7*c);};
+    static uint64_t top(uint8_t c) {return 1ULL << (7*c+5);};
+    static uint8_t bitNumber(uint64_t b) {
+      uint8_t n=0;
+      while(!(b & 1)) {
+        b >>= 1; n++;
+      }
+      return n;
+    };
+    static int8_t bitCount(uint64_t b) {
+      int8_t n=0;
+      for(;b;b &= b-1) {
+        n++;
+      }
+      return n;
+    };
+};
+
+gameSearch<connectFour, 64, 42, 7> SmallSearch;
+gameSearch<connectFour, 4096, 42, 7> LargeSearch;
+connectFour Position;
+uint32_t Disagree;
+
+/*
+ * Plain alpha-beta to the end of the game to check the answers against. Scores the same way as
+ * gameSearch does.
+ */
+int16_t plainSearch(connectFour& p, int16_t alpha, int16_t beta, uint8_t ply) {
+  uint8_t moves[7];
+  uint8_t n=p.moves(moves);
+  if(n==0) {
+    int16_t s=p.evaluate();
+    return (s>=SEARCH_WIN) ? s-ply : (s<=-SEARCH_WIN) ? s+ply : s;
+  }
+  int16_t best=-SEARCH_INFINITY;
+  for(uint8_t i=0;i<n;i++) {
+    p.apply(moves[i]);
+    int16_t s=-plainSearch(p, -beta, -alpha, ply+1);
+    p.undo(moves[i]);
+    if(s>best) {
+      best=s;
+    }
+    if(s>alpha) {
+      alpha=s;
+    }
+    if(alpha>=beta) {
+      break;
+    }
+  }
+  return best;
+}
+
+/*
+ * Prints one line of results for a search
+ */
+template<class S> void report(const char* name, S& search, uint32_t ms) {
+  Serial.print("  "); Serial.print(name);
+  Serial.print(" depth="); Serial.print(search.depth);
+  Serial.print("  nodes="); Serial.print(search.nodes);
+  Serial.print("  msec="); Serial.print(ms);
+  Serial.print("  nodes/sec="); Serial.println(ms ? search.nodes*1000.0/ms : 0.0);
+}
+
+template<class S> void speed(const char* name, S& search) {
+  Position.clear(); search.clear();
+  uint32_t StartTime=millis();
+  search.think(Position, 60000, 9);
+  report(name, search, millis()-StartTime);
+}
+
+template<class S> void timed(const char* name, S& search) {
+  Position.clear(); search.clear();
+  uint32_t StartTime=millis();
+  search.think(Position, 1000);
+  report(name, search, millis()-StartTime);
+}
+
+/*
+ * Plays random moves until ENDGAME_EMPTY squares are left. Starts again if the game ends first.
+ */
+void randomEndgame(void) {
+  uint8_t moves[7];
+  do {
+    Position.clear();
+    uint8_t n;
+    while((Position.count<42-ENDGAME_EMPTY) && (n=Position.moves(moves))) {
+      Position.apply(moves[random(n)]);
+    }
+  } while(Position.moves(moves)==0);
+}
+
+void endgames(void) {
+  uint32_t nodes=0, StartTime=millis();
+  for(uint8_t i=0;i<ENDGAMES;i++) {
+    randomEndgame();
+    LargeSearch.clear();
+    uint64_t mine=Position.mine, filled=Position.filled;
+    uint32_t hash=Position.hash();
+    uint8_t move=LargeSearch.think(Position, 60000, ENDGAME_EMPTY);
+    nodes+=LargeSearch.nodes;
+    int16_t plain=plainSearch(Position, -SEARCH_INFINITY, SEARCH_INFINITY, 0);
+    Position.apply(move);
+    int16_t chosen=-plainSearch(Position, -SEARCH_INFINITY, SEARCH_INFINITY, 1);
+    Position.undo(move);
+    if((LargeSearch.score!=plain) || (chosen!=plain) || (LargeSearch.depth>ENDGAME_EMPTY)
+        || (Position.mine!=mine) || (Position.filled!=filled) || (Position.hash()!=hash)) {
+      Serial.printf("  endgame %d search=%d plain=%d chosen=%d depth=%d\n", i, LargeSearch.score,
+          plain, chosen, LargeSearch.depth);
+      Disagree++;
+    }
+  }
+  Serial.print("  endgame   positions="); Serial.print(ENDGAMES);
+  Serial.print("  nodes each="); Serial.print(nodes/ENDGAMES);
+  Serial.print("  msec each="); Serial.println((millis()-StartTime)/(float)ENDGAMES);
+}
+
+void setup() {
+  Serial.begin(115200); while (!Serial) {delay(1);};
+  Serial.println("Search benchmark");
+  Serial.print("Bytes of search small="); Serial.print(sizeof(SmallSearch));
+  Serial.print("  large="); Serial.println(sizeof(LargeSearch));
+  randomSeed(analogRead(0));
+  Disagree=0;
+  speed("speed small", SmallSearch);
+  speed("speed large", LargeSearch);
+  timed("time  small", SmallSearch);
+  timed("time  large", LargeSearch);
+
+  Position.clear(); LargeSearch.clear();
+  for(uint8_t i=0;i<50;i++) {
+    LargeSearch.ponder(Position, 20);
+  }
+  Serial.print("  ponder    pondered depth="); Serial.print(LargeSearch.depth);
+  uint32_t StartTime=millis();
+  LargeSearch.think(Position, 20);
+  Serial.print("  then think depth="); Serial.print(LargeSearch.depth);
+  Serial.print(" in msec="); Serial.println(millis()-StartTime);
+
+  endgames();
+  if(Disagree) {
+    Serial.print("The searches disagreed "); Serial.print(Disagree); Serial.println(" times!");
+  } else {
+    Serial.println("The searches always agreed.");
+  }
+}
+
+void loop() {
+}